@@ -336,6 +336,33 @@ enum ETrackedPropertyError
 	TrackedProp_PermissionDenied			= 10,
 };
 
+/** Identifies the value type of a property in a batch property query */
+typedef uint32_t PropertyTypeTag_t;
+static const PropertyTypeTag_t k_unInvalidPropertyTag = 0;
+static const PropertyTypeTag_t k_unFloatPropertyTag = 1;
+static const PropertyTypeTag_t k_unInt32PropertyTag = 2;
+static const PropertyTypeTag_t k_unUint64PropertyTag = 3;
+static const PropertyTypeTag_t k_unBoolPropertyTag = 4;
+static const PropertyTypeTag_t k_unStringPropertyTag = 5;
+static const PropertyTypeTag_t k_unHmdMatrix34PropertyTag = 20;
+
+/** One property to read in a batch property query */
+struct TrackedPropertyRequest_t
+{
+	TrackedDeviceIndex_t unDeviceIndex;
+	ETrackedDeviceProperty prop;
+	PropertyTypeTag_t unTag;
+};
+
+/** The result of one property in a batch property query. The value is unSize bytes at unOffset
+* into the value buffer. For strings unSize includes the terminator. */
+struct TrackedPropertyResult_t
+{
+	ETrackedPropertyError eError;
+	uint32_t unOffset;
+	uint32_t unSize;
+};
+
 /** Allows the application to control what part of the provided texture will be used in the
 * frame buffer. */
 struct VRTextureBounds_t
@@ -3307,6 +3334,37 @@ namespace vr
 	/** Returns a token that represents whether the VR interface handles need to be reloaded */
 	VR_INTERFACE uint32_t VR_CALLTYPE VR_GetInitToken();
 
+	// ---------------  Cached tracked device properties --------------- //
+
+	/** These have the same contract as the IVRSystem property getters, but answer repeat reads from a
+	* client side cache without a call into the runtime or any locking. Pass every event from
+	* PollNextEvent to VR_UpdateTrackedDevicePropertyCache so device activation, deactivation, update
+	* and role changes drop the affected device's cached values. Strings longer than 255 characters and
+	* errors that may change on the next call (e.g. TrackedProp_NotYetAvailable) are never cached.
+	* These must be called between VR_Init and VR_Shutdown. */
+	VR_INTERFACE bool VR_CALLTYPE VR_GetCachedBoolTrackedDeviceProperty( TrackedDeviceIndex_t unDeviceIndex, ETrackedDeviceProperty prop, ETrackedPropertyError *pError );
+	VR_INTERFACE float VR_CALLTYPE VR_GetCachedFloatTrackedDeviceProperty( TrackedDeviceIndex_t unDeviceIndex, ETrackedDeviceProperty prop, ETrackedPropertyError *pError );
+	VR_INTERFACE int32_t VR_CALLTYPE VR_GetCachedInt32TrackedDeviceProperty( TrackedDeviceIndex_t unDeviceIndex, ETrackedDeviceProperty prop, ETrackedPropertyError *pError );
+	VR_INTERFACE uint64_t VR_CALLTYPE VR_GetCachedUint64TrackedDeviceProperty( TrackedDeviceIndex_t unDeviceIndex, ETrackedDeviceProperty prop, ETrackedPropertyError *pError );
+	VR_INTERFACE HmdMatrix34_t VR_CALLTYPE VR_GetCachedMatrix34TrackedDeviceProperty( TrackedDeviceIndex_t unDeviceIndex, ETrackedDeviceProperty prop, ETrackedPropertyError *pError );
+	VR_INTERFACE uint32_t VR_CALLTYPE VR_GetCachedStringTrackedDeviceProperty( TrackedDeviceIndex_t unDeviceIndex, ETrackedDeviceProperty prop, char *pchValue, uint32_t unBufferSize, ETrackedPropertyError *pError );
+
+	/** Updates the property cache for an event. Returns true if the event invalidated anything. */
+	VR_INTERFACE bool VR_CALLTYPE VR_UpdateTrackedDevicePropertyCache( const VREvent_t *pEvent );
+
+	/** Drops everything cached for a device, or for every device if unDeviceIndex is k_unTrackedDeviceIndexInvalid */
+	VR_INTERFACE void VR_CALLTYPE VR_InvalidateTrackedDevicePropertyCache( TrackedDeviceIndex_t unDeviceIndex );
+
+	/** Reads any number of properties, from one or many devices, in one call. Values are packed into
+	* pValueBuffer at naturally aligned offsets, with the offset, size and error of each request written
+	* to the matching entry of pResults. Values go through the property cache.
+	*
+	* Returns the number of bytes of value buffer the whole batch needs. If that is more than
+	* unValueBufferSize, the values that didn't fit report TrackedProp_BufferTooSmall and the call
+	* can be repeated with a buffer of the returned size. */
+	VR_INTERFACE uint32_t VR_CALLTYPE VR_GetTrackedDevicePropertiesBatch( const TrackedPropertyRequest_t *pRequests, uint32_t unRequestCount,
+		TrackedPropertyResult_t *pResults, void *pValueBuffer, uint32_t unValueBufferSize );
+
 	// These typedefs allow old enum names from SDK 0.9.11 to be used in applications.
 	// They will go away in the future.
 	typedef EVRInitError HmdError;
@@ -2973,6 +2973,24 @@ public class OpenVRInterop
 	internal static extern bool IsInterfaceVersionValid([In, MarshalAs(UnmanagedType.LPStr)] string pchInterfaceVersion);
 	[DllImportAttribute("openvr_api", EntryPoint = "VR_GetInitToken", CallingConvention = CallingConvention.Cdecl)]
 	internal static extern uint GetInitToken();
+	[DllImportAttribute("openvr_api", EntryPoint = "VR_GetCachedBoolTrackedDeviceProperty", CallingConvention = CallingConvention.Cdecl)]
+	internal static extern bool GetCachedBoolTrackedDeviceProperty(uint unDeviceIndex, ETrackedDeviceProperty prop, ref ETrackedPropertyError pError);
+	[DllImportAttribute("openvr_api", EntryPoint = "VR_GetCachedFloatTrackedDeviceProperty", CallingConvention = CallingConvention.Cdecl)]
+	internal static extern float GetCachedFloatTrackedDeviceProperty(uint unDeviceIndex, ETrackedDeviceProperty prop, ref ETrackedPropertyError pError);
+	[DllImportAttribute("openvr_api", EntryPoint = "VR_GetCachedInt32TrackedDeviceProperty", CallingConvention = CallingConvention.Cdecl)]
+	internal static extern int GetCachedInt32TrackedDeviceProperty(uint unDeviceIndex, ETrackedDeviceProperty prop, ref ETrackedPropertyError pError);
+	[DllImportAttribute("openvr_api", EntryPoint = "VR_GetCachedUint64TrackedDeviceProperty", CallingConvention = CallingConvention.Cdecl)]
+	internal static extern ulong GetCachedUint64TrackedDeviceProperty(uint unDeviceIndex, ETrackedDeviceProperty prop, ref ETrackedPropertyError pError);
+	[DllImportAttribute("openvr_api", EntryPoint = "VR_GetCachedMatrix34TrackedDeviceProperty", CallingConvention = CallingConvention.Cdecl)]
+	internal static extern HmdMatrix34_t GetCachedMatrix34TrackedDeviceProperty(uint unDeviceIndex, ETrackedDeviceProperty prop, ref ETrackedPropertyError pError);
+	[DllImportAttribute("openvr_api", EntryPoint = "VR_GetCachedStringTrackedDeviceProperty", CallingConvention = CallingConvention.Cdecl)]
+	internal static extern uint GetCachedStringTrackedDeviceProperty(uint unDeviceIndex, ETrackedDeviceProperty prop, System.Text.StringBuilder pchValue, uint unBufferSize, ref ETrackedPropertyError pError);
+	[DllImportAttribute("openvr_api", EntryPoint = "VR_UpdateTrackedDevicePropertyCache", CallingConvention = CallingConvention.Cdecl)]
+	internal static extern bool UpdateTrackedDevicePropertyCache(ref VREvent_t pEvent);
+	[DllImportAttribute("openvr_api", EntryPoint = "VR_InvalidateTrackedDevicePropertyCache", CallingConvention = CallingConvention.Cdecl)]
+	internal static extern void InvalidateTrackedDevicePropertyCache(uint unDeviceIndex);
+	[DllImportAttribute("openvr_api", EntryPoint = "VR_GetTrackedDevicePropertiesBatch", CallingConvention = CallingConvention.Cdecl)]
+	internal static extern uint GetTrackedDevicePropertiesBatch([In] TrackedPropertyRequest_t[] pRequests, uint unRequestCount, [In, Out] TrackedPropertyResult_t[] pResults, IntPtr pValueBuffer, uint unValueBufferSize);
 }
 
 
@@ -3843,6 +3861,18 @@ public enum EVRScreenshotError
 	[MarshalAs(UnmanagedType.I1)]
 	public bool bDeviceIsConnected;
 }
+[StructLayout(LayoutKind.Sequential)] public struct TrackedPropertyRequest_t
+{
+	public uint unDeviceIndex;
+	public ETrackedDeviceProperty prop;
+	public uint unTag;
+}
+[StructLayout(LayoutKind.Sequential)] public struct TrackedPropertyResult_t
+{
+	public ETrackedPropertyError eError;
+	public uint unOffset;
+	public uint unSize;
+}
 [StructLayout(LayoutKind.Sequential)] public struct VRTextureBounds_t
 {
 	public float uMin;
@@ -4195,12 +4225,64 @@ public class OpenVR
 		return OpenVRInterop.GetInitToken();
 	}
 
+	public static bool GetCachedBoolTrackedDeviceProperty(uint unDeviceIndex, ETrackedDeviceProperty prop, ref ETrackedPropertyError pError)
+	{
+		return OpenVRInterop.GetCachedBoolTrackedDeviceProperty(unDeviceIndex, prop, ref pError);
+	}
+
+	public static float GetCachedFloatTrackedDeviceProperty(uint unDeviceIndex, ETrackedDeviceProperty prop, ref ETrackedPropertyError pError)
+	{
+		return OpenVRInterop.GetCachedFloatTrackedDeviceProperty(unDeviceIndex, prop, ref pError);
+	}
+
+	public static int GetCachedInt32TrackedDeviceProperty(uint unDeviceIndex, ETrackedDeviceProperty prop, ref ETrackedPropertyError pError)
+	{
+		return OpenVRInterop.GetCachedInt32TrackedDeviceProperty(unDeviceIndex, prop, ref pError);
+	}
+
+	public static ulong GetCachedUint64TrackedDeviceProperty(uint unDeviceIndex, ETrackedDeviceProperty prop, ref ETrackedPropertyError pError)
+	{
+		return OpenVRInterop.GetCachedUint64TrackedDeviceProperty(unDeviceIndex, prop, ref pError);
+	}
+
+	public static HmdMatrix34_t GetCachedMatrix34TrackedDeviceProperty(uint unDeviceIndex, ETrackedDeviceProperty prop, ref ETrackedPropertyError pError)
+	{
+		return OpenVRInterop.GetCachedMatrix34TrackedDeviceProperty(unDeviceIndex, prop, ref pError);
+	}
+
+	public static uint GetCachedStringTrackedDeviceProperty(uint unDeviceIndex, ETrackedDeviceProperty prop, System.Text.StringBuilder pchValue, uint unBufferSize, ref ETrackedPropertyError pError)
+	{
+		return OpenVRInterop.GetCachedStringTrackedDeviceProperty(unDeviceIndex, prop, pchValue, unBufferSize, ref pError);
+	}
+
+	public static bool UpdateTrackedDevicePropertyCache(ref VREvent_t pEvent)
+	{
+		return OpenVRInterop.UpdateTrackedDevicePropertyCache(ref pEvent);
+	}
+
+	public static void InvalidateTrackedDevicePropertyCache(uint unDeviceIndex)
+	{
+		OpenVRInterop.InvalidateTrackedDevicePropertyCache(unDeviceIndex);
+	}
+
+	public static uint GetTrackedDevicePropertiesBatch(TrackedPropertyRequest_t [] pRequests, TrackedPropertyResult_t [] pResults, IntPtr pValueBuffer, uint unValueBufferSize)
+	{
+		return OpenVRInterop.GetTrackedDevicePropertiesBatch(pRequests, (uint) pRequests.Length, pResults, pValueBuffer, unValueBufferSize);
+	}
+
 	public const uint k_unMaxDriverDebugResponseSize = 32768;
 	public const uint k_unTrackedDeviceIndex_Hmd = 0;
 	public const uint k_unMaxTrackedDeviceCount = 16;
 	public const uint k_unTrackedDeviceIndexOther = 4294967294;
 	public const uint k_unTrackedDeviceIndexInvalid = 4294967295;
 	public const uint k_unMaxPropertyStringSize = 32768;
+	public const uint k_unInvalidPropertyTag = 0;
+	public const uint k_unFloatPropertyTag = 1;
+	public const uint k_unInt32PropertyTag = 2;
+	public const uint k_unUint64PropertyTag = 3;
+	public const uint k_unBoolPropertyTag = 4;
+	public const uint k_unStringPropertyTag = 5;
+	public const uint k_unHmdMatrix34PropertyTag = 20;
 	public const uint k_unControllerStateAxisCount = 5;
 	public const ulong k_ulOverlayHandleInvalid = 0;
 	public const uint k_unScreenshotHandleInvalid = 0;
@@ -59,6 +59,13 @@ static const unsigned int k_unMaxTrackedDeviceCount = 16;
 static const unsigned int k_unTrackedDeviceIndexOther = 4294967294;
 static const unsigned int k_unTrackedDeviceIndexInvalid = 4294967295;
 static const unsigned int k_unMaxPropertyStringSize = 32768;
+static const unsigned int k_unInvalidPropertyTag = 0;
+static const unsigned int k_unFloatPropertyTag = 1;
+static const unsigned int k_unInt32PropertyTag = 2;
+static const unsigned int k_unUint64PropertyTag = 3;
+static const unsigned int k_unBoolPropertyTag = 4;
+static const unsigned int k_unStringPropertyTag = 5;
+static const unsigned int k_unHmdMatrix34PropertyTag = 20;
 static const unsigned int k_unControllerStateAxisCount = 5;
 static const unsigned long k_ulOverlayHandleInvalid = 0;
 static const unsigned int k_unScreenshotHandleInvalid = 0;
@@ -993,6 +1000,7 @@ typedef enum EVRScreenshotError
 
 typedef uint32_t TrackedDeviceIndex_t;
 typedef uint32_t VRNotificationId;
+typedef uint32_t PropertyTypeTag_t;
 typedef uint64_t VROverlayHandle_t;
 typedef void * glSharedTextureHandle_t;
 typedef int32_t glInt_t;
@@ -1104,6 +1112,20 @@ typedef struct TrackedDevicePose_t
 	bool bDeviceIsConnected;
 } TrackedDevicePose_t;
 
+typedef struct TrackedPropertyRequest_t
+{
+	TrackedDeviceIndex_t unDeviceIndex;
+	enum ETrackedDeviceProperty prop;
+	PropertyTypeTag_t unTag;
+} TrackedPropertyRequest_t;
+
+typedef struct TrackedPropertyResult_t
+{
+	enum ETrackedPropertyError eError;
+	uint32_t unOffset;
+	uint32_t unSize;
+} TrackedPropertyResult_t;
+
 typedef struct VRTextureBounds_t
 {
 	float uMin;
@@ -1811,6 +1833,17 @@ S_API const char * VR_GetVRInitErrorAsSymbol( EVRInitError error );
 S_API const char * VR_GetVRInitErrorAsEnglishDescription( EVRInitError error );
 #endif
 
+// Cached tracked device properties, see openvr.h
+S_API bool VR_GetCachedBoolTrackedDeviceProperty( TrackedDeviceIndex_t unDeviceIndex, ETrackedDeviceProperty prop, ETrackedPropertyError * pError );
+S_API float VR_GetCachedFloatTrackedDeviceProperty( TrackedDeviceIndex_t unDeviceIndex, ETrackedDeviceProperty prop, ETrackedPropertyError * pError );
+S_API int32_t VR_GetCachedInt32TrackedDeviceProperty( TrackedDeviceIndex_t unDeviceIndex, ETrackedDeviceProperty prop, ETrackedPropertyError * pError );
+S_API uint64_t VR_GetCachedUint64TrackedDeviceProperty( TrackedDeviceIndex_t unDeviceIndex, ETrackedDeviceProperty prop, ETrackedPropertyError * pError );
+S_API struct HmdMatrix34_t VR_GetCachedMatrix34TrackedDeviceProperty( TrackedDeviceIndex_t unDeviceIndex, ETrackedDeviceProperty prop, ETrackedPropertyError * pError );
+S_API uint32_t VR_GetCachedStringTrackedDeviceProperty( TrackedDeviceIndex_t unDeviceIndex, ETrackedDeviceProperty prop, char * pchValue, uint32_t unBufferSize, ETrackedPropertyError * pError );
+S_API bool VR_UpdateTrackedDevicePropertyCache( const struct VREvent_t * pEvent );
+S_API void VR_InvalidateTrackedDevicePropertyCache( TrackedDeviceIndex_t unDeviceIndex );
+S_API uint32_t VR_GetTrackedDevicePropertiesBatch( const struct TrackedPropertyRequest_t * pRequests, uint32_t unRequestCount, struct TrackedPropertyResult_t * pResults, void * pValueBuffer, uint32_t unValueBufferSize );
+
 #endif // __OPENVR_API_FLAT_H__
 
 
@@ -0,0 +1,19 @@
+//========= Copyright Valve Corporation ============//
+// openvr_clock.h
+//
+// The monotonic clock the header-only helpers timestamp with. Times from
+// different helpers can be compared with each other.
+#pragma once
+
+#include <chrono>
+
+namespace vr
+{
+
+/** Seconds on the steady clock. Only differences are meaningful. */
+inline double GetMonotonicSeconds()
+{
+	return std::chrono::duration< double >( std::chrono::steady_clock::now().time_since_epoch() ).count();
+}
+
+} // namespace vr
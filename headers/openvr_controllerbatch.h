@@ -0,0 +1,97 @@
+//========= Copyright Valve Corporation ============//
+// openvr_controllerbatch.h
+//
+// Header-only batched controller input. Reads the state, and optionally the
+// pose, of every controller in a device mask in one call into arrays indexed
+// by device, and reports which devices produced a new input packet since the
+// previous update so input code can skip the ones that haven't changed.
+#pragma once
+
+#include "openvr.h"
+
+#include <string.h>
+
+namespace vr
+{
+
+/** Controller state for every device slot. Masks have bit n set for device n. */
+struct VRControllerStateBatch_t
+{
+	VRControllerState_t rState[ k_unMaxTrackedDeviceCount ];
+
+	/** Only filled by ControllerBatch_UpdateWithPose */
+	TrackedDevicePose_t rPose[ k_unMaxTrackedDeviceCount ];
+
+	/** Devices that returned a state in the last update */
+	uint64_t validMask;
+
+	/** Devices whose unPacketNum changed in the last update, or that became valid or invalid */
+	uint64_t changedMask;
+};
+
+/** Clears a batch so the first update reports every valid device as changed */
+inline void ControllerBatch_Init( VRControllerStateBatch_t *pBatch )
+{
+	memset( pBatch, 0, sizeof( *pBatch ) );
+}
+
+namespace controllerbatch_internal
+{
+	/** Bookkeeping shared by both update flavors once a device has been read */
+	inline void UpdateMasks( VRControllerStateBatch_t *pBatch, uint32_t unDevice, bool bValid, uint32_t unPreviousPacketNum, uint64_t *pValidMask, uint64_t *pChangedMask )
+	{
+		uint64_t bit = (uint64_t)1 << unDevice;
+		bool bWasValid = ( pBatch->validMask & bit ) != 0;
+		if ( bValid )
+		{
+			*pValidMask |= bit;
+			if ( !bWasValid || pBatch->rState[ unDevice ].unPacketNum != unPreviousPacketNum )
+				*pChangedMask |= bit;
+		}
+		else if ( bWasValid )
+		{
+			*pChangedMask |= bit;
+		}
+	}
+}
+
+/** Reads the state of every controller in deviceMask (e.g. the controller and generic tracker masks
+* from openvr_devicetopology.h). Devices outside the mask are left untouched and reported invalid.
+* Returns the changed mask. */
+inline uint64_t ControllerBatch_Update( IVRSystem *pSystem, uint64_t deviceMask, VRControllerStateBatch_t *pBatch )
+{
+	uint64_t validMask = 0, changedMask = 0;
+	for ( uint32_t i = 0; i < k_unMaxTrackedDeviceCount; i++ )
+	{
+		bool bValid = false;
+		uint32_t unPreviousPacketNum = pBatch->rState[i].unPacketNum;
+		if ( deviceMask & ( (uint64_t)1 << i ) )
+			bValid = pSystem->GetControllerState( i, &pBatch->rState[i], sizeof( VRControllerState_t ) );
+		controllerbatch_internal::UpdateMasks( pBatch, i, bValid, unPreviousPacketNum, &validMask, &changedMask );
+	}
+
+	pBatch->validMask = validMask;
+	pBatch->changedMask = changedMask;
+	return changedMask;
+}
+
+/** Like ControllerBatch_Update, but also fills rPose with the pose each device had when its state
+* was sampled */
+inline uint64_t ControllerBatch_UpdateWithPose( IVRSystem *pSystem, ETrackingUniverseOrigin eOrigin, uint64_t deviceMask, VRControllerStateBatch_t *pBatch )
+{
+	uint64_t validMask = 0, changedMask = 0;
+	for ( uint32_t i = 0; i < k_unMaxTrackedDeviceCount; i++ )
+	{
+		bool bValid = false;
+		uint32_t unPreviousPacketNum = pBatch->rState[i].unPacketNum;
+		if ( deviceMask & ( (uint64_t)1 << i ) )
+			bValid = pSystem->GetControllerStateWithPose( eOrigin, i, &pBatch->rState[i], sizeof( VRControllerState_t ), &pBatch->rPose[i] );
+		controllerbatch_internal::UpdateMasks( pBatch, i, bValid, unPreviousPacketNum, &validMask, &changedMask );
+	}
+
+	pBatch->validMask = validMask;
+	pBatch->changedMask = changedMask;
+	return changedMask;
+}
+
+} // namespace vr
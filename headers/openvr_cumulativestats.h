@@ -0,0 +1,206 @@
+//========= Copyright Valve Corporation ============//
+// openvr_cumulativestats.h
+//
+// Header-only tracker that turns IVRCompositor::GetCumulativeStats, which only
+// ever counts up from the moment the app connected, into per-interval deltas.
+// Intervals are tagged with an application defined phase (a level, a scene,
+// a benchmark section), so dropped and reprojected frames can be attributed
+// to the content that caused them.
+#pragma once
+
+#include "openvr.h"
+#include "openvr_clock.h"
+
+#include <string.h>
+
+namespace vr
+{
+
+/** Counters accumulated over an interval or a phase. m_nPid is the process the counters came from. */
+typedef Compositor_CumulativeStats VRCumulativeStatsDelta_t;
+
+struct VRCumulativeStatsInterval_t
+{
+	uint32_t unPhase;
+	double flStartSeconds;
+	double flEndSeconds;
+	VRCumulativeStatsDelta_t delta;
+};
+
+struct VRCumulativeStatsPhaseTotals_t
+{
+	double flSeconds;
+	uint32_t unIntervals;
+	VRCumulativeStatsDelta_t delta;
+};
+
+/** Dropped frames per present, 0 if nothing was presented */
+inline float VRCumulativeStats_GetDroppedRate( const VRCumulativeStatsDelta_t &delta )
+{
+	return delta.m_nNumFramePresents ? (float)delta.m_nNumDroppedFrames / delta.m_nNumFramePresents : 0.f;
+}
+
+/** Reprojected frames per present, 0 if nothing was presented */
+inline float VRCumulativeStats_GetReprojectedRate( const VRCumulativeStatsDelta_t &delta )
+{
+	return delta.m_nNumFramePresents ? (float)delta.m_nNumReprojectedFrames / delta.m_nNumFramePresents : 0.f;
+}
+
+namespace cumulativestats_internal
+{
+	// every field after m_nPid is a uint32_t counter
+	static const uint32_t k_unCounterCount = sizeof( Compositor_CumulativeStats ) / sizeof( uint32_t ) - 1;
+	static_assert( sizeof( Compositor_CumulativeStats ) == ( k_unCounterCount + 1 ) * sizeof( uint32_t ), "Compositor_CumulativeStats is expected to hold only uint32_t fields" );
+
+	inline const uint32_t *GetCounters( const Compositor_CumulativeStats &stats ) { return &stats.m_nPid + 1; }
+	inline uint32_t *GetCounters( Compositor_CumulativeStats &stats ) { return &stats.m_nPid + 1; }
+}
+
+/** Not thread safe; sample and query it from one thread or lock around it. */
+class CVRCumulativeStatsTracker
+{
+public:
+	static const uint32_t k_unMaxPhases = 64;
+	static const uint32_t k_unMaxPhaseNameLength = 64;
+	static const uint32_t k_unIntervalHistory = 256;
+
+	/** Update() samples at most every flSampleIntervalSeconds. Phase 0 is "default" until SetPhase is called. */
+	explicit CVRCumulativeStatsTracker( double flSampleIntervalSeconds = 1.0 )
+		: m_flSampleInterval( flSampleIntervalSeconds )
+	{
+		Reset();
+	}
+
+	/** Forgets every phase and interval */
+	void Reset()
+	{
+		memset( m_rPhases, 0, sizeof( m_rPhases ) );
+		strcpy( m_rPhases[0].rchName, "default" );
+		m_unPhaseCount = 1;
+		m_unCurrentPhase = 0;
+		m_unIntervalCount = 0;
+		m_bHaveSample = false;
+		memset( &m_lastSample, 0, sizeof( m_lastSample ) );
+		m_flLastSampleSeconds = 0.0;
+	}
+
+	/** Closes the interval since the previous sample and attributes it to the current phase. The first
+	* sample, and the first after the stats start coming from a different process, only sets the baseline. */
+	void AddSample( const Compositor_CumulativeStats &stats, double flNowSeconds )
+	{
+		if ( m_bHaveSample && stats.m_nPid == m_lastSample.m_nPid )
+		{
+			VRCumulativeStatsInterval_t &interval = m_rIntervals[ m_unIntervalCount % k_unIntervalHistory ];
+			interval.unPhase = m_unCurrentPhase;
+			interval.flStartSeconds = m_flLastSampleSeconds;
+			interval.flEndSeconds = flNowSeconds;
+			interval.delta.m_nPid = stats.m_nPid;
+
+			Phase_t &phase = m_rPhases[ m_unCurrentPhase ];
+			phase.totals.delta.m_nPid = stats.m_nPid;
+			phase.totals.flSeconds += flNowSeconds - m_flLastSampleSeconds;
+			phase.totals.unIntervals++;
+
+			const uint32_t *punCurrent = cumulativestats_internal::GetCounters( stats );
+			const uint32_t *punLast = cumulativestats_internal::GetCounters( m_lastSample );
+			uint32_t *punDelta = cumulativestats_internal::GetCounters( interval.delta );
+			uint32_t *punTotal = cumulativestats_internal::GetCounters( phase.totals.delta );
+			for ( uint32_t i = 0; i < cumulativestats_internal::k_unCounterCount; i++ )
+			{
+				punDelta[i] = punCurrent[i] - punLast[i];
+				punTotal[i] += punDelta[i];
+			}
+			m_unIntervalCount++;
+		}
+
+		m_bHaveSample = true;
+		m_lastSample = stats;
+		m_flLastSampleSeconds = flNowSeconds;
+	}
+
+	/** Samples, so everything up to now goes to the outgoing phase, then switches phase. Phases with the
+	* same name share totals. Returns the phase id, or the current one if k_unMaxPhases are in use. */
+	uint32_t SetPhase( const char *pchPhase, const Compositor_CumulativeStats &stats, double flNowSeconds )
+	{
+		AddSample( stats, flNowSeconds );
+		m_unCurrentPhase = FindOrAddPhase( pchPhase );
+		return m_unCurrentPhase;
+	}
+
+	uint32_t SetPhase( IVRCompositor *pCompositor, const char *pchPhase )
+	{
+		Compositor_CumulativeStats stats;
+		pCompositor->GetCumulativeStats( &stats, sizeof( stats ) );
+		return SetPhase( pchPhase, stats, GetMonotonicSeconds() );
+	}
+
+	/** Samples the compositor if the sample interval has passed. Returns true if it sampled. */
+	bool Update( IVRCompositor *pCompositor )
+	{
+		double flNow = GetMonotonicSeconds();
+		if ( m_bHaveSample && flNow - m_flLastSampleSeconds < m_flSampleInterval )
+			return false;
+
+		Compositor_CumulativeStats stats;
+		pCompositor->GetCumulativeStats( &stats, sizeof( stats ) );
+		AddSample( stats, flNow );
+		return true;
+	}
+
+	uint32_t GetCurrentPhase() const { return m_unCurrentPhase; }
+	uint32_t GetPhaseCount() const { return m_unPhaseCount; }
+	const char *GetPhaseName( uint32_t unPhase ) const { return unPhase < m_unPhaseCount ? m_rPhases[ unPhase ].rchName : ""; }
+
+	/** Everything attributed to a phase so far, or nullptr for an unknown phase */
+	const VRCumulativeStatsPhaseTotals_t *GetPhaseTotals( uint32_t unPhase ) const
+	{
+		return unPhase < m_unPhaseCount ? &m_rPhases[ unPhase ].totals : nullptr;
+	}
+
+	/** Number of intervals that can be read back, at most k_unIntervalHistory */
+	uint32_t GetIntervalCount() const { return m_unIntervalCount < k_unIntervalHistory ? m_unIntervalCount : k_unIntervalHistory; }
+
+	/** unIntervalsAgo 0 is the most recent interval */
+	const VRCumulativeStatsInterval_t *GetInterval( uint32_t unIntervalsAgo ) const
+	{
+		if ( unIntervalsAgo >= GetIntervalCount() )
+			return nullptr;
+		return &m_rIntervals[ ( m_unIntervalCount - 1 - unIntervalsAgo ) % k_unIntervalHistory ];
+	}
+
+private:
+	struct Phase_t
+	{
+		char rchName[ k_unMaxPhaseNameLength ];
+		VRCumulativeStatsPhaseTotals_t totals;
+	};
+
+	uint32_t FindOrAddPhase( const char *pchPhase )
+	{
+		for ( uint32_t i = 0; i < m_unPhaseCount; i++ )
+		{
+			if ( strncmp( m_rPhases[i].rchName, pchPhase, k_unMaxPhaseNameLength - 1 ) == 0 )
+				return i;
+		}
+
+		if ( m_unPhaseCount == k_unMaxPhases )
+			return m_unCurrentPhase;
+
+		strncpy( m_rPhases[ m_unPhaseCount ].rchName, pchPhase, k_unMaxPhaseNameLength - 1 );
+		return m_unPhaseCount++;
+	}
+
+	double m_flSampleInterval;
+	Phase_t m_rPhases[ k_unMaxPhases ];
+	uint32_t m_unPhaseCount;
+	uint32_t m_unCurrentPhase;
+
+	VRCumulativeStatsInterval_t m_rIntervals[ k_unIntervalHistory ];
+	uint32_t m_unIntervalCount;
+
+	bool m_bHaveSample;
+	Compositor_CumulativeStats m_lastSample;
+	double m_flLastSampleSeconds;
+};
+
+} // namespace vr
@@ -0,0 +1,223 @@
+//========= Copyright Valve Corporation ============//
+// openvr_devicetopology.h
+//
+// Header-only snapshot of which tracked devices exist, their classes, their
+// controller roles and whether they are connected. Input code asks these
+// questions constantly and each one is a call into the runtime. The snapshot
+// is rebuilt only for the devices an activation or role change event is
+// about, and is published atomically so any thread can read a consistent
+// view without calling into the runtime.
+#pragma once
+
+#include "openvr.h"
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+
+namespace vr
+{
+
+/** An immutable view of the device topology. Device masks have bit n set for device n. */
+class CVRDeviceTopologySnapshot
+{
+public:
+	static const uint32_t k_unClassCount = TrackedDeviceClass_TrackingReference + 1;
+	static const uint32_t k_unRoleCount = TrackedControllerRole_RightHand + 1;
+
+	CVRDeviceTopologySnapshot()
+		: m_unVersion( 0 ), m_connectedMask( 0 )
+	{
+		for ( uint32_t i = 0; i < k_unMaxTrackedDeviceCount; i++ )
+		{
+			m_eClass[i] = TrackedDeviceClass_Invalid;
+			m_eRole[i] = TrackedControllerRole_Invalid;
+		}
+		for ( uint32_t r = 0; r < k_unRoleCount; r++ )
+			m_unRoleToIndex[r] = k_unTrackedDeviceIndexInvalid;
+		BuildClassLists();
+	}
+
+	/** Increases every time a new snapshot is published */
+	uint32_t GetVersion() const { return m_unVersion; }
+
+	ETrackedDeviceClass GetTrackedDeviceClass( TrackedDeviceIndex_t unDeviceIndex ) const
+	{
+		return unDeviceIndex < k_unMaxTrackedDeviceCount ? m_eClass[ unDeviceIndex ] : TrackedDeviceClass_Invalid;
+	}
+
+	bool IsTrackedDeviceConnected( TrackedDeviceIndex_t unDeviceIndex ) const
+	{
+		return unDeviceIndex < k_unMaxTrackedDeviceCount && ( m_connectedMask & ( (uint64_t)1 << unDeviceIndex ) );
+	}
+
+	TrackedDeviceIndex_t GetTrackedDeviceIndexForControllerRole( ETrackedControllerRole eRole ) const
+	{
+		return (uint32_t)eRole < k_unRoleCount ? m_unRoleToIndex[ eRole ] : k_unTrackedDeviceIndexInvalid;
+	}
+
+	ETrackedControllerRole GetControllerRoleForTrackedDeviceIndex( TrackedDeviceIndex_t unDeviceIndex ) const
+	{
+		return unDeviceIndex < k_unMaxTrackedDeviceCount ? m_eRole[ unDeviceIndex ] : TrackedControllerRole_Invalid;
+	}
+
+	uint64_t GetConnectedMask() const { return m_connectedMask; }
+
+	/** Connected devices of a class */
+	uint64_t GetConnectedMaskOfClass( ETrackedDeviceClass eClass ) const
+	{
+		return (uint32_t)eClass < k_unClassCount ? m_rClassMask[ eClass ] : 0;
+	}
+
+	/** Writes the connected devices of a class in device index order and returns how many there are,
+	* which may be more than unArrayCount. Unlike IVRSystem::GetSortedTrackedDeviceIndicesOfClass
+	* this does not sort by position; ask the runtime when left-to-right order matters. */
+	uint32_t GetTrackedDeviceIndicesOfClass( ETrackedDeviceClass eClass, TrackedDeviceIndex_t *punIndexArray, uint32_t unArrayCount ) const
+	{
+		if ( (uint32_t)eClass >= k_unClassCount )
+			return 0;
+
+		uint32_t unCount = m_rClassCount[ eClass ];
+		for ( uint32_t i = 0; i < unCount && i < unArrayCount; i++ )
+			punIndexArray[i] = m_rClassIndices[ eClass ][i];
+		return unCount;
+	}
+
+private:
+	friend class CVRDeviceTopology;
+
+	void BuildClassLists()
+	{
+		for ( uint32_t c = 0; c < k_unClassCount; c++ )
+		{
+			m_rClassMask[c] = 0;
+			m_rClassCount[c] = 0;
+		}
+
+		for ( uint32_t i = 0; i < k_unMaxTrackedDeviceCount; i++ )
+		{
+			if ( !( m_connectedMask & ( (uint64_t)1 << i ) ) || (uint32_t)m_eClass[i] >= k_unClassCount )
+				continue;
+
+			ETrackedDeviceClass eClass = m_eClass[i];
+			m_rClassMask[ eClass ] |= (uint64_t)1 << i;
+			m_rClassIndices[ eClass ][ m_rClassCount[ eClass ]++ ] = i;
+		}
+	}
+
+	uint32_t m_unVersion;
+	uint64_t m_connectedMask;
+	ETrackedDeviceClass m_eClass[ k_unMaxTrackedDeviceCount ];
+	ETrackedControllerRole m_eRole[ k_unMaxTrackedDeviceCount ];
+	TrackedDeviceIndex_t m_unRoleToIndex[ k_unRoleCount ];
+	uint64_t m_rClassMask[ k_unClassCount ];
+	uint32_t m_rClassCount[ k_unClassCount ];
+	TrackedDeviceIndex_t m_rClassIndices[ k_unClassCount ][ k_unMaxTrackedDeviceCount ];
+};
+
+
+/** Keeps a CVRDeviceTopologySnapshot up to date. Refresh does a full rebuild; ProcessEvent only asks
+* the runtime about what the event changed. Updates are serialized internally and GetSnapshot can be
+* called from any thread at any time. */
+class CVRDeviceTopology
+{
+public:
+	explicit CVRDeviceTopology( IVRSystem *pSystem )
+		: m_pSystem( pSystem )
+	{
+		Refresh();
+	}
+
+	/** Returns the current snapshot. It never changes, hold on to it for as long as a consistent view is needed. */
+	std::shared_ptr< const CVRDeviceTopologySnapshot > GetSnapshot() const
+	{
+		return std::atomic_load( &m_pSnapshot );
+	}
+
+	/** Rebuilds the whole snapshot from the runtime */
+	void Refresh()
+	{
+		std::lock_guard< std::mutex > lock( m_updateMutex );
+
+		std::shared_ptr< CVRDeviceTopologySnapshot > pNext = std::make_shared< CVRDeviceTopologySnapshot >();
+		for ( TrackedDeviceIndex_t i = 0; i < k_unMaxTrackedDeviceCount; i++ )
+			ReadDevice( pNext.get(), i );
+		ReadRoles( pNext.get() );
+		Publish( pNext );
+	}
+
+	/** Applies TrackedDeviceActivated, Deactivated, Updated and RoleChanged events. Returns true if a
+	* new snapshot was published. */
+	bool ProcessEvent( const VREvent_t &event )
+	{
+		switch ( event.eventType )
+		{
+		case VREvent_TrackedDeviceActivated:
+		case VREvent_TrackedDeviceDeactivated:
+		case VREvent_TrackedDeviceUpdated:
+		case VREvent_TrackedDeviceRoleChanged:
+			break;
+		default:
+			return false;
+		}
+
+		std::lock_guard< std::mutex > lock( m_updateMutex );
+
+		std::shared_ptr< CVRDeviceTopologySnapshot > pNext = std::make_shared< CVRDeviceTopologySnapshot >( *m_pSnapshot );
+		if ( event.eventType == VREvent_TrackedDeviceRoleChanged || event.trackedDeviceIndex >= k_unMaxTrackedDeviceCount )
+		{
+			ReadRoles( pNext.get() );
+		}
+		else
+		{
+			ReadDevice( pNext.get(), event.trackedDeviceIndex );
+
+			// a new controller usually takes a role, and a lost one gives its role up
+			if ( event.eventType != VREvent_TrackedDeviceUpdated )
+				ReadRoles( pNext.get() );
+		}
+
+		Publish( pNext );
+		return true;
+	}
+
+private:
+	void ReadDevice( CVRDeviceTopologySnapshot *pSnapshot, TrackedDeviceIndex_t unDeviceIndex )
+	{
+		pSnapshot->m_eClass[ unDeviceIndex ] = m_pSystem->GetTrackedDeviceClass( unDeviceIndex );
+
+		uint64_t bit = (uint64_t)1 << unDeviceIndex;
+		if ( m_pSystem->IsTrackedDeviceConnected( unDeviceIndex ) )
+			pSnapshot->m_connectedMask |= bit;
+		else
+			pSnapshot->m_connectedMask &= ~bit;
+	}
+
+	/** Two calls cover every role, rather than one per device */
+	void ReadRoles( CVRDeviceTopologySnapshot *pSnapshot )
+	{
+		for ( uint32_t i = 0; i < k_unMaxTrackedDeviceCount; i++ )
+			pSnapshot->m_eRole[i] = TrackedControllerRole_Invalid;
+
+		for ( uint32_t r = TrackedControllerRole_Invalid + 1; r < CVRDeviceTopologySnapshot::k_unRoleCount; r++ )
+		{
+			TrackedDeviceIndex_t unIndex = m_pSystem->GetTrackedDeviceIndexForControllerRole( (ETrackedControllerRole)r );
+			pSnapshot->m_unRoleToIndex[r] = unIndex;
+			if ( unIndex < k_unMaxTrackedDeviceCount )
+				pSnapshot->m_eRole[ unIndex ] = (ETrackedControllerRole)r;
+		}
+	}
+
+	void Publish( const std::shared_ptr< CVRDeviceTopologySnapshot > &pNext )
+	{
+		pNext->BuildClassLists();
+		pNext->m_unVersion = m_pSnapshot ? m_pSnapshot->m_unVersion + 1 : 1;
+		std::atomic_store( &m_pSnapshot, std::shared_ptr< const CVRDeviceTopologySnapshot >( pNext ) );
+	}
+
+	IVRSystem *m_pSystem;
+	std::mutex m_updateMutex;
+	std::shared_ptr< const CVRDeviceTopologySnapshot > m_pSnapshot;
+};
+
+} // namespace vr
@@ -0,0 +1,262 @@
+//========= Copyright Valve Corporation ============//
+// openvr_eventdispatch.h
+//
+// Header-only client side event dispatcher. A background thread drains
+// IVRSystem::PollNextEvent and routes every event by type range and device
+// into one single-producer/single-consumer queue per subsystem, so the render
+// thread (and anything else) only ever pops the events it actually handles
+// and no two consumers contend on the same queue.
+#pragma once
+
+#include "openvr.h"
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <string.h>
+
+namespace vr
+{
+
+/** Single-producer/single-consumer ring of events. Push must only be called from one thread and
+* Pop from one other thread. Capacity must be a power of two. */
+template< uint32_t unCapacity >
+class CVREventQueue
+{
+	static_assert( unCapacity >= 2 && ( unCapacity & ( unCapacity - 1 ) ) == 0, "CVREventQueue capacity must be a power of two" );
+
+public:
+	CVREventQueue()
+		: m_unHead( 0 ), m_unCachedTail( 0 ), m_unDropped( 0 ), m_unTail( 0 ), m_unCachedHead( 0 )
+	{
+	}
+
+	/** Producer side. Returns false and counts a drop if the queue is full. */
+	bool Push( const VREvent_t &event )
+	{
+		uint32_t unHead = m_unHead.load( std::memory_order_relaxed );
+		if ( unHead - m_unCachedTail == unCapacity )
+		{
+			m_unCachedTail = m_unTail.load( std::memory_order_acquire );
+			if ( unHead - m_unCachedTail == unCapacity )
+			{
+				m_unDropped.fetch_add( 1, std::memory_order_relaxed );
+				return false;
+			}
+		}
+
+		m_rEvents[ unHead & ( unCapacity - 1 ) ] = event;
+		m_unHead.store( unHead + 1, std::memory_order_release );
+		return true;
+	}
+
+	/** Consumer side. Returns false if the queue is empty. */
+	bool Pop( VREvent_t *pEvent )
+	{
+		return Pop( pEvent, 1 ) == 1;
+	}
+
+	/** Consumer side. Pops up to unMaxEvents into pEvents and returns how many were popped. */
+	uint32_t Pop( VREvent_t *pEvents, uint32_t unMaxEvents )
+	{
+		uint32_t unTail = m_unTail.load( std::memory_order_relaxed );
+		if ( m_unCachedHead == unTail )
+		{
+			m_unCachedHead = m_unHead.load( std::memory_order_acquire );
+			if ( m_unCachedHead == unTail )
+				return 0;
+		}
+
+		uint32_t unCount = m_unCachedHead - unTail;
+		if ( unCount > unMaxEvents )
+			unCount = unMaxEvents;
+		for ( uint32_t i = 0; i < unCount; i++ )
+			pEvents[i] = m_rEvents[ ( unTail + i ) & ( unCapacity - 1 ) ];
+
+		m_unTail.store( unTail + unCount, std::memory_order_release );
+		return unCount;
+	}
+
+	/** Number of events dropped because the consumer fell behind */
+	uint32_t GetDroppedCount() const { return m_unDropped.load( std::memory_order_relaxed ); }
+
+private:
+	// producer and consumer state on separate cache lines so they don't false share
+	alignas( 64 ) std::atomic< uint32_t > m_unHead;
+	uint32_t m_unCachedTail;
+	std::atomic< uint32_t > m_unDropped;
+	alignas( 64 ) std::atomic< uint32_t > m_unTail;
+	uint32_t m_unCachedHead;
+	alignas( 64 ) VREvent_t m_rEvents[ unCapacity ];
+};
+
+
+/** The consumers the dispatcher routes to */
+enum EVREventSubsystem
+{
+	VREventSubsystem_Input = 0,
+	VREventSubsystem_Overlay = 1,
+	VREventSubsystem_Chaperone = 2,
+	VREventSubsystem_Application = 3,
+
+	VREventSubsystem_Count
+};
+
+/** Polls one event into pEvent, returns false when there are no more. Lets the dispatcher pump
+* something other than IVRSystem. */
+typedef bool ( *VREventPollFn_t )( void *pContext, VREvent_t *pEvent );
+
+/** Drains events on a background thread and routes them into per subsystem queues.
+*
+* Routes are (subsystem, event type range, device mask) triples tested in the order they were
+* added. Each event is delivered to every subsystem that has a matching route, and events no route
+* matches go to VREventSubsystem_Application. Routes must be set up before Start.
+*
+* Each GetQueue( eSubsystem ) has exactly one consumer, usually the thread that owns the subsystem. */
+template< uint32_t unQueueCapacity = 256 >
+class CVREventDispatcher
+{
+public:
+	typedef CVREventQueue< unQueueCapacity > Queue_t;
+
+	static const uint32_t k_unMaxRoutes = 32;
+
+	explicit CVREventDispatcher( IVRSystem *pSystem )
+		: m_pfnPoll( &PollSystem ), m_pPollContext( pSystem ), m_unRouteCount( 0 ), m_bRunning( false )
+	{
+	}
+
+	CVREventDispatcher( VREventPollFn_t pfnPoll, void *pContext )
+		: m_pfnPoll( pfnPoll ), m_pPollContext( pContext ), m_unRouteCount( 0 ), m_bRunning( false )
+	{
+	}
+
+	~CVREventDispatcher()
+	{
+		Stop();
+	}
+
+	/** Adds a route for event types unFirstEventType..unLastEventType inclusive from the devices
+	* in deviceMask (bit n is device n, k_unTrackedDeviceIndexOther matches any device). Returns
+	* false if the route table is full. */
+	bool AddRoute( EVREventSubsystem eSubsystem, uint32_t unFirstEventType, uint32_t unLastEventType, uint64_t deviceMask = ~(uint64_t)0 )
+	{
+		if ( m_unRouteCount == k_unMaxRoutes || eSubsystem >= VREventSubsystem_Count )
+			return false;
+
+		Route_t &route = m_rRoutes[ m_unRouteCount++ ];
+		route.eSubsystem = eSubsystem;
+		route.unFirstEventType = unFirstEventType;
+		route.unLastEventType = unLastEventType;
+		route.deviceMask = deviceMask;
+		return true;
+	}
+
+	/** Routes the EVREventType groups from openvr.h to their natural subsystem */
+	void AddDefaultRoutes()
+	{
+		// device state and controller buttons, 100-299
+		AddRoute( VREventSubsystem_Input, VREvent_TrackedDeviceActivated, VREvent_ButtonPress + 99 );
+
+		// mouse and focus, overlay and dashboard, notifications, keyboard
+		AddRoute( VREventSubsystem_Overlay, VREvent_MouseMove, VREvent_MouseMove + 99 );
+		AddRoute( VREventSubsystem_Overlay, VREvent_OverlayShown, VREvent_Notification_Shown + 99 );
+		AddRoute( VREventSubsystem_Overlay, VREvent_KeyboardClosed, VREvent_KeyboardClosed + 99 );
+		AddRoute( VREventSubsystem_Overlay, VREvent_MessageOverlay_Closed, VREvent_MessageOverlay_Closed );
+
+		// chaperone data and bounds visibility
+		AddRoute( VREventSubsystem_Chaperone, VREvent_ChaperoneDataHasChanged, VREvent_SeatedZeroPoseReset );
+		AddRoute( VREventSubsystem_Chaperone, VREvent_Compositor_ChaperoneBoundsShown, VREvent_Compositor_ChaperoneBoundsHidden );
+	}
+
+	/** Starts the polling thread. It drains every pending event, then sleeps for unPollIntervalUs. */
+	void Start( uint32_t unPollIntervalUs = 1000 )
+	{
+		if ( m_bRunning.exchange( true ) )
+			return;
+
+		m_thread = std::thread( [this, unPollIntervalUs]()
+		{
+			while ( m_bRunning.load( std::memory_order_relaxed ) )
+			{
+				PumpEvents();
+				std::this_thread::sleep_for( std::chrono::microseconds( unPollIntervalUs ) );
+			}
+		} );
+	}
+
+	/** Stops and joins the polling thread. Queued events stay in their queues. */
+	void Stop()
+	{
+		if ( !m_bRunning.exchange( false ) )
+			return;
+		m_thread.join();
+	}
+
+	/** Drains the event source once on the calling thread. Only call this when the polling thread
+	* is not running, e.g. to pump from an existing loop. Returns the number of events routed. */
+	uint32_t PumpEvents()
+	{
+		uint32_t unCount = 0;
+		VREvent_t event;
+		while ( m_pfnPoll( m_pPollContext, &event ) )
+		{
+			Dispatch( event );
+			unCount++;
+		}
+		return unCount;
+	}
+
+	/** Routes one event into the matching queues */
+	void Dispatch( const VREvent_t &event )
+	{
+		uint32_t unDelivered = 0;
+		for ( uint32_t i = 0; i < m_unRouteCount; i++ )
+		{
+			const Route_t &route = m_rRoutes[i];
+			if ( event.eventType < route.unFirstEventType || event.eventType > route.unLastEventType )
+				continue;
+			if ( event.trackedDeviceIndex < 64 && !( route.deviceMask & ( (uint64_t)1 << event.trackedDeviceIndex ) ) )
+				continue;
+
+			// several routes can point at the same subsystem, deliver only once
+			uint32_t unBit = 1u << route.eSubsystem;
+			if ( unDelivered & unBit )
+				continue;
+			unDelivered |= unBit;
+			m_rQueues[ route.eSubsystem ].Push( event );
+		}
+
+		if ( !unDelivered )
+			m_rQueues[ VREventSubsystem_Application ].Push( event );
+	}
+
+	Queue_t &GetQueue( EVREventSubsystem eSubsystem ) { return m_rQueues[ eSubsystem ]; }
+
+private:
+	struct Route_t
+	{
+		EVREventSubsystem eSubsystem;
+		uint32_t unFirstEventType;
+		uint32_t unLastEventType;
+		uint64_t deviceMask;
+	};
+
+	static bool PollSystem( void *pContext, VREvent_t *pEvent )
+	{
+		return static_cast< IVRSystem * >( pContext )->PollNextEvent( pEvent, sizeof( VREvent_t ) );
+	}
+
+	CVREventDispatcher( const CVREventDispatcher & );
+	CVREventDispatcher &operator=( const CVREventDispatcher & );
+
+	VREventPollFn_t m_pfnPoll;
+	void *m_pPollContext;
+	Route_t m_rRoutes[ k_unMaxRoutes ];
+	uint32_t m_unRouteCount;
+	std::atomic< bool > m_bRunning;
+	std::thread m_thread;
+	Queue_t m_rQueues[ VREventSubsystem_Count ];
+};
+
+} // namespace vr
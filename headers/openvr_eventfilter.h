@@ -0,0 +1,273 @@
+//========= Copyright Valve Corporation ============//
+// openvr_eventfilter.h
+//
+// Header-only filtered event polling. PollNextEvent returns every event type
+// and a full VREvent_t with the whole VREvent_Data_t union for each one. This
+// drains the queue in one call, packs the types the caller asked for into a
+// caller buffer as compact records that carry only the union member that
+// belongs to the event type, and hands everything else to a callback so the
+// rest of the app still sees it.
+#pragma once
+
+#include "openvr.h"
+
+#include <stddef.h>
+#include <string.h>
+
+namespace vr
+{
+
+/** Set of event types to keep. Types below k_unDenseEventTypeCount (everything openvr.h defines
+* outside the vendor region) are a bitmask, anything above is kept in a short range list. */
+class CVREventTypeFilter
+{
+public:
+	static const uint32_t k_unDenseEventTypeCount = 2048;
+	static const uint32_t k_unMaxSparseRanges = 8;
+
+	CVREventTypeFilter()
+		: m_unSparseRangeCount( 0 )
+	{
+		memset( m_rulDenseMask, 0, sizeof( m_rulDenseMask ) );
+	}
+
+	void AddType( uint32_t unEventType )
+	{
+		AddRange( unEventType, unEventType );
+	}
+
+	/** Adds unFirstEventType..unLastEventType inclusive. Returns false if the range is above the
+	* dense region and the range list is full. */
+	bool AddRange( uint32_t unFirstEventType, uint32_t unLastEventType )
+	{
+		for ( ; unFirstEventType <= unLastEventType && unFirstEventType < k_unDenseEventTypeCount; unFirstEventType++ )
+			m_rulDenseMask[ unFirstEventType >> 6 ] |= (uint64_t)1 << ( unFirstEventType & 63 );
+
+		if ( unFirstEventType > unLastEventType )
+			return true;
+
+		if ( m_unSparseRangeCount == k_unMaxSparseRanges )
+			return false;
+		m_rSparseRanges[ m_unSparseRangeCount ].unFirst = unFirstEventType;
+		m_rSparseRanges[ m_unSparseRangeCount ].unLast = unLastEventType;
+		m_unSparseRangeCount++;
+		return true;
+	}
+
+	bool Matches( uint32_t unEventType ) const
+	{
+		if ( unEventType < k_unDenseEventTypeCount )
+			return ( m_rulDenseMask[ unEventType >> 6 ] >> ( unEventType & 63 ) ) & 1;
+
+		for ( uint32_t i = 0; i < m_unSparseRangeCount; i++ )
+		{
+			if ( unEventType >= m_rSparseRanges[i].unFirst && unEventType <= m_rSparseRanges[i].unLast )
+				return true;
+		}
+		return false;
+	}
+
+private:
+	struct Range_t
+	{
+		uint32_t unFirst;
+		uint32_t unLast;
+	};
+
+	uint64_t m_rulDenseMask[ k_unDenseEventTypeCount / 64 ];
+	Range_t m_rSparseRanges[ k_unMaxSparseRanges ];
+	uint32_t m_unSparseRangeCount;
+};
+
+
+/** Returns how many bytes of VREvent_Data_t are meaningful for an event type, i.e. the size of the
+* union member the type documents. Types without a documented member keep the whole union. */
+inline uint32_t VREvent_GetPayloadSize( uint32_t unEventType )
+{
+	switch ( unEventType )
+	{
+	case VREvent_ButtonPress:
+	case VREvent_ButtonUnpress:
+	case VREvent_ButtonTouch:
+	case VREvent_ButtonUntouch:
+		return sizeof( VREvent_Controller_t );
+
+	case VREvent_MouseMove:
+	case VREvent_MouseButtonDown:
+	case VREvent_MouseButtonUp:
+		return sizeof( VREvent_Mouse_t );
+
+	case VREvent_Scroll:
+		return sizeof( VREvent_Scroll_t );
+
+	case VREvent_TouchPadMove:
+		return sizeof( VREvent_TouchPadMove_t );
+
+	case VREvent_FocusEnter:
+	case VREvent_FocusLeave:
+	case VREvent_OverlayFocusChanged:
+	case VREvent_DashboardThumbSelected:
+	case VREvent_DashboardRequested:
+		return sizeof( VREvent_Overlay_t );
+
+	case VREvent_InputFocusCaptured:
+	case VREvent_InputFocusReleased:
+	case VREvent_SceneFocusLost:
+	case VREvent_SceneFocusGained:
+	case VREvent_SceneApplicationChanged:
+	case VREvent_SceneFocusChanged:
+	case VREvent_InputFocusChanged:
+	case VREvent_SceneApplicationSecondaryRenderingStarted:
+	case VREvent_Quit:
+	case VREvent_ProcessQuit:
+	case VREvent_QuitAborted_UserPrompt:
+	case VREvent_QuitAcknowledged:
+		return sizeof( VREvent_Process_t );
+
+	case VREvent_IpdChanged:
+		return sizeof( VREvent_Ipd_t );
+
+	case VREvent_Notification_Shown:
+	case VREvent_Notification_Hidden:
+	case VREvent_Notification_BeginInteraction:
+	case VREvent_Notification_Destroyed:
+		return sizeof( VREvent_Notification_t );
+
+	case VREvent_ChaperoneDataHasChanged:
+	case VREvent_ChaperoneUniverseHasChanged:
+	case VREvent_ChaperoneTempDataHasChanged:
+	case VREvent_ChaperoneSettingsHaveChanged:
+		return sizeof( VREvent_Chaperone_t );
+
+	case VREvent_SeatedZeroPoseReset:
+		return sizeof( VREvent_SeatedZeroPoseReset_t );
+
+	case VREvent_StatusUpdate:
+		return sizeof( VREvent_Status_t );
+
+	case VREvent_KeyboardClosed:
+	case VREvent_KeyboardCharInput:
+	case VREvent_KeyboardDone:
+		return sizeof( VREvent_Keyboard_t );
+
+	case VREvent_RequestScreenshot:
+	case VREvent_ScreenshotTaken:
+	case VREvent_ScreenshotFailed:
+	case VREvent_SubmitScreenshotToDashboard:
+		return sizeof( VREvent_Screenshot_t );
+
+	case VREvent_ScreenshotProgressToDashboard:
+		return sizeof( VREvent_ScreenshotProgress_t );
+
+	case VREvent_TrackedCamera_EditingSurface:
+		return sizeof( VREvent_EditingCameraSurface_t );
+
+	case VREvent_PerformanceTest_EnableCapture:
+	case VREvent_PerformanceTest_DisableCapture:
+	case VREvent_PerformanceTest_FidelityLevel:
+		return sizeof( VREvent_PerformanceTest_t );
+
+	case VREvent_MessageOverlay_Closed:
+		return sizeof( VREvent_MessageOverlay_t );
+
+	default:
+		return sizeof( VREvent_Data_t );
+	}
+}
+
+
+/** One packed event. The payload bytes follow the header directly and the next record starts at
+* the following 8 byte boundary. Use VREventRecord_GetData and VREventRecord_Next to read them. */
+struct VREventRecord_t
+{
+	uint16_t eventType;				// EVREventType enum, types must fit in 16 bits
+	uint8_t trackedDeviceIndex;		// k_unEventRecordDeviceOther or k_unEventRecordDeviceInvalid above 253
+	uint8_t unPayloadSize;			// bytes of VREvent_Data_t that follow
+	float eventAgeSeconds;
+};
+
+static const uint8_t k_unEventRecordDeviceOther = 0xFE;
+static const uint8_t k_unEventRecordDeviceInvalid = 0xFF;
+
+/** Largest record PollNextEventsFiltered can write, so a buffer of N times this always holds N events */
+static const uint32_t k_unMaxEventRecordSize = ( sizeof( VREventRecord_t ) + sizeof( VREvent_Data_t ) + 7 ) & ~7u;
+
+inline uint32_t VREventRecord_GetSize( const VREventRecord_t *pRecord )
+{
+	return ( sizeof( VREventRecord_t ) + pRecord->unPayloadSize + 7 ) & ~7u;
+}
+
+inline const VREventRecord_t *VREventRecord_Next( const VREventRecord_t *pRecord )
+{
+	return reinterpret_cast< const VREventRecord_t * >( reinterpret_cast< const uint8_t * >( pRecord ) + VREventRecord_GetSize( pRecord ) );
+}
+
+inline TrackedDeviceIndex_t VREventRecord_GetDeviceIndex( const VREventRecord_t *pRecord )
+{
+	if ( pRecord->trackedDeviceIndex == k_unEventRecordDeviceOther )
+		return k_unTrackedDeviceIndexOther;
+	if ( pRecord->trackedDeviceIndex == k_unEventRecordDeviceInvalid )
+		return k_unTrackedDeviceIndexInvalid;
+	return pRecord->trackedDeviceIndex;
+}
+
+/** Returns the payload as the given VREvent_Data_t member, or NULL if the record doesn't carry
+* that much payload (i.e. T is not the member for this event type). */
+template< typename T >
+inline const T *VREventRecord_GetData( const VREventRecord_t *pRecord )
+{
+	if ( sizeof( T ) > pRecord->unPayloadSize )
+		return NULL;
+	return reinterpret_cast< const T * >( pRecord + 1 );
+}
+
+/** Receives the events PollNextEventsFiltered took off the queue that didn't pass the filter. The
+* queue is shared by the whole process, so these are the events the rest of the app (quit, device
+* activation, dashboard) would otherwise never see. */
+typedef void ( *VREventUnmatchedFn_t )( void *pContext, const VREvent_t &event );
+
+/** Pass as pfnUnmatched to deliberately throw away events that don't match */
+inline void VREventFilter_DiscardUnmatched( void *, const VREvent_t & )
+{
+}
+
+/** Drains the event queue and packs every event that passes the filter into pBuffer, which must be
+* 8 byte aligned. Events that don't match are passed to pfnUnmatched in queue order. Stops early,
+* leaving the rest queued, once fewer than k_unMaxEventRecordSize bytes are free. Does nothing if
+* pfnUnmatched is NULL; use VREventFilter_DiscardUnmatched to drop them on purpose.
+*
+* Returns the number of records written, and the bytes used in *punBytesWritten if it is not NULL. */
+inline uint32_t PollNextEventsFiltered( IVRSystem *pSystem, const CVREventTypeFilter &filter, void *pBuffer, uint32_t unBufferSize, uint32_t *punBytesWritten,
+	VREventUnmatchedFn_t pfnUnmatched, void *pUnmatchedContext )
+{
+	uint8_t *pOut = static_cast< uint8_t * >( pBuffer );
+	uint32_t unUsed = 0;
+	uint32_t unCount = 0;
+
+	VREvent_t event;
+	while ( pfnUnmatched && unBufferSize - unUsed >= k_unMaxEventRecordSize && pSystem->PollNextEvent( &event, sizeof( event ) ) )
+	{
+		if ( !filter.Matches( event.eventType ) )
+		{
+			pfnUnmatched( pUnmatchedContext, event );
+			continue;
+		}
+
+		VREventRecord_t *pRecord = reinterpret_cast< VREventRecord_t * >( pOut + unUsed );
+		pRecord->eventType = (uint16_t)event.eventType;
+		pRecord->trackedDeviceIndex = event.trackedDeviceIndex < k_unEventRecordDeviceOther ? (uint8_t)event.trackedDeviceIndex
+			: event.trackedDeviceIndex == k_unTrackedDeviceIndexOther ? k_unEventRecordDeviceOther : k_unEventRecordDeviceInvalid;
+		pRecord->unPayloadSize = (uint8_t)VREvent_GetPayloadSize( event.eventType );
+		pRecord->eventAgeSeconds = event.eventAgeSeconds;
+		memcpy( pRecord + 1, &event.data, pRecord->unPayloadSize );
+
+		unUsed += VREventRecord_GetSize( pRecord );
+		unCount++;
+	}
+
+	if ( punBytesWritten )
+		*punBytesWritten = unUsed;
+	return unCount;
+}
+
+} // namespace vr
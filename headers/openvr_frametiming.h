@@ -0,0 +1,328 @@
+//========= Copyright Valve Corporation ============//
+// openvr_frametiming.h
+//
+// Header-only frame timing analytics. Feeds IVRCompositor::GetFrameTimings
+// records into fixed size histograms for the CPU, GPU and present intervals
+// and counts mispresents, dropped frames and reprojections, so applications
+// don't each need their own averaging code. Records are deduplicated by
+// m_nFrameIndex, so overlapping GetFrameTimings windows can be fed in as-is.
+// Summaries can be exported as CSV or JSON.
+#pragma once
+
+#include "openvr.h"
+
+#include <math.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+
+namespace vr
+{
+
+/** Histogram of non-negative millisecond values with logarithmic buckets. Memory is fixed; percentiles
+* are accurate to within k_flBucketGrowth / 2 of the true value between k_flMinMs and k_flMaxMs. */
+class CVRTimingHistogram
+{
+public:
+	static const uint32_t k_unBucketCount = 700;
+	static constexpr float k_flMinMs = 0.01f;
+	static constexpr float k_flBucketGrowth = 0.02f;
+
+	CVRTimingHistogram() { Reset(); }
+
+	void Reset()
+	{
+		memset( m_rBuckets, 0, sizeof( m_rBuckets ) );
+		m_unCount = 0;
+		m_flSum = 0.0;
+		m_flMin = 0.f;
+		m_flMax = 0.f;
+	}
+
+	void Add( float flMs )
+	{
+		if ( !( flMs >= 0.f ) )
+			return;		// negative or NaN
+
+		m_rBuckets[ GetBucket( flMs ) ]++;
+		m_flMin = m_unCount == 0 || flMs < m_flMin ? flMs : m_flMin;
+		m_flMax = m_unCount == 0 || flMs > m_flMax ? flMs : m_flMax;
+		m_flSum += flMs;
+		m_unCount++;
+	}
+
+	uint32_t GetCount() const { return m_unCount; }
+	float GetMin() const { return m_flMin; }
+	float GetMax() const { return m_flMax; }
+	float GetMean() const { return m_unCount ? (float)( m_flSum / m_unCount ) : 0.f; }
+
+	/** flFraction in 0..1, e.g. 0.99 for p99. Returns 0 when empty. */
+	float GetPercentile( float flFraction ) const
+	{
+		if ( m_unCount == 0 )
+			return 0.f;
+
+		uint32_t unRank = (uint32_t)ceilf( flFraction * m_unCount );
+		if ( unRank < 1 )
+			unRank = 1;
+
+		uint32_t unSeen = 0;
+		for ( uint32_t i = 0; i < k_unBucketCount; i++ )
+		{
+			unSeen += m_rBuckets[i];
+			if ( unSeen >= unRank )
+			{
+				float flValue = GetBucketMidpoint( i );
+				return flValue < m_flMin ? m_flMin : ( flValue > m_flMax ? m_flMax : flValue );
+			}
+		}
+		return m_flMax;
+	}
+
+	uint32_t GetBucketValue( uint32_t unBucket ) const { return unBucket < k_unBucketCount ? m_rBuckets[ unBucket ] : 0; }
+
+	/** Lower edge of a bucket in milliseconds. Bucket 0 holds everything below k_flMinMs. */
+	static float GetBucketLowerBound( uint32_t unBucket )
+	{
+		return unBucket == 0 ? 0.f : k_flMinMs * powf( 1.f + k_flBucketGrowth, (float)( unBucket - 1 ) );
+	}
+
+private:
+	static uint32_t GetBucket( float flMs )
+	{
+		if ( flMs < k_flMinMs )
+			return 0;
+		uint32_t unBucket = 1 + (uint32_t)( logf( flMs / k_flMinMs ) / logf( 1.f + k_flBucketGrowth ) );
+		return unBucket < k_unBucketCount ? unBucket : k_unBucketCount - 1;
+	}
+
+	static float GetBucketMidpoint( uint32_t unBucket )
+	{
+		return unBucket == 0 ? k_flMinMs * 0.5f : GetBucketLowerBound( unBucket ) * ( 1.f + k_flBucketGrowth * 0.5f );
+	}
+
+	uint32_t m_rBuckets[ k_unBucketCount ];
+	uint32_t m_unCount;
+	double m_flSum;
+	float m_flMin;
+	float m_flMax;
+};
+
+enum EVRFrameTimingMetric
+{
+	FrameTimingMetric_AppCpu,				// WaitGetPoses to the second Submit
+	FrameTimingMetric_AppGpu,				// pre and post submit GPU time
+	FrameTimingMetric_CompositorCpu,
+	FrameTimingMetric_CompositorGpu,
+	FrameTimingMetric_ClientFrameInterval,	// time between calls to WaitGetPoses
+	FrameTimingMetric_PresentInterval,		// time between consecutive compositor frames
+
+	FrameTimingMetric_Count
+};
+
+struct VRFrameTimingSummary_t
+{
+	uint32_t unCount;
+	float flMinMs;
+	float flMaxMs;
+	float flMeanMs;
+	float flP50Ms;
+	float flP95Ms;
+	float flP99Ms;
+};
+
+struct VRFrameTimingCounters_t
+{
+	uint32_t unFrames;					// distinct frames ingested
+	uint32_t unPresents;
+	uint32_t unMisPresented;
+	uint32_t unDroppedFrames;
+	uint32_t unReprojectedFrames;		// frames with any VRCompositor_ReprojectionReason_* flag
+	uint32_t unReprojectedCpuFrames;
+	uint32_t unReprojectedGpuFrames;
+	uint32_t unAsyncReprojectionFrames;
+	uint32_t unSkippedFrameIndices;		// gaps in m_nFrameIndex, i.e. frames that were never ingested
+};
+
+inline const char *VRFrameTimingMetric_GetName( EVRFrameTimingMetric eMetric )
+{
+	switch ( eMetric )
+	{
+	case FrameTimingMetric_AppCpu:					return "app_cpu";
+	case FrameTimingMetric_AppGpu:					return "app_gpu";
+	case FrameTimingMetric_CompositorCpu:			return "compositor_cpu";
+	case FrameTimingMetric_CompositorGpu:			return "compositor_gpu";
+	case FrameTimingMetric_ClientFrameInterval:		return "client_frame_interval";
+	case FrameTimingMetric_PresentInterval:			return "present_interval";
+	default:										return "unknown";
+	}
+}
+
+namespace frametiming_internal
+{
+	/** snprintf that keeps counting once the buffer is full so callers can report the size they need */
+	inline void Append( char *pchBuffer, uint32_t unBufferSize, uint32_t *punOffset, const char *pchFormat, ... )
+	{
+		va_list args;
+		va_start( args, pchFormat );
+		uint32_t unRemaining = *punOffset < unBufferSize ? unBufferSize - *punOffset : 0;
+		int nWritten = vsnprintf( unRemaining ? pchBuffer + *punOffset : NULL, unRemaining, pchFormat, args );
+		va_end( args );
+		if ( nWritten > 0 )
+			*punOffset += (uint32_t)nWritten;
+	}
+}
+
+/** Accumulates frame timings. Not thread safe; feed and read it from one thread or lock around it. */
+class CVRFrameTimingAnalytics
+{
+public:
+	static const uint32_t k_unMaxFramesPerUpdate = 128;
+
+	CVRFrameTimingAnalytics() { Reset(); }
+
+	/** Forgets everything, including which frames were already seen */
+	void Reset()
+	{
+		for ( uint32_t i = 0; i < FrameTimingMetric_Count; i++ )
+			m_rHistograms[i].Reset();
+		memset( &m_counters, 0, sizeof( m_counters ) );
+		m_bHaveLastFrame = false;
+		m_unLastFrameIndex = 0;
+		m_flLastSystemTimeSeconds = 0.0;
+	}
+
+	/** Adds records in ascending frame order. Frames at or before the newest one already ingested are
+	* skipped. Returns how many were new. */
+	uint32_t Ingest( const Compositor_FrameTiming *pTimings, uint32_t unCount )
+	{
+		uint32_t unNew = 0;
+		for ( uint32_t i = 0; i < unCount; i++ )
+		{
+			const Compositor_FrameTiming &timing = pTimings[i];
+
+			// signed difference so the check survives the index wrapping
+			int32_t nDelta = (int32_t)( timing.m_nFrameIndex - m_unLastFrameIndex );
+			if ( m_bHaveLastFrame && nDelta <= 0 )
+				continue;
+
+			if ( m_bHaveLastFrame )
+			{
+				m_counters.unSkippedFrameIndices += (uint32_t)( nDelta - 1 );
+				if ( nDelta == 1 )
+					m_rHistograms[ FrameTimingMetric_PresentInterval ].Add( (float)( ( timing.m_flSystemTimeInSeconds - m_flLastSystemTimeSeconds ) * 1000.0 ) );
+			}
+
+			AddFrame( timing );
+			m_bHaveLastFrame = true;
+			m_unLastFrameIndex = timing.m_nFrameIndex;
+			m_flLastSystemTimeSeconds = timing.m_flSystemTimeInSeconds;
+			unNew++;
+		}
+		return unNew;
+	}
+
+	/** Pulls recent frames from the compositor. The newest frame is held back until the next update
+	* because the compositor may still present it again. Call at least every k_unMaxFramesPerUpdate
+	* frames or the skipped frame count will grow. Returns how many frames were new. */
+	uint32_t Update( IVRCompositor *pCompositor )
+	{
+		Compositor_FrameTiming rTimings[ k_unMaxFramesPerUpdate ];
+		rTimings[0].m_nSize = sizeof( Compositor_FrameTiming );
+		uint32_t unCount = pCompositor->GetFrameTimings( rTimings, k_unMaxFramesPerUpdate );
+		return unCount > 1 ? Ingest( rTimings, unCount - 1 ) : 0;
+	}
+
+	const CVRTimingHistogram &GetHistogram( EVRFrameTimingMetric eMetric ) const { return m_rHistograms[ eMetric ]; }
+
+	VRFrameTimingSummary_t GetSummary( EVRFrameTimingMetric eMetric ) const
+	{
+		const CVRTimingHistogram &histogram = m_rHistograms[ eMetric ];
+		VRFrameTimingSummary_t summary;
+		summary.unCount = histogram.GetCount();
+		summary.flMinMs = histogram.GetMin();
+		summary.flMaxMs = histogram.GetMax();
+		summary.flMeanMs = histogram.GetMean();
+		summary.flP50Ms = histogram.GetPercentile( 0.50f );
+		summary.flP95Ms = histogram.GetPercentile( 0.95f );
+		summary.flP99Ms = histogram.GetPercentile( 0.99f );
+		return summary;
+	}
+
+	const VRFrameTimingCounters_t &GetCounters() const { return m_counters; }
+
+	/** Writes one row per metric followed by the counters. Returns the size needed including the
+	* terminator; the output is truncated if unBufferSize is smaller. */
+	uint32_t ExportCsv( char *pchBuffer, uint32_t unBufferSize ) const
+	{
+		uint32_t unOffset = 0;
+		frametiming_internal::Append( pchBuffer, unBufferSize, &unOffset, "metric,count,min_ms,max_ms,mean_ms,p50_ms,p95_ms,p99_ms\n" );
+		for ( uint32_t i = 0; i < FrameTimingMetric_Count; i++ )
+		{
+			VRFrameTimingSummary_t summary = GetSummary( (EVRFrameTimingMetric)i );
+			frametiming_internal::Append( pchBuffer, unBufferSize, &unOffset, "%s,%u,%.3f,%.3f,%.3f,%.3f,%.3f,%.3f\n",
+				VRFrameTimingMetric_GetName( (EVRFrameTimingMetric)i ), summary.unCount, summary.flMinMs, summary.flMaxMs,
+				summary.flMeanMs, summary.flP50Ms, summary.flP95Ms, summary.flP99Ms );
+		}
+
+		frametiming_internal::Append( pchBuffer, unBufferSize, &unOffset,
+			"\ncounter,value\nframes,%u\npresents,%u\nmispresented,%u\ndropped,%u\nreprojected,%u\nreprojected_cpu,%u\nreprojected_gpu,%u\nasync_reprojection,%u\nskipped_frame_indices,%u\n",
+			m_counters.unFrames, m_counters.unPresents, m_counters.unMisPresented, m_counters.unDroppedFrames, m_counters.unReprojectedFrames,
+			m_counters.unReprojectedCpuFrames, m_counters.unReprojectedGpuFrames, m_counters.unAsyncReprojectionFrames, m_counters.unSkippedFrameIndices );
+		return unOffset + 1;
+	}
+
+	/** Same contents as ExportCsv as a single JSON object */
+	uint32_t ExportJson( char *pchBuffer, uint32_t unBufferSize ) const
+	{
+		uint32_t unOffset = 0;
+		frametiming_internal::Append( pchBuffer, unBufferSize, &unOffset, "{\"metrics\":{" );
+		for ( uint32_t i = 0; i < FrameTimingMetric_Count; i++ )
+		{
+			VRFrameTimingSummary_t summary = GetSummary( (EVRFrameTimingMetric)i );
+			frametiming_internal::Append( pchBuffer, unBufferSize, &unOffset,
+				"%s\"%s\":{\"count\":%u,\"min_ms\":%.3f,\"max_ms\":%.3f,\"mean_ms\":%.3f,\"p50_ms\":%.3f,\"p95_ms\":%.3f,\"p99_ms\":%.3f}",
+				i ? "," : "", VRFrameTimingMetric_GetName( (EVRFrameTimingMetric)i ), summary.unCount, summary.flMinMs, summary.flMaxMs,
+				summary.flMeanMs, summary.flP50Ms, summary.flP95Ms, summary.flP99Ms );
+		}
+
+		frametiming_internal::Append( pchBuffer, unBufferSize, &unOffset,
+			"},\"counters\":{\"frames\":%u,\"presents\":%u,\"mispresented\":%u,\"dropped\":%u,\"reprojected\":%u,\"reprojected_cpu\":%u,\"reprojected_gpu\":%u,\"async_reprojection\":%u,\"skipped_frame_indices\":%u}}",
+			m_counters.unFrames, m_counters.unPresents, m_counters.unMisPresented, m_counters.unDroppedFrames, m_counters.unReprojectedFrames,
+			m_counters.unReprojectedCpuFrames, m_counters.unReprojectedGpuFrames, m_counters.unAsyncReprojectionFrames, m_counters.unSkippedFrameIndices );
+		return unOffset + 1;
+	}
+
+private:
+	void AddFrame( const Compositor_FrameTiming &timing )
+	{
+		m_rHistograms[ FrameTimingMetric_AppCpu ].Add( timing.m_flNewFrameReadyMs - timing.m_flWaitGetPosesCalledMs );
+		m_rHistograms[ FrameTimingMetric_AppGpu ].Add( timing.m_flPreSubmitGpuMs + timing.m_flPostSubmitGpuMs );
+		m_rHistograms[ FrameTimingMetric_CompositorCpu ].Add( timing.m_flCompositorRenderCpuMs );
+		m_rHistograms[ FrameTimingMetric_CompositorGpu ].Add( timing.m_flCompositorRenderGpuMs );
+		m_rHistograms[ FrameTimingMetric_ClientFrameInterval ].Add( timing.m_flClientFrameIntervalMs );
+
+		m_counters.unFrames++;
+		m_counters.unPresents += timing.m_nNumFramePresents;
+		m_counters.unMisPresented += timing.m_nNumMisPresented;
+		m_counters.unDroppedFrames += timing.m_nNumDroppedFrames;
+
+		uint32_t unFlags = timing.m_nReprojectionFlags;
+		if ( unFlags & ( VRCompositor_ReprojectionReason_Cpu | VRCompositor_ReprojectionReason_Gpu ) )
+			m_counters.unReprojectedFrames++;
+		if ( unFlags & VRCompositor_ReprojectionReason_Cpu )
+			m_counters.unReprojectedCpuFrames++;
+		if ( unFlags & VRCompositor_ReprojectionReason_Gpu )
+			m_counters.unReprojectedGpuFrames++;
+		if ( unFlags & VRCompositor_ReprojectionAsync )
+			m_counters.unAsyncReprojectionFrames++;
+	}
+
+	CVRTimingHistogram m_rHistograms[ FrameTimingMetric_Count ];
+	VRFrameTimingCounters_t m_counters;
+	bool m_bHaveLastFrame;
+	uint32_t m_unLastFrameIndex;
+	double m_flLastSystemTimeSeconds;
+};
+
+} // namespace vr
@@ -0,0 +1,344 @@
+//========= Copyright Valve Corporation ============//
+// openvr_hapticscheduler.h
+//
+// Header-only haptic scheduler. IVRSystem::TriggerHapticPulse takes one pulse
+// per call and the runtime only accepts a pulse every few milliseconds per
+// controller. This accepts whole waveforms (amplitude envelopes) per device
+// and axis, merges waveforms that overlap, and turns them into pulses at the
+// runtime's cadence from a background thread, counting the pulses that had
+// to be dropped because the thread fell behind or the queue was full.
+#pragma once
+
+#include "openvr.h"
+#include "openvr_clock.h"
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <string.h>
+#include <thread>
+#include <vector>
+
+namespace vr
+{
+
+/** One point of an amplitude envelope. Amplitude is 0..1 and is linearly interpolated between points. */
+struct VRHapticPoint_t
+{
+	float flSecondsFromStart;
+	float flAmplitude;
+};
+
+/** Receives the pulses the scheduler emits. Lets the scheduler drive a stub instead of IVRSystem. */
+typedef void ( *VRHapticPulseFn_t )( void *pContext, TrackedDeviceIndex_t unDeviceIndex, uint32_t unAxisId, unsigned short usDurationMicroSec );
+
+struct VRHapticSchedulerStats_t
+{
+	uint64_t ulPulsesEmitted;
+	uint64_t ulPulsesDropped;		// pulse slots with a non-zero amplitude that passed while the scheduler was late, and
+									// waveforms that ended while their channel was still waiting out the pulse interval
+	uint64_t ulPulsesCoalesced;		// pulses that merged more than one overlapping waveform
+	uint64_t ulWaveformsRejected;	// Play calls refused because k_unMaxActiveWaveforms were already queued
+};
+
+class CVRHapticScheduler
+{
+public:
+	static const uint32_t k_unMaxActiveWaveforms = 64;
+	static const uint32_t k_unMaxPointsPerWaveform = 64;
+
+	/** Pulses go to pSystem->TriggerHapticPulse. flPulseIntervalSeconds is the shortest time between two
+	* pulses on the same device and axis, and usMaxPulseDuration the pulse length for amplitude 1. */
+	explicit CVRHapticScheduler( IVRSystem *pSystem, float flPulseIntervalSeconds = 0.005f, unsigned short usMaxPulseDuration = 3999 )
+		: m_pfnPulse( &PulseSystem ), m_pPulseContext( pSystem )
+	{
+		Init( flPulseIntervalSeconds, usMaxPulseDuration );
+	}
+
+	CVRHapticScheduler( VRHapticPulseFn_t pfnPulse, void *pContext, float flPulseIntervalSeconds = 0.005f, unsigned short usMaxPulseDuration = 3999 )
+		: m_pfnPulse( pfnPulse ), m_pPulseContext( pContext )
+	{
+		Init( flPulseIntervalSeconds, usMaxPulseDuration );
+	}
+
+	~CVRHapticScheduler()
+	{
+		Stop();
+	}
+
+	/** Queues a waveform starting at flStartSeconds, which is on the GetMonotonicSeconds clock when the
+	* background thread drives Tick. Points must be in time order. Returns false if the arguments are
+	* invalid or the queue is full. */
+	bool Play( TrackedDeviceIndex_t unDeviceIndex, uint32_t unAxisId, const VRHapticPoint_t *pPoints, uint32_t unPointCount, double flStartSeconds )
+	{
+		if ( unDeviceIndex >= k_unMaxTrackedDeviceCount || unAxisId >= k_unControllerStateAxisCount
+			|| unPointCount == 0 || unPointCount > k_unMaxPointsPerWaveform )
+		{
+			return false;
+		}
+
+		std::lock_guard< std::mutex > lock( m_mutex );
+		if ( m_vecWaveforms.size() >= k_unMaxActiveWaveforms )
+		{
+			m_stats.ulWaveformsRejected++;
+			return false;
+		}
+
+		Waveform_t waveform;
+		waveform.unChannel = unDeviceIndex * k_unControllerStateAxisCount + unAxisId;
+		waveform.flStartSeconds = flStartSeconds;
+		waveform.flEndSeconds = flStartSeconds + pPoints[ unPointCount - 1 ].flSecondsFromStart;
+		waveform.vecPoints.assign( pPoints, pPoints + unPointCount );
+		waveform.flPeakAmplitude = 0.f;
+		for ( uint32_t i = 0; i < unPointCount; i++ )
+			waveform.flPeakAmplitude = pPoints[i].flAmplitude > waveform.flPeakAmplitude ? pPoints[i].flAmplitude : waveform.flPeakAmplitude;
+		waveform.bSampled = false;
+		m_vecWaveforms.push_back( waveform );
+		return true;
+	}
+
+	/** Queues a waveform starting now */
+	bool Play( TrackedDeviceIndex_t unDeviceIndex, uint32_t unAxisId, const VRHapticPoint_t *pPoints, uint32_t unPointCount )
+	{
+		return Play( unDeviceIndex, unAxisId, pPoints, unPointCount, GetMonotonicSeconds() );
+	}
+
+	/** Drops every queued waveform for a device */
+	void StopDevice( TrackedDeviceIndex_t unDeviceIndex )
+	{
+		std::lock_guard< std::mutex > lock( m_mutex );
+		for ( size_t i = 0; i < m_vecWaveforms.size(); )
+		{
+			if ( m_vecWaveforms[i].unChannel / k_unControllerStateAxisCount == unDeviceIndex )
+			{
+				m_vecWaveforms[i] = m_vecWaveforms.back();
+				m_vecWaveforms.pop_back();
+			}
+			else
+			{
+				i++;
+			}
+		}
+	}
+
+	/** Emits the pulses due at flNowSeconds. The background thread calls this; tests can call it
+	* directly with synthetic times instead of starting the thread. */
+	void Tick( double flNowSeconds )
+	{
+		struct Pulse_t
+		{
+			uint32_t unChannel;
+			unsigned short usDuration;
+		};
+		Pulse_t rPulses[ k_unChannelCount ];
+		uint32_t unPulseCount = 0;
+
+		{
+			std::lock_guard< std::mutex > lock( m_mutex );
+
+			float rflAmplitude[ k_unChannelCount ];
+			uint8_t rnSources[ k_unChannelCount ];
+			double rflScannedUntil[ k_unChannelCount ];
+			memset( rnSources, 0, sizeof( rnSources ) );
+			for ( uint32_t c = 0; c < k_unChannelCount; c++ )
+				rflScannedUntil[c] = m_rChannels[c].flScannedUntilSeconds;
+
+			for ( size_t i = 0; i < m_vecWaveforms.size(); i++ )
+			{
+				Waveform_t &waveform = m_vecWaveforms[i];
+				Channel_t &channel = m_rChannels[ waveform.unChannel ];
+				if ( flNowSeconds < waveform.flStartSeconds || flNowSeconds < channel.flNextPulseSeconds )
+					continue;
+
+				// count the pulse slots this waveform needed while we weren't ticking. Slots an earlier
+				// tick already looked at are skipped, whether or not that tick emitted a pulse.
+				double flFirstSlot = GetScanStart( channel );
+				if ( flFirstSlot < waveform.flStartSeconds )
+					flFirstSlot = waveform.flStartSeconds;
+				double flSlot = flFirstSlot;
+				for ( ; flSlot + m_flPulseInterval <= flNowSeconds; flSlot += m_flPulseInterval )
+				{
+					if ( SampleWaveform( waveform, flSlot ) > 0.f )
+						channel.unMissedSlots++;
+				}
+				if ( flSlot > rflScannedUntil[ waveform.unChannel ] )
+					rflScannedUntil[ waveform.unChannel ] = flSlot;
+
+				// a waveform shorter than a tick can be over by the first tick that sees it; play its
+				// strongest point then rather than nothing
+				float flAmplitude = !waveform.bSampled && flNowSeconds >= waveform.flEndSeconds ? waveform.flPeakAmplitude : SampleWaveform( waveform, flNowSeconds );
+				waveform.bSampled = true;
+
+				// overlapping waveforms merge by taking the strongest
+				if ( rnSources[ waveform.unChannel ] == 0 || flAmplitude > rflAmplitude[ waveform.unChannel ] )
+					rflAmplitude[ waveform.unChannel ] = flAmplitude;
+				if ( flAmplitude > 0.f && rnSources[ waveform.unChannel ] < 255 )
+					rnSources[ waveform.unChannel ]++;
+			}
+
+			for ( uint32_t c = 0; c < k_unChannelCount; c++ )
+			{
+				Channel_t &channel = m_rChannels[c];
+				if ( channel.unMissedSlots )
+				{
+					// several waveforms can report the same missed slot, count it once
+					double flLateSlots = ( flNowSeconds - GetScanStart( channel ) ) / m_flPulseInterval;
+					m_stats.ulPulsesDropped += (double)channel.unMissedSlots < flLateSlots ? channel.unMissedSlots : (uint64_t)flLateSlots;
+					channel.unMissedSlots = 0;
+				}
+				channel.flScannedUntilSeconds = rflScannedUntil[c];
+
+				if ( rnSources[c] == 0 )
+					continue;
+
+				unsigned short usDuration = (unsigned short)( rflAmplitude[c] * m_usMaxPulseDuration + 0.5f );
+				if ( usDuration == 0 )
+					continue;
+
+				rPulses[ unPulseCount ].unChannel = c;
+				rPulses[ unPulseCount ].usDuration = usDuration;
+				unPulseCount++;
+
+				channel.flNextPulseSeconds = flNowSeconds + m_flPulseInterval;
+				m_stats.ulPulsesEmitted++;
+				if ( rnSources[c] > 1 )
+					m_stats.ulPulsesCoalesced++;
+			}
+
+			for ( size_t i = 0; i < m_vecWaveforms.size(); )
+			{
+				if ( flNowSeconds >= m_vecWaveforms[i].flEndSeconds )
+				{
+					// ended while its channel was busy, so it never got a pulse
+					if ( !m_vecWaveforms[i].bSampled && m_vecWaveforms[i].flPeakAmplitude > 0.f )
+						m_stats.ulPulsesDropped++;
+					m_vecWaveforms[i] = m_vecWaveforms.back();
+					m_vecWaveforms.pop_back();
+				}
+				else
+				{
+					i++;
+				}
+			}
+		}
+
+		// call out without holding the lock so Play never waits on the runtime
+		for ( uint32_t i = 0; i < unPulseCount; i++ )
+		{
+			m_pfnPulse( m_pPulseContext, rPulses[i].unChannel / k_unControllerStateAxisCount, rPulses[i].unChannel % k_unControllerStateAxisCount, rPulses[i].usDuration );
+		}
+	}
+
+	/** Starts a thread that calls Tick with the steady clock every unTickIntervalUs */
+	void Start( uint32_t unTickIntervalUs = 1000 )
+	{
+		if ( m_bRunning.exchange( true ) )
+			return;
+
+		m_thread = std::thread( [this, unTickIntervalUs]()
+		{
+			while ( m_bRunning.load( std::memory_order_relaxed ) )
+			{
+				Tick( GetMonotonicSeconds() );
+				std::this_thread::sleep_for( std::chrono::microseconds( unTickIntervalUs ) );
+			}
+		} );
+	}
+
+	void Stop()
+	{
+		if ( !m_bRunning.exchange( false ) )
+			return;
+		m_thread.join();
+	}
+
+	VRHapticSchedulerStats_t GetStats() const
+	{
+		std::lock_guard< std::mutex > lock( m_mutex );
+		return m_stats;
+	}
+
+private:
+	static const uint32_t k_unChannelCount = k_unMaxTrackedDeviceCount * k_unControllerStateAxisCount;
+
+	struct Waveform_t
+	{
+		uint32_t unChannel;
+		double flStartSeconds;
+		double flEndSeconds;
+		float flPeakAmplitude;
+		bool bSampled;				// has had a tick with its channel free
+		std::vector< VRHapticPoint_t > vecPoints;
+	};
+
+	struct Channel_t
+	{
+		double flNextPulseSeconds;
+		double flScannedUntilSeconds;	// slots before this have already been checked for drops
+		uint32_t unMissedSlots;
+	};
+
+	static void PulseSystem( void *pContext, TrackedDeviceIndex_t unDeviceIndex, uint32_t unAxisId, unsigned short usDurationMicroSec )
+	{
+		static_cast< IVRSystem * >( pContext )->TriggerHapticPulse( unDeviceIndex, unAxisId, usDurationMicroSec );
+	}
+
+	// The first pulse slot on the channel that hasn't been emitted into or checked for drops
+	static double GetScanStart( const Channel_t &channel )
+	{
+		return channel.flNextPulseSeconds > channel.flScannedUntilSeconds ? channel.flNextPulseSeconds : channel.flScannedUntilSeconds;
+	}
+
+	static float SampleWaveform( const Waveform_t &waveform, double flSeconds )
+	{
+		float flTime = (float)( flSeconds - waveform.flStartSeconds );
+		const std::vector< VRHapticPoint_t > &vecPoints = waveform.vecPoints;
+		if ( flTime <= vecPoints[0].flSecondsFromStart )
+			return flTime < 0.f ? 0.f : vecPoints[0].flAmplitude;
+
+		for ( size_t i = 1; i < vecPoints.size(); i++ )
+		{
+			const VRHapticPoint_t &a = vecPoints[ i - 1 ];
+			const VRHapticPoint_t &b = vecPoints[i];
+			if ( flTime <= b.flSecondsFromStart )
+			{
+				float flSpan = b.flSecondsFromStart - a.flSecondsFromStart;
+				float flFraction = flSpan > 0.f ? ( flTime - a.flSecondsFromStart ) / flSpan : 1.f;
+				return a.flAmplitude + ( b.flAmplitude - a.flAmplitude ) * flFraction;
+			}
+		}
+		return 0.f;
+	}
+
+	void Init( float flPulseIntervalSeconds, unsigned short usMaxPulseDuration )
+	{
+		m_flPulseInterval = flPulseIntervalSeconds;
+		m_usMaxPulseDuration = usMaxPulseDuration;
+		m_bRunning = false;
+		memset( &m_stats, 0, sizeof( m_stats ) );
+		for ( uint32_t c = 0; c < k_unChannelCount; c++ )
+		{
+			m_rChannels[c].flNextPulseSeconds = 0.0;
+			m_rChannels[c].flScannedUntilSeconds = 0.0;
+			m_rChannels[c].unMissedSlots = 0;
+		}
+	}
+
+	CVRHapticScheduler( const CVRHapticScheduler & );
+	CVRHapticScheduler &operator=( const CVRHapticScheduler & );
+
+	VRHapticPulseFn_t m_pfnPulse;
+	void *m_pPulseContext;
+	double m_flPulseInterval;
+	unsigned short m_usMaxPulseDuration;
+
+	mutable std::mutex m_mutex;
+	std::vector< Waveform_t > m_vecWaveforms;
+	Channel_t m_rChannels[ k_unChannelCount ];
+	VRHapticSchedulerStats_t m_stats;
+
+	std::atomic< bool > m_bRunning;
+	std::thread m_thread;
+};
+
+} // namespace vr
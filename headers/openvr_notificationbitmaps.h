@@ -0,0 +1,214 @@
+//========= Copyright Valve Corporation ============//
+// openvr_notificationbitmaps.h
+//
+// Header-only registry of prepared notification bitmaps.
+// IVRNotifications::CreateNotification takes raw pixels every time, and apps
+// tend to send the same few icons over and over, converting them (decoding,
+// swizzling, premultiplying, resizing) before every call. This hashes the
+// source pixels with a fast non-cryptographic hash and keeps the prepared
+// bitmap for each distinct image, so every image is converted once. Hit rate
+// and the conversion time saved are counted.
+#pragma once
+
+#include "openvr.h"
+
+#include <chrono>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string.h>
+#include <unordered_map>
+#include <vector>
+
+namespace vr
+{
+
+/** 64 bit content hash, 8 bytes per step. Not cryptographic; don't use it on untrusted input where
+* collisions could be forced. */
+inline uint64_t VRBitmap_Hash64( const void *pvData, size_t unSize, uint64_t ulSeed = 0 )
+{
+	const uint64_t k_ulPrime1 = 0x9E3779B185EBCA87ull;
+	const uint64_t k_ulPrime2 = 0xC2B2AE3D27D4EB4Full;
+
+	const uint8_t *pData = static_cast< const uint8_t * >( pvData );
+	uint64_t ulHash = ulSeed ^ ( unSize * k_ulPrime1 );
+	size_t i = 0;
+	for ( ; i + 8 <= unSize; i += 8 )
+	{
+		uint64_t ulWord;
+		memcpy( &ulWord, pData + i, 8 );
+		ulHash ^= ulWord * k_ulPrime2;
+		ulHash = ( ( ulHash << 31 ) | ( ulHash >> 33 ) ) * k_ulPrime1;
+	}
+
+	uint64_t ulTail = 0;
+	memcpy( &ulTail, pData + i, unSize - i );
+	ulHash ^= ulTail * k_ulPrime2;
+
+	// final avalanche so every input bit reaches every output bit
+	ulHash ^= ulHash >> 33;
+	ulHash *= 0xFF51AFD7ED558CCDull;
+	ulHash ^= ulHash >> 33;
+	ulHash *= 0xC4CEB9FE1A85EC53ull;
+	ulHash ^= ulHash >> 33;
+	return ulHash;
+}
+
+/** A bitmap ready to hand to CreateNotification. It owns its pixels and stays valid for as long as
+* it is referenced, even after the registry dropped it. */
+struct VRPreparedNotificationBitmap_t
+{
+	std::vector< uint8_t > vecPixels;
+	NotificationBitmap_t bitmap;		// m_pImageData points into vecPixels
+};
+
+/** Turns a source bitmap into the one to send. Returns false if the source can't be used. */
+typedef bool ( *VRNotificationBitmapConvertFn_t )( void *pContext, const NotificationBitmap_t &source, VRPreparedNotificationBitmap_t *pPrepared );
+
+struct VRNotificationBitmapStats_t
+{
+	uint64_t ulLookups;
+	uint64_t ulHits;
+	uint64_t ulBytesHashed;
+	uint64_t ulHashNanoseconds;			// spent hashing, on hits and misses
+	uint64_t ulConvertNanoseconds;		// spent converting on misses
+	uint64_t ulSavedNanoseconds;		// conversion time hits didn't have to spend again
+	uint32_t unEntries;
+	uint64_t ulCachedBytes;
+};
+
+/** Thread safe. Entries are evicted least recently used first once unMaxCachedBytes is exceeded. */
+class CVRNotificationBitmapRegistry
+{
+public:
+	/** Without a convert function the prepared bitmap is a plain copy of the source */
+	explicit CVRNotificationBitmapRegistry( uint64_t ulMaxCachedBytes = 16 * 1024 * 1024, VRNotificationBitmapConvertFn_t pfnConvert = nullptr, void *pConvertContext = nullptr )
+		: m_ulMaxCachedBytes( ulMaxCachedBytes ), m_pfnConvert( pfnConvert ? pfnConvert : &CopyBitmap ), m_pConvertContext( pConvertContext )
+	{
+		memset( &m_stats, 0, sizeof( m_stats ) );
+	}
+
+	/** Returns the prepared form of pSource, converting it only the first time these exact pixels are
+	* seen. Returns nullptr if the source is empty or the conversion failed. */
+	std::shared_ptr< const VRPreparedNotificationBitmap_t > Prepare( const NotificationBitmap_t &source )
+	{
+		if ( !source.m_pImageData || source.m_nWidth <= 0 || source.m_nHeight <= 0 || source.m_nBytesPerPixel <= 0 )
+			return nullptr;
+
+		size_t unSize = (size_t)source.m_nWidth * source.m_nHeight * source.m_nBytesPerPixel;
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		uint64_t ulKey = VRBitmap_Hash64( source.m_pImageData, unSize,
+			( (uint64_t)source.m_nWidth << 40 ) ^ ( (uint64_t)source.m_nHeight << 16 ) ^ (uint64_t)source.m_nBytesPerPixel );
+		uint64_t ulHashNanoseconds = ElapsedNanoseconds( start );
+
+		{
+			std::lock_guard< std::mutex > lock( m_mutex );
+			m_stats.ulLookups++;
+			m_stats.ulBytesHashed += unSize;
+			m_stats.ulHashNanoseconds += ulHashNanoseconds;
+
+			std::unordered_map< uint64_t, EntryList_t::iterator >::iterator iter = m_mapEntries.find( ulKey );
+			if ( iter != m_mapEntries.end() )
+			{
+				m_listLru.splice( m_listLru.begin(), m_listLru, iter->second );
+				m_stats.ulHits++;
+				m_stats.ulSavedNanoseconds += iter->second->ulConvertNanoseconds;
+				return iter->second->pPrepared;
+			}
+		}
+
+		// convert outside the lock; two threads missing on the same image at once both convert it
+		std::shared_ptr< VRPreparedNotificationBitmap_t > pPrepared = std::make_shared< VRPreparedNotificationBitmap_t >();
+		start = std::chrono::steady_clock::now();
+		if ( !m_pfnConvert( m_pConvertContext, source, pPrepared.get() ) )
+			return nullptr;
+		pPrepared->bitmap.m_pImageData = pPrepared->vecPixels.data();
+		uint64_t ulConvertNanoseconds = ElapsedNanoseconds( start );
+
+		std::lock_guard< std::mutex > lock( m_mutex );
+		m_stats.ulConvertNanoseconds += ulConvertNanoseconds;
+		if ( m_mapEntries.find( ulKey ) == m_mapEntries.end() )
+		{
+			Entry_t entry;
+			entry.ulKey = ulKey;
+			entry.ulConvertNanoseconds = ulConvertNanoseconds;
+			entry.pPrepared = pPrepared;
+			m_listLru.push_front( entry );
+			m_mapEntries[ ulKey ] = m_listLru.begin();
+			m_stats.ulCachedBytes += pPrepared->vecPixels.size();
+			Trim();
+		}
+		return pPrepared;
+	}
+
+	/** CreateNotification with the prepared form of pImage. pImage may be nullptr. */
+	EVRNotificationError CreateNotification( IVRNotifications *pNotifications, VROverlayHandle_t ulOverlayHandle, uint64_t ulUserValue, EVRNotificationType type,
+		const char *pchText, EVRNotificationStyle style, const NotificationBitmap_t *pImage, VRNotificationId *pNotificationId )
+	{
+		std::shared_ptr< const VRPreparedNotificationBitmap_t > pPrepared;
+		if ( pImage )
+			pPrepared = Prepare( *pImage );
+		return pNotifications->CreateNotification( ulOverlayHandle, ulUserValue, type, pchText, style, pPrepared ? &pPrepared->bitmap : pImage, pNotificationId );
+	}
+
+	void Clear()
+	{
+		std::lock_guard< std::mutex > lock( m_mutex );
+		m_mapEntries.clear();
+		m_listLru.clear();
+		m_stats.ulCachedBytes = 0;
+	}
+
+	VRNotificationBitmapStats_t GetStats() const
+	{
+		std::lock_guard< std::mutex > lock( m_mutex );
+		VRNotificationBitmapStats_t stats = m_stats;
+		stats.unEntries = (uint32_t)m_mapEntries.size();
+		return stats;
+	}
+
+private:
+	struct Entry_t
+	{
+		uint64_t ulKey;
+		uint64_t ulConvertNanoseconds;
+		std::shared_ptr< const VRPreparedNotificationBitmap_t > pPrepared;
+	};
+	typedef std::list< Entry_t > EntryList_t;
+
+	static uint64_t ElapsedNanoseconds( const std::chrono::steady_clock::time_point &start )
+	{
+		return (uint64_t)std::chrono::duration_cast< std::chrono::nanoseconds >( std::chrono::steady_clock::now() - start ).count();
+	}
+
+	static bool CopyBitmap( void *, const NotificationBitmap_t &source, VRPreparedNotificationBitmap_t *pPrepared )
+	{
+		const uint8_t *pSource = static_cast< const uint8_t * >( source.m_pImageData );
+		pPrepared->vecPixels.assign( pSource, pSource + (size_t)source.m_nWidth * source.m_nHeight * source.m_nBytesPerPixel );
+		pPrepared->bitmap = source;
+		return true;
+	}
+
+	void Trim()
+	{
+		// always keep the newest entry, even if it alone is over the limit
+		while ( m_stats.ulCachedBytes > m_ulMaxCachedBytes && m_listLru.size() > 1 )
+		{
+			const Entry_t &oldest = m_listLru.back();
+			m_stats.ulCachedBytes -= oldest.pPrepared->vecPixels.size();
+			m_mapEntries.erase( oldest.ulKey );
+			m_listLru.pop_back();
+		}
+	}
+
+	uint64_t m_ulMaxCachedBytes;
+	VRNotificationBitmapConvertFn_t m_pfnConvert;
+	void *m_pConvertContext;
+
+	mutable std::mutex m_mutex;
+	EntryList_t m_listLru;
+	std::unordered_map< uint64_t, EntryList_t::iterator > m_mapEntries;
+	VRNotificationBitmapStats_t m_stats;
+};
+
+} // namespace vr
@@ -0,0 +1,459 @@
+//========= Copyright Valve Corporation ============//
+// openvr_overlayatlas.h
+//
+// Header-only texture atlas for many small overlays. Uploading hundreds of
+// icons and labels one overlay texture at a time costs one upload call and one
+// runtime texture each. This packs small RGBA images into a few shared atlas
+// pages with a skyline allocator and tells each overlay which page to show and
+// which part of it, through SetOverlayTexture and SetOverlayTextureBounds.
+// Pages only need uploading again when an image on them changed. When the
+// pages are full, freed space is reclaimed by repacking a page, and if that
+// isn't enough the least recently used images are evicted.
+#pragma once
+
+#include "openvr.h"
+
+#include <algorithm>
+#include <string.h>
+#include <vector>
+
+namespace vr
+{
+
+typedef uint32_t VRAtlasImageHandle_t;
+static const VRAtlasImageHandle_t k_unAtlasImageHandleInvalid = 0;
+
+struct VROverlayAtlasStats_t
+{
+	uint32_t unImages;
+	uint32_t unPages;
+	uint64_t ulUsedTexels;			// texels covered by live images, padding included
+	uint64_t ulTotalTexels;			// texels in all pages
+	uint64_t ulEvictions;
+	uint64_t ulDefragmentations;
+};
+
+/** Not thread safe. Image pixels are 4 bytes each (RGBA8). */
+class CVROverlayAtlas
+{
+public:
+	/** unPadding empty texels are kept around every image so filtering doesn't bleed neighbors in */
+	CVROverlayAtlas( uint32_t unPageWidth = 2048, uint32_t unPageHeight = 2048, uint32_t unMaxPages = 4, uint32_t unPadding = 1 )
+		: m_unPageWidth( unPageWidth ), m_unPageHeight( unPageHeight ), m_unMaxPages( unMaxPages ), m_unPadding( unPadding ),
+		m_unNextHandle( 1 ), m_ulUseClock( 0 ), m_unPlacementVersion( 0 ), m_ulEvictions( 0 ), m_ulDefragmentations( 0 )
+	{
+	}
+
+	/** Copies an image into the atlas. Returns k_unAtlasImageHandleInvalid if it can't fit on an empty
+	* page. May evict least recently used images or move others; see GetPlacementVersion. */
+	VRAtlasImageHandle_t AddImage( const void *pvPixels, uint32_t unWidth, uint32_t unHeight, uint32_t unSourceStride )
+	{
+		uint32_t unPaddedWidth = unWidth + m_unPadding, unPaddedHeight = unHeight + m_unPadding;
+		if ( unWidth == 0 || unHeight == 0 || unPaddedWidth > m_unPageWidth || unPaddedHeight > m_unPageHeight )
+			return k_unAtlasImageHandleInvalid;
+
+		Image_t image;
+		image.unHandle = m_unNextHandle++;
+		if ( image.unHandle == k_unAtlasImageHandleInvalid )
+			image.unHandle = m_unNextHandle++;
+		image.unWidth = unWidth;
+		image.unHeight = unHeight;
+		image.ulLastUse = ++m_ulUseClock;
+		image.vecPixels.resize( (size_t)unWidth * unHeight * 4 );
+		for ( uint32_t y = 0; y < unHeight; y++ )
+			memcpy( &image.vecPixels[ (size_t)y * unWidth * 4 ], static_cast< const uint8_t * >( pvPixels ) + (size_t)y * unSourceStride, unWidth * 4 );
+
+		if ( !Place( &image ) )
+			return k_unAtlasImageHandleInvalid;
+
+		m_vecImages.push_back( image );
+		BlitToPage( m_vecImages.back() );
+		return image.unHandle;
+	}
+
+	/** Replaces the pixels of an image with new ones of the same size. Only its page becomes dirty. */
+	bool UpdateImage( VRAtlasImageHandle_t unHandle, const void *pvPixels, uint32_t unSourceStride )
+	{
+		Image_t *pImage = FindImage( unHandle );
+		if ( !pImage )
+			return false;
+
+		for ( uint32_t y = 0; y < pImage->unHeight; y++ )
+			memcpy( &pImage->vecPixels[ (size_t)y * pImage->unWidth * 4 ], static_cast< const uint8_t * >( pvPixels ) + (size_t)y * unSourceStride, pImage->unWidth * 4 );
+		pImage->ulLastUse = ++m_ulUseClock;
+		BlitToPage( *pImage );
+		return true;
+	}
+
+	/** Frees an image. Its space comes back the next time its page is repacked. */
+	void RemoveImage( VRAtlasImageHandle_t unHandle )
+	{
+		for ( size_t i = 0; i < m_vecImages.size(); i++ )
+		{
+			if ( m_vecImages[i].unHandle == unHandle )
+			{
+				Page_t &page = m_vecPages[ m_vecImages[i].unPage ];
+				page.ulLiveTexels -= PaddedArea( m_vecImages[i] );
+				page.ulFreedTexels += PaddedArea( m_vecImages[i] );
+				m_vecImages[i] = m_vecImages.back();
+				m_vecImages.pop_back();
+				return;
+			}
+		}
+	}
+
+	/** Marks an image as used so eviction picks others first. Call when its overlay is shown. */
+	void Touch( VRAtlasImageHandle_t unHandle )
+	{
+		Image_t *pImage = FindImage( unHandle );
+		if ( pImage )
+			pImage->ulLastUse = ++m_ulUseClock;
+	}
+
+	/** False if the image was removed or evicted. Bounds follow SetOverlayTextureBounds: min is the
+	* upper left corner. */
+	bool GetPlacement( VRAtlasImageHandle_t unHandle, uint32_t *punPage, VRTextureBounds_t *pBounds ) const
+	{
+		const Image_t *pImage = FindImage( unHandle );
+		if ( !pImage )
+			return false;
+
+		*punPage = pImage->unPage;
+		pBounds->uMin = (float)pImage->unX / m_unPageWidth;
+		pBounds->vMin = (float)pImage->unY / m_unPageHeight;
+		pBounds->uMax = (float)( pImage->unX + pImage->unWidth ) / m_unPageWidth;
+		pBounds->vMax = (float)( pImage->unY + pImage->unHeight ) / m_unPageHeight;
+		return true;
+	}
+
+	/** Changes whenever images that were already placed move or get evicted, i.e. when overlays need
+	* their page and bounds applied again */
+	uint32_t GetPlacementVersion() const { return m_unPlacementVersion; }
+
+	uint32_t GetPageCount() const { return (uint32_t)m_vecPages.size(); }
+	uint32_t GetPageWidth() const { return m_unPageWidth; }
+	uint32_t GetPageHeight() const { return m_unPageHeight; }
+	const uint8_t *GetPagePixels( uint32_t unPage ) const { return m_vecPages[ unPage ].vecPixels.data(); }
+
+	/** A page is dirty from the moment an image on it changes until ClearPageDirty, i.e. until it was uploaded */
+	bool IsPageDirty( uint32_t unPage ) const { return m_vecPages[ unPage ].bDirty; }
+	void ClearPageDirty( uint32_t unPage ) { m_vecPages[ unPage ].bDirty = false; }
+
+	/** Repacks a page to reclaim the space of removed images. Moves images. */
+	void Defragment( uint32_t unPage )
+	{
+		Page_t &page = m_vecPages[ unPage ];
+		std::vector< Image_t * > vecImages;
+		for ( size_t i = 0; i < m_vecImages.size(); i++ )
+		{
+			if ( m_vecImages[i].unPage == unPage )
+				vecImages.push_back( &m_vecImages[i] );
+		}
+
+		// tallest first packs a skyline tightest
+		std::sort( vecImages.begin(), vecImages.end(), []( const Image_t *a, const Image_t *b ) { return a->unHeight > b->unHeight; } );
+
+		ResetPage( &page );
+		std::vector< VRAtlasImageHandle_t > vecLost;
+		for ( size_t i = 0; i < vecImages.size(); i++ )
+		{
+			// a different order can pack worse than the one the images arrived in; evict what no longer fits
+			if ( !AllocateOnPage( &page, vecImages[i]->unWidth + m_unPadding, vecImages[i]->unHeight + m_unPadding, &vecImages[i]->unX, &vecImages[i]->unY ) )
+			{
+				vecLost.push_back( vecImages[i]->unHandle );
+				continue;
+			}
+			page.ulLiveTexels += PaddedArea( *vecImages[i] );
+			BlitToPage( *vecImages[i] );
+		}
+		for ( size_t i = 0; i < vecLost.size(); i++ )
+		{
+			// not counted in ulLiveTexels any more, so take it out of the list directly
+			for ( size_t j = 0; j < m_vecImages.size(); j++ )
+			{
+				if ( m_vecImages[j].unHandle == vecLost[i] )
+				{
+					m_vecImages[j] = m_vecImages.back();
+					m_vecImages.pop_back();
+					break;
+				}
+			}
+			m_ulEvictions++;
+		}
+		page.bDirty = true;
+		m_unPlacementVersion++;
+		m_ulDefragmentations++;
+	}
+
+	VROverlayAtlasStats_t GetStats() const
+	{
+		VROverlayAtlasStats_t stats;
+		stats.unImages = (uint32_t)m_vecImages.size();
+		stats.unPages = (uint32_t)m_vecPages.size();
+		stats.ulUsedTexels = 0;
+		for ( size_t i = 0; i < m_vecPages.size(); i++ )
+			stats.ulUsedTexels += m_vecPages[i].ulLiveTexels;
+		stats.ulTotalTexels = (uint64_t)m_vecPages.size() * m_unPageWidth * m_unPageHeight;
+		stats.ulEvictions = m_ulEvictions;
+		stats.ulDefragmentations = m_ulDefragmentations;
+		return stats;
+	}
+
+private:
+	struct Image_t
+	{
+		VRAtlasImageHandle_t unHandle;
+		uint32_t unPage;
+		uint32_t unX;
+		uint32_t unY;
+		uint32_t unWidth;
+		uint32_t unHeight;
+		uint64_t ulLastUse;
+		std::vector< uint8_t > vecPixels;
+	};
+
+	static const uint32_t k_unEvictionBatchFraction = 16;
+
+	/** One step of the skyline: the top edge of everything packed between unX and unX + unWidth */
+	struct SkylineSegment_t
+	{
+		uint32_t unX;
+		uint32_t unY;
+		uint32_t unWidth;
+	};
+
+	struct Page_t
+	{
+		std::vector< uint8_t > vecPixels;
+		std::vector< SkylineSegment_t > vecSkyline;
+		uint64_t ulLiveTexels;
+		uint64_t ulFreedTexels;		// removed since the page was last packed, i.e. what a repack can win back
+		bool bDirty;
+	};
+
+	Image_t *FindImage( VRAtlasImageHandle_t unHandle )
+	{
+		for ( size_t i = 0; i < m_vecImages.size(); i++ )
+		{
+			if ( m_vecImages[i].unHandle == unHandle )
+				return &m_vecImages[i];
+		}
+		return nullptr;
+	}
+
+	const Image_t *FindImage( VRAtlasImageHandle_t unHandle ) const
+	{
+		return const_cast< CVROverlayAtlas * >( this )->FindImage( unHandle );
+	}
+
+	uint64_t PaddedArea( const Image_t &image ) const
+	{
+		return (uint64_t)( image.unWidth + m_unPadding ) * ( image.unHeight + m_unPadding );
+	}
+
+	void ResetPage( Page_t *pPage )
+	{
+		memset( pPage->vecPixels.data(), 0, pPage->vecPixels.size() );
+		pPage->vecSkyline.clear();
+		SkylineSegment_t segment = { 0, 0, m_unPageWidth };
+		pPage->vecSkyline.push_back( segment );
+		pPage->ulLiveTexels = 0;
+		pPage->ulFreedTexels = 0;
+	}
+
+	/** Skyline placement: the lowest position, then the leftmost */
+	bool AllocateOnPage( Page_t *pPage, uint32_t unWidth, uint32_t unHeight, uint32_t *punX, uint32_t *punY )
+	{
+		std::vector< SkylineSegment_t > &skyline = pPage->vecSkyline;
+		size_t unBest = skyline.size();
+		uint32_t unBestY = UINT32_MAX;
+		for ( size_t i = 0; i < skyline.size(); i++ )
+		{
+			uint32_t unX = skyline[i].unX;
+			if ( unX + unWidth > m_unPageWidth )
+				break;
+
+			// the image rests on the highest segment it spans
+			uint32_t unY = 0, unCovered = 0;
+			for ( size_t j = i; j < skyline.size() && unCovered < unWidth; j++ )
+			{
+				unY = skyline[j].unY > unY ? skyline[j].unY : unY;
+				unCovered += skyline[j].unWidth;
+			}
+			if ( unY + unHeight <= m_unPageHeight && unY < unBestY )
+			{
+				unBest = i;
+				unBestY = unY;
+			}
+		}
+		if ( unBest == skyline.size() )
+			return false;
+
+		*punX = skyline[ unBest ].unX;
+		*punY = unBestY;
+
+		// raise the skyline under the image, trimming or removing the segments it covers
+		SkylineSegment_t raised = { *punX, unBestY + unHeight, unWidth };
+		uint32_t unRight = *punX + unWidth;
+		size_t i = unBest;
+		while ( i < skyline.size() && skyline[i].unX < unRight )
+		{
+			uint32_t unSegmentRight = skyline[i].unX + skyline[i].unWidth;
+			if ( unSegmentRight <= unRight )
+			{
+				skyline.erase( skyline.begin() + i );
+			}
+			else
+			{
+				skyline[i].unWidth = unSegmentRight - unRight;
+				skyline[i].unX = unRight;
+				break;
+			}
+		}
+		skyline.insert( skyline.begin() + unBest, raised );
+
+		// neighbors at the same height become one segment
+		for ( size_t j = 0; j + 1 < skyline.size(); )
+		{
+			if ( skyline[j].unY == skyline[ j + 1 ].unY )
+			{
+				skyline[j].unWidth += skyline[ j + 1 ].unWidth;
+				skyline.erase( skyline.begin() + j + 1 );
+			}
+			else
+			{
+				j++;
+			}
+		}
+		return true;
+	}
+
+	bool TryPlaceOnPage( Image_t *pImage, uint32_t unPage )
+	{
+		Page_t &page = m_vecPages[ unPage ];
+		if ( !AllocateOnPage( &page, pImage->unWidth + m_unPadding, pImage->unHeight + m_unPadding, &pImage->unX, &pImage->unY ) )
+			return false;
+		pImage->unPage = unPage;
+		page.ulLiveTexels += PaddedArea( *pImage );
+		return true;
+	}
+
+	/** Repacks a page, or just clears it when nothing on it is left */
+	void ReclaimPage( uint32_t unPage )
+	{
+		Page_t &page = m_vecPages[ unPage ];
+		if ( page.ulLiveTexels != 0 )
+		{
+			Defragment( unPage );
+			return;
+		}
+		ResetPage( &page );
+		page.bDirty = true;
+	}
+
+	/** Existing pages, then pages repacked to reclaim freed space, then a new page, then eviction */
+	bool Place( Image_t *pImage )
+	{
+		for ( uint32_t p = 0; p < m_vecPages.size(); p++ )
+		{
+			if ( TryPlaceOnPage( pImage, p ) )
+				return true;
+		}
+
+		// repacking costs a full page copy, only do it where enough was freed to matter. Live texels
+		// are the page's real capacity; freed texels don't count skyline space that was wasted.
+		uint64_t ulArea = PaddedArea( *pImage );
+		uint64_t ulPageArea = (uint64_t)m_unPageWidth * m_unPageHeight;
+		for ( uint32_t p = 0; p < m_vecPages.size(); p++ )
+		{
+			const Page_t &page = m_vecPages[p];
+			if ( ulPageArea - page.ulLiveTexels < ulArea )
+				continue;
+			if ( page.ulLiveTexels != 0 && page.ulFreedTexels < ulArea * 2 )
+				continue;
+			ReclaimPage( p );
+			if ( TryPlaceOnPage( pImage, p ) )
+				return true;
+		}
+
+		if ( m_vecPages.size() < m_unMaxPages )
+		{
+			Page_t page;
+			page.vecPixels.resize( (size_t)m_unPageWidth * m_unPageHeight * 4 );
+			page.bDirty = true;
+			m_vecPages.push_back( page );
+			ResetPage( &m_vecPages.back() );
+			return TryPlaceOnPage( pImage, (uint32_t)m_vecPages.size() - 1 );
+		}
+
+		// evict the least recently used images until one page has room
+		while ( !m_vecImages.empty() )
+		{
+			size_t unOldest = 0;
+			for ( size_t i = 1; i < m_vecImages.size(); i++ )
+			{
+				if ( m_vecImages[i].ulLastUse < m_vecImages[ unOldest ].ulLastUse )
+					unOldest = i;
+			}
+			uint32_t unPage = m_vecImages[ unOldest ].unPage;
+			RemoveImage( m_vecImages[ unOldest ].unHandle );
+			m_ulEvictions++;
+			m_unPlacementVersion++;
+
+			// evict a batch before repacking so a full atlas doesn't repack a page on every add. A page
+			// that emptied out is always reclaimed, so anything that fits an empty page gets placed.
+			const Page_t &page = m_vecPages[ unPage ];
+			bool bEmpty = page.ulLiveTexels == 0;
+			bool bBatchFreed = page.ulFreedTexels >= ulPageArea / k_unEvictionBatchFraction && ulPageArea - page.ulLiveTexels >= ulArea;
+			if ( bEmpty || bBatchFreed )
+			{
+				ReclaimPage( unPage );
+				if ( TryPlaceOnPage( pImage, unPage ) )
+					return true;
+			}
+		}
+		return false;
+	}
+
+	void BlitToPage( const Image_t &image )
+	{
+		Page_t &page = m_vecPages[ image.unPage ];
+		for ( uint32_t y = 0; y < image.unHeight; y++ )
+		{
+			memcpy( &page.vecPixels[ ( (size_t)( image.unY + y ) * m_unPageWidth + image.unX ) * 4 ],
+				&image.vecPixels[ (size_t)y * image.unWidth * 4 ], image.unWidth * 4 );
+		}
+		page.bDirty = true;
+	}
+
+	uint32_t m_unPageWidth;
+	uint32_t m_unPageHeight;
+	uint32_t m_unMaxPages;
+	uint32_t m_unPadding;
+	VRAtlasImageHandle_t m_unNextHandle;
+	uint64_t m_ulUseClock;
+	uint32_t m_unPlacementVersion;
+	uint64_t m_ulEvictions;
+	uint64_t m_ulDefragmentations;
+
+	std::vector< Page_t > m_vecPages;
+	std::vector< Image_t > m_vecImages;
+};
+
+/** Points an overlay at its image: the page texture (prgPageTextures[page], uploaded from GetPagePixels)
+* and the image's bounds on it. Overlays sharing a page share one runtime texture. */
+inline EVROverlayError OverlayAtlas_ApplyToOverlay( IVROverlay *pOverlay, VROverlayHandle_t ulOverlayHandle, const CVROverlayAtlas &atlas,
+	VRAtlasImageHandle_t unImage, const Texture_t *prgPageTextures )
+{
+	uint32_t unPage;
+	VRTextureBounds_t bounds;
+	if ( !atlas.GetPlacement( unImage, &unPage, &bounds ) )
+		return VROverlayError_InvalidHandle;
+
+	EVROverlayError eError = pOverlay->SetOverlayTexture( ulOverlayHandle, &prgPageTextures[ unPage ] );
+	if ( eError != VROverlayError_None )
+		return eError;
+	return pOverlay->SetOverlayTextureBounds( ulOverlayHandle, &bounds );
+}
+
+} // namespace vr
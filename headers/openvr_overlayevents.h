@@ -0,0 +1,114 @@
+//========= Copyright Valve Corporation ============//
+// openvr_overlayevents.h
+//
+// Header-only multiplexed event polling across many overlays.
+// IVROverlay::PollNextOverlayEvent drains one overlay at a time, so dashboard
+// apps with dozens of overlays each write the same loop over every handle.
+// This drains a whole array of handles into one output array of events
+// tagged with their overlay. Runs of mouse move events can optionally be
+// collapsed to the latest position, and the overlay polled first rotates so a
+// busy overlay can't starve the others when the output array fills up.
+#pragma once
+
+#include "openvr.h"
+
+namespace vr
+{
+
+/** An event and the overlay it came from */
+struct VROverlayEvent_t
+{
+	VROverlayHandle_t ulOverlayHandle;
+	VREvent_t event;
+};
+
+/** Same contract as IVROverlay::PollNextOverlayEvent. Lets the poller drive a stub instead of IVROverlay. */
+typedef bool ( *VROverlayEventPollFn_t )( void *pContext, VROverlayHandle_t ulOverlayHandle, VREvent_t *pEvent, uint32_t uncbVREvent );
+
+class CVROverlayEventPoller
+{
+public:
+	explicit CVROverlayEventPoller( IVROverlay *pOverlay, bool bCoalesceMouseMove = true )
+		: m_pfnPoll( &PollOverlay ), m_pPollContext( pOverlay ), m_bCoalesceMouseMove( bCoalesceMouseMove ), m_unNextHandle( 0 ), m_ulCoalesced( 0 )
+	{
+	}
+
+	CVROverlayEventPoller( VROverlayEventPollFn_t pfnPoll, void *pContext, bool bCoalesceMouseMove = true )
+		: m_pfnPoll( pfnPoll ), m_pPollContext( pContext ), m_bCoalesceMouseMove( bCoalesceMouseMove ), m_unNextHandle( 0 ), m_ulCoalesced( 0 )
+	{
+	}
+
+	/** When set, a VREvent_MouseMove directly following another one from the same overlay replaces it,
+	* so only the latest position is kept. Other events are never merged or reordered. */
+	void SetCoalesceMouseMove( bool bCoalesce ) { m_bCoalesceMouseMove = bCoalesce; }
+
+	/** Drains the queues of every handle into pEvents, one overlay after the other, and returns how many
+	* events were written. Stops once pEvents is full; events still queued stay with the runtime, and
+	* the next call starts with the overlay after the one that filled the array. */
+	uint32_t Poll( const VROverlayHandle_t *pHandles, uint32_t unHandleCount, VROverlayEvent_t *pEvents, uint32_t unMaxEvents )
+	{
+		if ( unHandleCount == 0 )
+			return 0;
+
+		uint32_t unEventCount = 0;
+		uint32_t unStart = m_unNextHandle < unHandleCount ? m_unNextHandle : 0;
+		for ( uint32_t n = 0; n < unHandleCount; n++ )
+		{
+			uint32_t unHandle = ( unStart + n ) % unHandleCount;
+			VROverlayHandle_t ulHandle = pHandles[ unHandle ];
+			bool bHaveMouseMove = false;
+			while ( unEventCount < unMaxEvents )
+			{
+				VROverlayEvent_t &slot = pEvents[ unEventCount ];
+				if ( !m_pfnPoll( m_pPollContext, ulHandle, &slot.event, sizeof( VREvent_t ) ) )
+					break;
+				slot.ulOverlayHandle = ulHandle;
+
+				bool bMouseMove = slot.event.eventType == VREvent_MouseMove;
+				if ( m_bCoalesceMouseMove && bMouseMove && bHaveMouseMove )
+				{
+					pEvents[ unEventCount - 1 ] = slot;
+					m_ulCoalesced++;
+					continue;
+				}
+				bHaveMouseMove = bMouseMove;
+				unEventCount++;
+			}
+
+			if ( unEventCount == unMaxEvents )
+			{
+				// start after the overlay that filled the array so the others get their turn first
+				m_unNextHandle = ( unHandle + 1 ) % unHandleCount;
+				return unEventCount;
+			}
+		}
+
+		m_unNextHandle = 0;
+		return unEventCount;
+	}
+
+	/** Mouse moves dropped because a later one from the same overlay replaced them */
+	uint64_t GetCoalescedCount() const { return m_ulCoalesced; }
+
+private:
+	static bool PollOverlay( void *pContext, VROverlayHandle_t ulOverlayHandle, VREvent_t *pEvent, uint32_t uncbVREvent )
+	{
+		return static_cast< IVROverlay * >( pContext )->PollNextOverlayEvent( ulOverlayHandle, pEvent, uncbVREvent );
+	}
+
+	VROverlayEventPollFn_t m_pfnPoll;
+	void *m_pPollContext;
+	bool m_bCoalesceMouseMove;
+	uint32_t m_unNextHandle;
+	uint64_t m_ulCoalesced;
+};
+
+/** One-shot form of CVROverlayEventPoller::Poll for callers that don't need the rotation */
+inline uint32_t PollNextOverlayEvents( IVROverlay *pOverlay, const VROverlayHandle_t *pHandles, uint32_t unHandleCount,
+	VROverlayEvent_t *pEvents, uint32_t unMaxEvents, bool bCoalesceMouseMove = true )
+{
+	CVROverlayEventPoller poller( pOverlay, bCoalesceMouseMove );
+	return poller.Poll( pHandles, unHandleCount, pEvents, unMaxEvents );
+}
+
+} // namespace vr
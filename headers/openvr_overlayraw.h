@@ -0,0 +1,368 @@
+//========= Copyright Valve Corporation ============//
+// openvr_overlayraw.h
+//
+// Header-only incremental updates for raw overlay images. Applications write
+// sub-rectangles into a client side shadow copy of the overlay image. Rows
+// that don't actually change are detected and dropped, the changed area is
+// tracked as a small set of merged dirty rectangles, and Flush() only calls
+// IVROverlay::SetOverlayRaw when something changed. HUDs that redraw a few
+// text fields every frame stop sending identical images to the runtime.
+//
+// CVROverlayRawTripleBuffer lets a render thread draw raw overlay images
+// directly into one of three buffers while another thread submits the newest
+// finished one, without either side waiting on the other or copying through
+// a staging buffer.
+#pragma once
+
+#include "openvr.h"
+
+#include <atomic>
+#include <string.h>
+#include <vector>
+
+namespace vr
+{
+
+struct VROverlayDirtyRect_t
+{
+	uint32_t unX;
+	uint32_t unY;
+	uint32_t unWidth;
+	uint32_t unHeight;
+};
+
+/** Receives full images. Lets the image drive a stub instead of IVROverlay::SetOverlayRaw. */
+typedef EVROverlayError ( *VROverlayRawSubmitFn_t )( void *pContext, VROverlayHandle_t ulOverlayHandle, void *pvBuffer, uint32_t unWidth, uint32_t unHeight, uint32_t unDepth );
+
+struct VROverlayRawStats_t
+{
+	uint64_t ulBytesCompared;		// bytes of incoming pixels checked against the shadow copy
+	uint64_t ulBytesCopied;			// bytes that differed and were written into the shadow copy
+	uint64_t ulBytesSubmitted;		// bytes handed to the runtime
+	uint64_t ulFlushes;				// Flush calls that submitted an image
+	uint64_t ulFlushesSkipped;		// Flush calls with nothing dirty
+};
+
+class CVROverlayRawImage
+{
+public:
+	static const uint32_t k_unMaxDirtyRects = 16;
+
+	CVROverlayRawImage( IVROverlay *pOverlay, VROverlayHandle_t ulOverlayHandle, uint32_t unWidth, uint32_t unHeight, uint32_t unDepth )
+		: m_pfnSubmit( &SubmitOverlay ), m_pSubmitContext( pOverlay )
+	{
+		Init( ulOverlayHandle, unWidth, unHeight, unDepth );
+	}
+
+	CVROverlayRawImage( VROverlayRawSubmitFn_t pfnSubmit, void *pContext, VROverlayHandle_t ulOverlayHandle, uint32_t unWidth, uint32_t unHeight, uint32_t unDepth )
+		: m_pfnSubmit( pfnSubmit ), m_pSubmitContext( pContext )
+	{
+		Init( ulOverlayHandle, unWidth, unHeight, unDepth );
+	}
+
+	uint32_t GetWidth() const { return m_unWidth; }
+	uint32_t GetHeight() const { return m_unHeight; }
+	uint32_t GetDepth() const { return m_unDepth; }
+	uint32_t GetStride() const { return m_unWidth * m_unDepth; }
+
+	/** The shadow copy. Code that draws into it directly must call MarkDirty for what it touched. */
+	uint8_t *GetPixels() { return m_vecPixels.data(); }
+	const uint8_t *GetPixels() const { return m_vecPixels.data(); }
+
+	/** Copies unWidth x unHeight pixels at (unX, unY) from pvPixels, whose rows are unSourceStride bytes
+	* apart, into the shadow copy. Only rows that differ from the shadow are copied and marked dirty.
+	* Returns false if the rectangle doesn't fit in the image. */
+	bool UpdateRect( uint32_t unX, uint32_t unY, uint32_t unWidth, uint32_t unHeight, const void *pvPixels, uint32_t unSourceStride )
+	{
+		if ( unX > m_unWidth || unWidth > m_unWidth - unX || unY > m_unHeight || unHeight > m_unHeight - unY )
+			return false;
+
+		uint32_t unRowBytes = unWidth * m_unDepth;
+		uint32_t unFirstChanged = unHeight, unLastChanged = 0;
+		for ( uint32_t y = 0; y < unHeight; y++ )
+		{
+			const uint8_t *pSource = static_cast< const uint8_t * >( pvPixels ) + (size_t)y * unSourceStride;
+			uint8_t *pDest = m_vecPixels.data() + (size_t)( unY + y ) * GetStride() + (size_t)unX * m_unDepth;
+			m_stats.ulBytesCompared += unRowBytes;
+			if ( memcmp( pDest, pSource, unRowBytes ) == 0 )
+				continue;
+
+			memcpy( pDest, pSource, unRowBytes );
+			m_stats.ulBytesCopied += unRowBytes;
+			if ( unFirstChanged == unHeight )
+				unFirstChanged = y;
+			unLastChanged = y;
+		}
+
+		if ( unFirstChanged < unHeight )
+		{
+			VROverlayDirtyRect_t rect = { unX, unY + unFirstChanged, unWidth, unLastChanged - unFirstChanged + 1 };
+			MarkDirty( rect );
+		}
+		return true;
+	}
+
+	/** Adds a dirty rectangle, merging it with the ones it overlaps or touches. Clipped to the image. */
+	void MarkDirty( const VROverlayDirtyRect_t &rect )
+	{
+		if ( rect.unX >= m_unWidth || rect.unY >= m_unHeight || rect.unWidth == 0 || rect.unHeight == 0 )
+			return;
+
+		VROverlayDirtyRect_t merged = rect;
+		if ( merged.unWidth > m_unWidth - merged.unX )
+			merged.unWidth = m_unWidth - merged.unX;
+		if ( merged.unHeight > m_unHeight - merged.unY )
+			merged.unHeight = m_unHeight - merged.unY;
+
+		// merging can make the result touch rectangles it didn't before, so repeat until nothing changes
+		bool bMerged = true;
+		while ( bMerged )
+		{
+			bMerged = false;
+			for ( uint32_t i = 0; i < m_unDirtyRectCount; i++ )
+			{
+				if ( !BTouches( merged, m_rDirtyRects[i] ) )
+					continue;
+				merged = Union( merged, m_rDirtyRects[i] );
+				m_rDirtyRects[i] = m_rDirtyRects[ --m_unDirtyRectCount ];
+				bMerged = true;
+				break;
+			}
+		}
+
+		if ( m_unDirtyRectCount == k_unMaxDirtyRects )
+		{
+			// out of rectangles, fold the new one into whichever grows the least
+			uint32_t unBest = 0;
+			uint64_t ulBestGrowth = UINT64_MAX;
+			for ( uint32_t i = 0; i < m_unDirtyRectCount; i++ )
+			{
+				uint64_t ulGrowth = Area( Union( merged, m_rDirtyRects[i] ) ) - Area( m_rDirtyRects[i] );
+				if ( ulGrowth < ulBestGrowth )
+				{
+					ulBestGrowth = ulGrowth;
+					unBest = i;
+				}
+			}
+			merged = Union( merged, m_rDirtyRects[ unBest ] );
+			m_rDirtyRects[ unBest ] = m_rDirtyRects[ --m_unDirtyRectCount ];
+			MarkDirty( merged );
+			return;
+		}
+
+		m_rDirtyRects[ m_unDirtyRectCount++ ] = merged;
+	}
+
+	/** Marks the whole image dirty so the next Flush submits it */
+	void MarkAllDirty()
+	{
+		VROverlayDirtyRect_t rect = { 0, 0, m_unWidth, m_unHeight };
+		m_unDirtyRectCount = 0;
+		MarkDirty( rect );
+	}
+
+	bool IsDirty() const { return m_unDirtyRectCount != 0; }
+	uint32_t GetDirtyRectCount() const { return m_unDirtyRectCount; }
+	const VROverlayDirtyRect_t &GetDirtyRect( uint32_t unIndex ) const { return m_rDirtyRects[ unIndex ]; }
+
+	/** Submits the image if anything is dirty, typically once per frame. SetOverlayRaw only takes whole
+	* images, so the dirty rectangles decide whether to submit, not what. The image stays dirty if the
+	* submit fails. */
+	EVROverlayError Flush()
+	{
+		if ( m_unDirtyRectCount == 0 )
+		{
+			m_stats.ulFlushesSkipped++;
+			return VROverlayError_None;
+		}
+
+		EVROverlayError eError = m_pfnSubmit( m_pSubmitContext, m_ulOverlayHandle, m_vecPixels.data(), m_unWidth, m_unHeight, m_unDepth );
+		if ( eError == VROverlayError_None )
+		{
+			m_unDirtyRectCount = 0;
+			m_stats.ulBytesSubmitted += m_vecPixels.size();
+			m_stats.ulFlushes++;
+		}
+		return eError;
+	}
+
+	const VROverlayRawStats_t &GetStats() const { return m_stats; }
+	void ResetStats() { memset( &m_stats, 0, sizeof( m_stats ) ); }
+
+private:
+	static EVROverlayError SubmitOverlay( void *pContext, VROverlayHandle_t ulOverlayHandle, void *pvBuffer, uint32_t unWidth, uint32_t unHeight, uint32_t unDepth )
+	{
+		return static_cast< IVROverlay * >( pContext )->SetOverlayRaw( ulOverlayHandle, pvBuffer, unWidth, unHeight, unDepth );
+	}
+
+	static bool BTouches( const VROverlayDirtyRect_t &a, const VROverlayDirtyRect_t &b )
+	{
+		return a.unX <= b.unX + b.unWidth && b.unX <= a.unX + a.unWidth
+			&& a.unY <= b.unY + b.unHeight && b.unY <= a.unY + a.unHeight;
+	}
+
+	static VROverlayDirtyRect_t Union( const VROverlayDirtyRect_t &a, const VROverlayDirtyRect_t &b )
+	{
+		uint32_t unX0 = a.unX < b.unX ? a.unX : b.unX;
+		uint32_t unY0 = a.unY < b.unY ? a.unY : b.unY;
+		uint32_t unX1 = a.unX + a.unWidth > b.unX + b.unWidth ? a.unX + a.unWidth : b.unX + b.unWidth;
+		uint32_t unY1 = a.unY + a.unHeight > b.unY + b.unHeight ? a.unY + a.unHeight : b.unY + b.unHeight;
+		VROverlayDirtyRect_t rect = { unX0, unY0, unX1 - unX0, unY1 - unY0 };
+		return rect;
+	}
+
+	static uint64_t Area( const VROverlayDirtyRect_t &rect ) { return (uint64_t)rect.unWidth * rect.unHeight; }
+
+	void Init( VROverlayHandle_t ulOverlayHandle, uint32_t unWidth, uint32_t unHeight, uint32_t unDepth )
+	{
+		m_ulOverlayHandle = ulOverlayHandle;
+		m_unWidth = unWidth;
+		m_unHeight = unHeight;
+		m_unDepth = unDepth;
+		m_vecPixels.assign( (size_t)unWidth * unHeight * unDepth, 0 );
+		memset( &m_stats, 0, sizeof( m_stats ) );
+
+		// the runtime hasn't seen anything yet
+		MarkAllDirty();
+	}
+
+	VROverlayRawSubmitFn_t m_pfnSubmit;
+	void *m_pSubmitContext;
+	VROverlayHandle_t m_ulOverlayHandle;
+	uint32_t m_unWidth;
+	uint32_t m_unHeight;
+	uint32_t m_unDepth;
+	std::vector< uint8_t > m_vecPixels;
+
+	VROverlayDirtyRect_t m_rDirtyRects[ k_unMaxDirtyRects ];
+	uint32_t m_unDirtyRectCount;
+	VROverlayRawStats_t m_stats;
+};
+
+
+/** Three image buffers shared by one producer thread, which renders frames, and one consumer thread,
+* which submits them. The producer always has a buffer of its own to draw into and the consumer always
+* gets the newest published frame; frames published faster than they are submitted are skipped rather
+* than queued. Neither side ever blocks.
+*
+* The runtime copies the image on SetOverlayRaw and can't read client memory directly, so one copy per
+* submit remains; what goes away is the app's own copy into a staging buffer and any lock between
+* rendering and submitting. */
+class CVROverlayRawTripleBuffer
+{
+public:
+	CVROverlayRawTripleBuffer( IVROverlay *pOverlay, VROverlayHandle_t ulOverlayHandle, uint32_t unWidth, uint32_t unHeight, uint32_t unDepth )
+		: m_pfnSubmit( &SubmitOverlay ), m_pSubmitContext( pOverlay )
+	{
+		Init( ulOverlayHandle, unWidth, unHeight, unDepth );
+	}
+
+	CVROverlayRawTripleBuffer( VROverlayRawSubmitFn_t pfnSubmit, void *pContext, VROverlayHandle_t ulOverlayHandle, uint32_t unWidth, uint32_t unHeight, uint32_t unDepth )
+		: m_pfnSubmit( pfnSubmit ), m_pSubmitContext( pContext )
+	{
+		Init( ulOverlayHandle, unWidth, unHeight, unDepth );
+	}
+
+	uint32_t GetWidth() const { return m_unWidth; }
+	uint32_t GetHeight() const { return m_unHeight; }
+	uint32_t GetDepth() const { return m_unDepth; }
+	uint32_t GetStride() const { return m_unWidth * m_unDepth; }
+
+	/** Producer: the buffer to draw the next frame into. It holds whichever frame was drawn into it last,
+	* which is not necessarily the previous one, so redraw everything. */
+	uint8_t *GetBackBuffer() { return m_rBuffers[ m_unBack ].data(); }
+
+	/** Producer: hands the back buffer to the consumer and takes a new one */
+	void PublishFrame( uint64_t ulFrameIndex )
+	{
+		m_rulFrameIndex[ m_unBack ] = ulFrameIndex;
+		uint32_t unPrevious = m_unPublished.exchange( m_unBack | k_unFreshBit, std::memory_order_acq_rel );
+		m_unBack = unPrevious & k_unIndexMask;
+		m_ulPublished.fetch_add( 1, std::memory_order_relaxed );
+		if ( unPrevious & k_unFreshBit )
+			m_ulSkipped.fetch_add( 1, std::memory_order_relaxed );
+	}
+
+	/** Consumer: submits the newest published frame if it hasn't been submitted yet. Returns
+	* VROverlayError_None without calling the runtime when there is nothing new. */
+	EVROverlayError SubmitLatest( uint64_t *pulFrameIndex = nullptr )
+	{
+		if ( m_unPublished.load( std::memory_order_relaxed ) & k_unFreshBit )
+		{
+			m_unFront = m_unPublished.exchange( m_unFront, std::memory_order_acq_rel ) & k_unIndexMask;
+			m_bFrontPending = true;
+		}
+
+		if ( !m_bFrontPending )
+			return VROverlayError_None;
+
+		EVROverlayError eError = m_pfnSubmit( m_pSubmitContext, m_ulOverlayHandle, m_rBuffers[ m_unFront ].data(), m_unWidth, m_unHeight, m_unDepth );
+		if ( eError == VROverlayError_None )
+		{
+			// a failed submit is retried with the same frame unless a newer one shows up
+			m_bFrontPending = false;
+			m_ulSubmitted.fetch_add( 1, std::memory_order_relaxed );
+			if ( pulFrameIndex )
+				*pulFrameIndex = m_rulFrameIndex[ m_unFront ];
+		}
+		return eError;
+	}
+
+	uint64_t GetPublishedCount() const { return m_ulPublished.load( std::memory_order_relaxed ); }
+	uint64_t GetSubmittedCount() const { return m_ulSubmitted.load( std::memory_order_relaxed ); }
+
+	/** Published frames that were replaced by a newer one before the consumer picked them up */
+	uint64_t GetSkippedCount() const { return m_ulSkipped.load( std::memory_order_relaxed ); }
+
+private:
+	static const uint32_t k_unIndexMask = 3;
+	static const uint32_t k_unFreshBit = 4;
+
+	static EVROverlayError SubmitOverlay( void *pContext, VROverlayHandle_t ulOverlayHandle, void *pvBuffer, uint32_t unWidth, uint32_t unHeight, uint32_t unDepth )
+	{
+		return static_cast< IVROverlay * >( pContext )->SetOverlayRaw( ulOverlayHandle, pvBuffer, unWidth, unHeight, unDepth );
+	}
+
+	void Init( VROverlayHandle_t ulOverlayHandle, uint32_t unWidth, uint32_t unHeight, uint32_t unDepth )
+	{
+		m_ulOverlayHandle = ulOverlayHandle;
+		m_unWidth = unWidth;
+		m_unHeight = unHeight;
+		m_unDepth = unDepth;
+		for ( uint32_t i = 0; i < 3; i++ )
+		{
+			m_rBuffers[i].assign( (size_t)unWidth * unHeight * unDepth, 0 );
+			m_rulFrameIndex[i] = 0;
+		}
+		m_unBack = 0;
+		m_unPublished = 1;
+		m_unFront = 2;
+		m_bFrontPending = false;
+		m_ulPublished = 0;
+		m_ulSubmitted = 0;
+		m_ulSkipped = 0;
+	}
+
+	CVROverlayRawTripleBuffer( const CVROverlayRawTripleBuffer & );
+	CVROverlayRawTripleBuffer &operator=( const CVROverlayRawTripleBuffer & );
+
+	VROverlayRawSubmitFn_t m_pfnSubmit;
+	void *m_pSubmitContext;
+	VROverlayHandle_t m_ulOverlayHandle;
+	uint32_t m_unWidth;
+	uint32_t m_unHeight;
+	uint32_t m_unDepth;
+	std::vector< uint8_t > m_rBuffers[3];
+	uint64_t m_rulFrameIndex[3];
+
+	uint32_t m_unBack;						// producer only
+	std::atomic< uint32_t > m_unPublished;	// buffer index, plus k_unFreshBit until the consumer takes it
+	uint32_t m_unFront;						// consumer only
+	bool m_bFrontPending;					// consumer only
+
+	std::atomic< uint64_t > m_ulPublished;
+	std::atomic< uint64_t > m_ulSubmitted;
+	std::atomic< uint64_t > m_ulSkipped;
+};
+
+} // namespace vr
@@ -0,0 +1,606 @@
+//========= Copyright Valve Corporation ============//
+// openvr_overlayspatial.h
+//
+// Header-only client side spatial index for overlay ray intersection.
+// IVROverlay::ComputeOverlayIntersection tests one ray against one overlay
+// per call, so laser pointer UIs with many overlays and several controllers
+// make overlays x rays runtime calls every frame. This keeps a copy of each
+// overlay's quad (transform, width, aspect, intersection mask) in a bounding
+// volume hierarchy and answers a whole batch of rays in one call, returning
+// the nearest hit per ray.
+#pragma once
+
+#include "openvr.h"
+
+#include <algorithm>
+#include <math.h>
+#include <string.h>
+#include <vector>
+
+namespace vr
+{
+
+/** Nearest hit for one ray. ulOverlayHandle is k_ulOverlayHandleInvalid when the ray hit nothing. */
+struct VROverlayRayHit_t
+{
+	VROverlayHandle_t ulOverlayHandle;
+	VROverlayIntersectionResults_t results;
+};
+
+namespace overlayspatial_internal
+{
+	inline HmdMatrix34_t Multiply( const HmdMatrix34_t &a, const HmdMatrix34_t &b )
+	{
+		HmdMatrix34_t result;
+		for ( int r = 0; r < 3; r++ )
+		{
+			for ( int c = 0; c < 4; c++ )
+			{
+				result.m[r][c] = a.m[r][0] * b.m[0][c] + a.m[r][1] * b.m[1][c] + a.m[r][2] * b.m[2][c] + ( c == 3 ? a.m[r][3] : 0.f );
+			}
+		}
+		return result;
+	}
+
+	/** Inverse of a rotation plus translation */
+	inline HmdMatrix34_t InvertRigid( const HmdMatrix34_t &mat )
+	{
+		HmdMatrix34_t result;
+		for ( int r = 0; r < 3; r++ )
+		{
+			for ( int c = 0; c < 3; c++ )
+				result.m[r][c] = mat.m[c][r];
+			result.m[r][3] = -( mat.m[0][r] * mat.m[0][3] + mat.m[1][r] * mat.m[1][3] + mat.m[2][r] * mat.m[2][3] );
+		}
+		return result;
+	}
+
+	inline HmdVector3_t TransformPoint( const HmdMatrix34_t &mat, const HmdVector3_t &v )
+	{
+		HmdVector3_t result;
+		for ( int r = 0; r < 3; r++ )
+			result.v[r] = mat.m[r][0] * v.v[0] + mat.m[r][1] * v.v[1] + mat.m[r][2] * v.v[2] + mat.m[r][3];
+		return result;
+	}
+
+	inline HmdVector3_t TransformDirection( const HmdMatrix34_t &mat, const HmdVector3_t &v )
+	{
+		HmdVector3_t result;
+		for ( int r = 0; r < 3; r++ )
+			result.v[r] = mat.m[r][0] * v.v[0] + mat.m[r][1] * v.v[1] + mat.m[r][2] * v.v[2];
+		return result;
+	}
+
+	inline HmdMatrix34_t Identity()
+	{
+		HmdMatrix34_t result;
+		memset( &result, 0, sizeof( result ) );
+		result.m[0][0] = result.m[1][1] = result.m[2][2] = 1.f;
+		return result;
+	}
+}
+
+/** Overlays are quads centered on their transform, flWidthInMeters along local X and width * aspect
+* along local Y. Hit UVs are 0..1 across the quad with 0,0 at the lower left, the same convention as
+* GetTransformForOverlayCoordinates. Intersection masks are tested in mouse scale units with 0,0 at the
+* top left, as SetOverlayIntersectionMask expects.
+*
+* Not thread safe. Overlays tracking a device move when UpdateDevicePoses is called; everything else
+* only changes when it is set or refreshed from the runtime. */
+class CVROverlaySpatialIndex
+{
+public:
+	/** Rays and hits are expressed in eOrigin */
+	explicit CVROverlaySpatialIndex( ETrackingUniverseOrigin eOrigin = TrackingUniverseStanding )
+		: m_eOrigin( eOrigin ), m_bDirty( true )
+	{
+		m_matSeatedToStanding = overlayspatial_internal::Identity();
+		for ( uint32_t i = 0; i < k_unMaxTrackedDeviceCount; i++ )
+		{
+			m_rDevicePoses[i] = overlayspatial_internal::Identity();
+			m_rbDevicePoseValid[i] = false;
+		}
+	}
+
+	/** Needed only when overlays and rays use different universes, see
+	* IVRSystem::GetSeatedZeroPoseToStandingAbsoluteTrackingPose */
+	void SetSeatedToStandingTransform( const HmdMatrix34_t &matSeatedToStanding )
+	{
+		m_matSeatedToStanding = matSeatedToStanding;
+		m_bDirty = true;
+	}
+
+	void SetOverlayAbsolute( VROverlayHandle_t ulOverlayHandle, ETrackingUniverseOrigin eOrigin, const HmdMatrix34_t &matOriginToOverlay, float flWidthInMeters, float flAspect )
+	{
+		Overlay_t &overlay = FindOrAddOverlay( ulOverlayHandle );
+		overlay.eTransformType = VROverlayTransform_Absolute;
+		overlay.eOrigin = eOrigin;
+		overlay.matTransform = matOriginToOverlay;
+		overlay.flWidth = flWidthInMeters;
+		overlay.flAspect = flAspect;
+		m_bDirty = true;
+	}
+
+	void SetOverlayTrackedDeviceRelative( VROverlayHandle_t ulOverlayHandle, TrackedDeviceIndex_t unDeviceIndex, const HmdMatrix34_t &matDeviceToOverlay, float flWidthInMeters, float flAspect )
+	{
+		Overlay_t &overlay = FindOrAddOverlay( ulOverlayHandle );
+		overlay.eTransformType = VROverlayTransform_TrackedDeviceRelative;
+		overlay.unDeviceIndex = unDeviceIndex;
+		overlay.matTransform = matDeviceToOverlay;
+		overlay.flWidth = flWidthInMeters;
+		overlay.flAspect = flAspect;
+		m_bDirty = true;
+	}
+
+	/** Same primitives as IVROverlay::SetOverlayIntersectionMask. The runtime can't report masks back,
+	* so keep this in step with what the overlay was given. */
+	void SetOverlayIntersectionMask( VROverlayHandle_t ulOverlayHandle, const VROverlayIntersectionMaskPrimitive_t *pPrimitives, uint32_t unPrimitiveCount, const HmdVector2_t &vecMouseScale )
+	{
+		Overlay_t &overlay = FindOrAddOverlay( ulOverlayHandle );
+		overlay.vecMask.assign( pPrimitives, pPrimitives + unPrimitiveCount );
+		overlay.vecMouseScale = vecMouseScale;
+	}
+
+	void SetOverlayVisible( VROverlayHandle_t ulOverlayHandle, bool bVisible )
+	{
+		FindOrAddOverlay( ulOverlayHandle ).bVisible = bVisible;
+		m_bDirty = true;
+	}
+
+	void RemoveOverlay( VROverlayHandle_t ulOverlayHandle )
+	{
+		for ( size_t i = 0; i < m_vecOverlays.size(); i++ )
+		{
+			if ( m_vecOverlays[i].ulHandle == ulOverlayHandle )
+			{
+				m_vecOverlays[i] = m_vecOverlays.back();
+				m_vecOverlays.pop_back();
+				m_bDirty = true;
+				return;
+			}
+		}
+	}
+
+	/** Reads an overlay's transform, width, aspect, texture bounds, mouse scale and visibility from the
+	* runtime. Overlays on a tracked component or system overlays can't be described as a quad and are
+	* removed. The intersection mask is kept. */
+	EVROverlayError RefreshOverlay( IVROverlay *pOverlay, VROverlayHandle_t ulOverlayHandle )
+	{
+		VROverlayTransformType eType;
+		EVROverlayError eError = pOverlay->GetOverlayTransformType( ulOverlayHandle, &eType );
+		if ( eError != VROverlayError_None )
+			return eError;
+
+		float flWidth = 1.f;
+		pOverlay->GetOverlayWidthInMeters( ulOverlayHandle, &flWidth );
+
+		// the visible part of the texture decides the quad's shape
+		float flAspect = 1.f;
+		uint32_t unTextureWidth = 0, unTextureHeight = 0;
+		VRTextureBounds_t bounds = { 0.f, 0.f, 1.f, 1.f };
+		float flTexelAspect = 1.f;
+		HmdVector2_t vecMouseScale = { { 1.f, 1.f } };
+		pOverlay->GetOverlayTextureBounds( ulOverlayHandle, &bounds );
+		pOverlay->GetOverlayTexelAspect( ulOverlayHandle, &flTexelAspect );
+		pOverlay->GetOverlayMouseScale( ulOverlayHandle, &vecMouseScale );
+		float flBoundsWidth = fabsf( bounds.uMax - bounds.uMin ), flBoundsHeight = fabsf( bounds.vMax - bounds.vMin );
+		if ( pOverlay->GetOverlayTextureSize( ulOverlayHandle, &unTextureWidth, &unTextureHeight ) == VROverlayError_None
+			&& unTextureWidth && unTextureHeight && flBoundsWidth > 0.f && flTexelAspect > 0.f )
+		{
+			flAspect = ( unTextureHeight * flBoundsHeight ) / ( unTextureWidth * flBoundsWidth * flTexelAspect );
+		}
+		else if ( vecMouseScale.v[0] > 0.f )
+		{
+			flAspect = vecMouseScale.v[1] / vecMouseScale.v[0];
+		}
+
+		HmdMatrix34_t matTransform;
+		if ( eType == VROverlayTransform_Absolute )
+		{
+			ETrackingUniverseOrigin eOrigin;
+			eError = pOverlay->GetOverlayTransformAbsolute( ulOverlayHandle, &eOrigin, &matTransform );
+			if ( eError == VROverlayError_None )
+				SetOverlayAbsolute( ulOverlayHandle, eOrigin, matTransform, flWidth, flAspect );
+		}
+		else if ( eType == VROverlayTransform_TrackedDeviceRelative )
+		{
+			TrackedDeviceIndex_t unDeviceIndex;
+			eError = pOverlay->GetOverlayTransformTrackedDeviceRelative( ulOverlayHandle, &unDeviceIndex, &matTransform );
+			if ( eError == VROverlayError_None )
+				SetOverlayTrackedDeviceRelative( ulOverlayHandle, unDeviceIndex, matTransform, flWidth, flAspect );
+		}
+		else
+		{
+			RemoveOverlay( ulOverlayHandle );
+			return VROverlayError_None;
+		}
+
+		if ( eError == VROverlayError_None )
+		{
+			Overlay_t &overlay = FindOrAddOverlay( ulOverlayHandle );
+			overlay.vecMouseScale = vecMouseScale;
+			overlay.bVisible = pOverlay->IsOverlayVisible( ulOverlayHandle );
+		}
+		return eError;
+	}
+
+	/** Device poses in the index's origin, e.g. from WaitGetPoses. Moves device relative overlays. */
+	void UpdateDevicePoses( const TrackedDevicePose_t *pPoses, uint32_t unPoseCount )
+	{
+		for ( uint32_t i = 0; i < unPoseCount && i < k_unMaxTrackedDeviceCount; i++ )
+		{
+			m_rbDevicePoseValid[i] = pPoses[i].bPoseIsValid;
+			if ( pPoses[i].bPoseIsValid )
+				m_rDevicePoses[i] = pPoses[i].mDeviceToAbsoluteTracking;
+		}
+		m_bDirty = true;
+	}
+
+	uint32_t GetOverlayCount() const { return (uint32_t)m_vecOverlays.size(); }
+
+	/** Finds the nearest visible overlay hit by each ray and writes one entry per ray to pHits. Rays may
+	* be in either the seated or the standing universe. Returns how many rays hit something. */
+	uint32_t IntersectRays( const VROverlayIntersectionParams_t *pRays, uint32_t unRayCount, VROverlayRayHit_t *pHits )
+	{
+		if ( m_bDirty )
+			Rebuild();
+
+		uint32_t unHitCount = 0;
+		for ( uint32_t i = 0; i < unRayCount; i++ )
+		{
+			if ( IntersectRay( pRays[i], &pHits[i] ) )
+				unHitCount++;
+		}
+		return unHitCount;
+	}
+
+private:
+	struct Overlay_t
+	{
+		VROverlayHandle_t ulHandle;
+		VROverlayTransformType eTransformType;
+		ETrackingUniverseOrigin eOrigin;
+		TrackedDeviceIndex_t unDeviceIndex;
+		HmdMatrix34_t matTransform;
+		float flWidth;
+		float flAspect;
+		bool bVisible;
+		std::vector< VROverlayIntersectionMaskPrimitive_t > vecMask;
+		HmdVector2_t vecMouseScale;
+	};
+
+	/** World space quad of a visible overlay, rebuilt with the tree */
+	struct Quad_t
+	{
+		uint32_t unOverlay;
+		HmdMatrix34_t matOverlayToWorld;
+		HmdMatrix34_t matWorldToOverlay;
+		float flHalfWidth;
+		float flHalfHeight;
+		float rflMin[3];
+		float rflMax[3];
+		float rflCenter[3];
+	};
+
+	struct Node_t
+	{
+		float rflMin[3];
+		float rflMax[3];
+		uint32_t unFirst;		// first quad for a leaf, right child for an inner node
+		uint32_t unCount;		// 0 for an inner node, whose left child follows it
+	};
+
+	static const uint32_t k_unMaxLeafQuads = 2;
+
+	// nodes this deep become leaves whatever their size, which bounds the traversal stack
+	static const uint32_t k_unMaxDepth = 48;
+
+	Overlay_t &FindOrAddOverlay( VROverlayHandle_t ulOverlayHandle )
+	{
+		for ( size_t i = 0; i < m_vecOverlays.size(); i++ )
+		{
+			if ( m_vecOverlays[i].ulHandle == ulOverlayHandle )
+				return m_vecOverlays[i];
+		}
+
+		Overlay_t overlay;
+		overlay.ulHandle = ulOverlayHandle;
+		overlay.eTransformType = VROverlayTransform_Absolute;
+		overlay.eOrigin = m_eOrigin;
+		overlay.unDeviceIndex = k_unTrackedDeviceIndexInvalid;
+		overlay.matTransform = overlayspatial_internal::Identity();
+		overlay.flWidth = 1.f;
+		overlay.flAspect = 1.f;
+		overlay.bVisible = true;
+		overlay.vecMouseScale.v[0] = overlay.vecMouseScale.v[1] = 1.f;
+		m_vecOverlays.push_back( overlay );
+		m_bDirty = true;
+		return m_vecOverlays.back();
+	}
+
+	/** Origin to index origin, for the seated and standing universes */
+	bool GetUniverseTransform( ETrackingUniverseOrigin eFrom, HmdMatrix34_t *pTransform ) const
+	{
+		if ( eFrom == m_eOrigin || eFrom == TrackingUniverseRawAndUncalibrated || m_eOrigin == TrackingUniverseRawAndUncalibrated )
+		{
+			*pTransform = overlayspatial_internal::Identity();
+			return false;
+		}
+		*pTransform = eFrom == TrackingUniverseSeated ? m_matSeatedToStanding : overlayspatial_internal::InvertRigid( m_matSeatedToStanding );
+		return true;
+	}
+
+	void Rebuild()
+	{
+		m_vecQuads.clear();
+		for ( uint32_t i = 0; i < m_vecOverlays.size(); i++ )
+		{
+			const Overlay_t &overlay = m_vecOverlays[i];
+			if ( !overlay.bVisible || overlay.flWidth <= 0.f )
+				continue;
+
+			Quad_t quad;
+			quad.unOverlay = i;
+			if ( overlay.eTransformType == VROverlayTransform_TrackedDeviceRelative )
+			{
+				if ( overlay.unDeviceIndex >= k_unMaxTrackedDeviceCount || !m_rbDevicePoseValid[ overlay.unDeviceIndex ] )
+					continue;
+				quad.matOverlayToWorld = overlayspatial_internal::Multiply( m_rDevicePoses[ overlay.unDeviceIndex ], overlay.matTransform );
+			}
+			else
+			{
+				HmdMatrix34_t matUniverse;
+				quad.matOverlayToWorld = GetUniverseTransform( overlay.eOrigin, &matUniverse )
+					? overlayspatial_internal::Multiply( matUniverse, overlay.matTransform ) : overlay.matTransform;
+			}
+			quad.matWorldToOverlay = overlayspatial_internal::InvertRigid( quad.matOverlayToWorld );
+			quad.flHalfWidth = overlay.flWidth * 0.5f;
+			quad.flHalfHeight = overlay.flWidth * overlay.flAspect * 0.5f;
+
+			for ( int a = 0; a < 3; a++ )
+			{
+				// the quad's extent along each world axis
+				float flExtent = fabsf( quad.matOverlayToWorld.m[a][0] ) * quad.flHalfWidth + fabsf( quad.matOverlayToWorld.m[a][1] ) * quad.flHalfHeight;
+				quad.rflCenter[a] = quad.matOverlayToWorld.m[a][3];
+				quad.rflMin[a] = quad.rflCenter[a] - flExtent;
+				quad.rflMax[a] = quad.rflCenter[a] + flExtent;
+			}
+			m_vecQuads.push_back( quad );
+		}
+
+		m_vecNodes.clear();
+		if ( !m_vecQuads.empty() )
+			BuildNode( 0, (uint32_t)m_vecQuads.size(), 0 );
+		m_bDirty = false;
+	}
+
+	uint32_t BuildNode( uint32_t unFirst, uint32_t unCount, uint32_t unDepth )
+	{
+		uint32_t unNode = (uint32_t)m_vecNodes.size();
+		m_vecNodes.push_back( Node_t() );
+
+		float rflMin[3], rflMax[3], rflCenterMin[3], rflCenterMax[3];
+		for ( int a = 0; a < 3; a++ )
+		{
+			rflMin[a] = rflCenterMin[a] = 1e30f;
+			rflMax[a] = rflCenterMax[a] = -1e30f;
+		}
+		for ( uint32_t i = unFirst; i < unFirst + unCount; i++ )
+		{
+			const Quad_t &quad = m_vecQuads[i];
+			for ( int a = 0; a < 3; a++ )
+			{
+				rflMin[a] = quad.rflMin[a] < rflMin[a] ? quad.rflMin[a] : rflMin[a];
+				rflMax[a] = quad.rflMax[a] > rflMax[a] ? quad.rflMax[a] : rflMax[a];
+				rflCenterMin[a] = quad.rflCenter[a] < rflCenterMin[a] ? quad.rflCenter[a] : rflCenterMin[a];
+				rflCenterMax[a] = quad.rflCenter[a] > rflCenterMax[a] ? quad.rflCenter[a] : rflCenterMax[a];
+			}
+		}
+		memcpy( m_vecNodes[ unNode ].rflMin, rflMin, sizeof( rflMin ) );
+		memcpy( m_vecNodes[ unNode ].rflMax, rflMax, sizeof( rflMax ) );
+
+		if ( unCount <= k_unMaxLeafQuads || unDepth >= k_unMaxDepth )
+		{
+			m_vecNodes[ unNode ].unFirst = unFirst;
+			m_vecNodes[ unNode ].unCount = unCount;
+			return unNode;
+		}
+
+		// split at the middle of the widest spread of centers
+		int nAxis = 0;
+		for ( int a = 1; a < 3; a++ )
+		{
+			if ( rflCenterMax[a] - rflCenterMin[a] > rflCenterMax[ nAxis ] - rflCenterMin[ nAxis ] )
+				nAxis = a;
+		}
+		float flSplit = ( rflCenterMin[ nAxis ] + rflCenterMax[ nAxis ] ) * 0.5f;
+		uint32_t unMid = unFirst;
+		for ( uint32_t i = unFirst; i < unFirst + unCount; i++ )
+		{
+			if ( m_vecQuads[i].rflCenter[ nAxis ] < flSplit )
+				std::swap( m_vecQuads[i], m_vecQuads[ unMid++ ] );
+		}
+		if ( unMid - unFirst < unCount / 4 || unFirst + unCount - unMid < unCount / 4 )
+		{
+			// clustered or exponentially spaced centers split very unevenly at the middle, which makes the
+			// tree as deep as it has quads; split at the median instead
+			unMid = unFirst + unCount / 2;
+			std::nth_element( m_vecQuads.begin() + unFirst, m_vecQuads.begin() + unMid, m_vecQuads.begin() + unFirst + unCount,
+				[nAxis]( const Quad_t &a, const Quad_t &b ) { return a.rflCenter[ nAxis ] < b.rflCenter[ nAxis ]; } );
+		}
+
+		BuildNode( unFirst, unMid - unFirst, unDepth + 1 );
+		uint32_t unRight = BuildNode( unMid, unFirst + unCount - unMid, unDepth + 1 );
+		m_vecNodes[ unNode ].unFirst = unRight;
+		m_vecNodes[ unNode ].unCount = 0;
+		return unNode;
+	}
+
+	static bool BRayHitsBox( const float *pflOrigin, const float *pflInvDirection, const float *pflMin, const float *pflMax, float flMaxT )
+	{
+		float flNear = 0.f, flFar = flMaxT;
+		for ( int a = 0; a < 3; a++ )
+		{
+			float t0 = ( pflMin[a] - pflOrigin[a] ) * pflInvDirection[a];
+			float t1 = ( pflMax[a] - pflOrigin[a] ) * pflInvDirection[a];
+			if ( t0 > t1 )
+				std::swap( t0, t1 );
+			flNear = t0 > flNear ? t0 : flNear;
+			flFar = t1 < flFar ? t1 : flFar;
+			if ( flNear > flFar )
+				return false;
+		}
+		return true;
+	}
+
+	static bool BInsideMask( const Overlay_t &overlay, float u, float v )
+	{
+		if ( overlay.vecMask.empty() )
+			return true;
+
+		float x = u * overlay.vecMouseScale.v[0];
+		float y = ( 1.f - v ) * overlay.vecMouseScale.v[1];
+		for ( size_t i = 0; i < overlay.vecMask.size(); i++ )
+		{
+			const VROverlayIntersectionMaskPrimitive_t &primitive = overlay.vecMask[i];
+			if ( primitive.m_nPrimitiveType == OverlayIntersectionPrimitiveType_Rectangle )
+			{
+				const IntersectionMaskRectangle_t &rect = primitive.m_Primitive.m_Rectangle;
+				if ( x >= rect.m_flTopLeftX && x <= rect.m_flTopLeftX + rect.m_flWidth && y >= rect.m_flTopLeftY && y <= rect.m_flTopLeftY + rect.m_flHeight )
+					return true;
+			}
+			else if ( primitive.m_nPrimitiveType == OverlayIntersectionPrimitiveType_Circle )
+			{
+				const IntersectionMaskCircle_t &circle = primitive.m_Primitive.m_Circle;
+				float dx = x - circle.m_flCenterX, dy = y - circle.m_flCenterY;
+				if ( dx * dx + dy * dy <= circle.m_flRadius * circle.m_flRadius )
+					return true;
+			}
+		}
+		return false;
+	}
+
+	/** Ray parameter of the hit, or a negative value for a miss */
+	float IntersectQuad( const Quad_t &quad, const HmdVector3_t &vSource, const HmdVector3_t &vDirection, VROverlayIntersectionResults_t *pResults ) const
+	{
+		HmdVector3_t vLocalSource = overlayspatial_internal::TransformPoint( quad.matWorldToOverlay, vSource );
+		HmdVector3_t vLocalDirection = overlayspatial_internal::TransformDirection( quad.matWorldToOverlay, vDirection );
+		if ( fabsf( vLocalDirection.v[2] ) < 1e-9f )
+			return -1.f;
+
+		float t = -vLocalSource.v[2] / vLocalDirection.v[2];
+		if ( t < 0.f )
+			return -1.f;
+
+		float x = vLocalSource.v[0] + vLocalDirection.v[0] * t;
+		float y = vLocalSource.v[1] + vLocalDirection.v[1] * t;
+		if ( fabsf( x ) > quad.flHalfWidth || fabsf( y ) > quad.flHalfHeight )
+			return -1.f;
+
+		float u = x / ( 2.f * quad.flHalfWidth ) + 0.5f;
+		float v = y / ( 2.f * quad.flHalfHeight ) + 0.5f;
+		if ( !BInsideMask( m_vecOverlays[ quad.unOverlay ], u, v ) )
+			return -1.f;
+
+		for ( int a = 0; a < 3; a++ )
+		{
+			pResults->vPoint.v[a] = vSource.v[a] + vDirection.v[a] * t;
+			pResults->vNormal.v[a] = quad.matOverlayToWorld.m[a][2];
+		}
+		pResults->vUVs.v[0] = u;
+		pResults->vUVs.v[1] = v;
+		pResults->fDistance = t * sqrtf( vDirection.v[0] * vDirection.v[0] + vDirection.v[1] * vDirection.v[1] + vDirection.v[2] * vDirection.v[2] );
+		return t;
+	}
+
+	bool IntersectRay( const VROverlayIntersectionParams_t &ray, VROverlayRayHit_t *pHit ) const
+	{
+		pHit->ulOverlayHandle = k_ulOverlayHandleInvalid;
+		if ( m_vecNodes.empty() )
+			return false;
+
+		HmdVector3_t vSource = ray.vSource, vDirection = ray.vDirection;
+		HmdMatrix34_t matUniverse;
+		if ( GetUniverseTransform( ray.eOrigin, &matUniverse ) )
+		{
+			vSource = overlayspatial_internal::TransformPoint( matUniverse, vSource );
+			vDirection = overlayspatial_internal::TransformDirection( matUniverse, vDirection );
+		}
+
+		float rflInvDirection[3];
+		for ( int a = 0; a < 3; a++ )
+			rflInvDirection[a] = fabsf( vDirection.v[a] ) > 1e-20f ? 1.f / vDirection.v[a] : ( vDirection.v[a] < 0.f ? -1e30f : 1e30f );
+
+		float flBestT = 1e30f;
+		// at most one pending sibling per level, plus the two children just pushed
+		uint32_t rnStack[ k_unMaxDepth + 2 ];
+		uint32_t unStackSize = 0;
+		rnStack[ unStackSize++ ] = 0;
+		while ( unStackSize )
+		{
+			const Node_t &node = m_vecNodes[ rnStack[ --unStackSize ] ];
+			if ( !BRayHitsBox( vSource.v, rflInvDirection, node.rflMin, node.rflMax, flBestT ) )
+				continue;
+
+			if ( node.unCount == 0 )
+			{
+				uint32_t unNode = (uint32_t)( &node - &m_vecNodes[0] );
+				rnStack[ unStackSize++ ] = node.unFirst;
+				rnStack[ unStackSize++ ] = unNode + 1;
+				continue;
+			}
+
+			for ( uint32_t i = node.unFirst; i < node.unFirst + node.unCount; i++ )
+			{
+				VROverlayIntersectionResults_t results;
+				float t = IntersectQuad( m_vecQuads[i], vSource, vDirection, &results );
+				if ( t >= 0.f && t < flBestT )
+				{
+					flBestT = t;
+					pHit->ulOverlayHandle = m_vecOverlays[ m_vecQuads[i].unOverlay ].ulHandle;
+					pHit->results = results;
+				}
+			}
+		}
+		return pHit->ulOverlayHandle != k_ulOverlayHandleInvalid;
+	}
+
+	ETrackingUniverseOrigin m_eOrigin;
+	HmdMatrix34_t m_matSeatedToStanding;
+	HmdMatrix34_t m_rDevicePoses[ k_unMaxTrackedDeviceCount ];
+	bool m_rbDevicePoseValid[ k_unMaxTrackedDeviceCount ];
+
+	std::vector< Overlay_t > m_vecOverlays;
+	std::vector< Quad_t > m_vecQuads;
+	std::vector< Node_t > m_vecNodes;
+	bool m_bDirty;
+};
+
+/** Answers the same batched query through IVROverlay::ComputeOverlayIntersection, one call per ray
+* and overlay. Useful as a reference to check CVROverlaySpatialIndex against the runtime. */
+inline uint32_t OverlaySpatial_IntersectRaysWithRuntime( IVROverlay *pOverlay, const VROverlayHandle_t *pHandles, uint32_t unHandleCount,
+	const VROverlayIntersectionParams_t *pRays, uint32_t unRayCount, VROverlayRayHit_t *pHits )
+{
+	uint32_t unHitCount = 0;
+	for ( uint32_t r = 0; r < unRayCount; r++ )
+	{
+		pHits[r].ulOverlayHandle = k_ulOverlayHandleInvalid;
+		for ( uint32_t h = 0; h < unHandleCount; h++ )
+		{
+			VROverlayIntersectionParams_t params = pRays[r];
+			VROverlayIntersectionResults_t results;
+			if ( !pOverlay->ComputeOverlayIntersection( pHandles[h], &params, &results ) )
+				continue;
+			if ( pHits[r].ulOverlayHandle == k_ulOverlayHandleInvalid || results.fDistance < pHits[r].results.fDistance )
+			{
+				pHits[r].ulOverlayHandle = pHandles[h];
+				pHits[r].results = results;
+			}
+		}
+		if ( pHits[r].ulOverlayHandle != k_ulOverlayHandleInvalid )
+			unHitCount++;
+	}
+	return unHitCount;
+}
+
+} // namespace vr
@@ -0,0 +1,269 @@
+//========= Copyright Valve Corporation ============//
+// openvr_posebatch.h
+//
+// Header-only helpers for turning the TrackedDevicePose_t array returned by
+// IVRCompositor::WaitGetPoses or IVRSystem::GetDeviceToAbsoluteTrackingPose
+// into render matrices for every device at once. Matrices are processed as a
+// structure of arrays so SSE/AVX lanes each carry one device.
+#pragma once
+
+#include "openvr.h"
+
+#include <string.h>
+
+#if defined( __AVX__ )
+#include <immintrin.h>
+#define VR_POSEBATCH_AVX 1
+#define VR_POSEBATCH_SSE 1
+#elif defined( __SSE2__ ) || defined( _M_X64 ) || ( defined( _M_IX86_FP ) && _M_IX86_FP >= 2 )
+#include <xmmintrin.h>
+#define VR_POSEBATCH_SSE 1
+#endif
+
+#if defined( _MSC_VER )
+#define VR_POSEBATCH_ALIGN __declspec( align( 32 ) )
+#else
+#define VR_POSEBATCH_ALIGN __attribute__(( aligned( 32 ) ))
+#endif
+
+namespace vr
+{
+
+/** One bit per tracked device slot */
+typedef uint64_t TrackedDeviceMask_t;
+static_assert( k_unMaxTrackedDeviceCount <= 64, "TrackedDeviceMask_t is too small for k_unMaxTrackedDeviceCount" );
+
+/** Number of slots in a batch, k_unMaxTrackedDeviceCount rounded up to a whole number of AVX lanes */
+static const uint32_t k_unPoseBatchCapacity = ( k_unMaxTrackedDeviceCount + 7 ) & ~7u;
+
+/** Structure-of-arrays copy of a 3x4 matrix per device. m[row][col][device] matches
+* HmdMatrix34_t::m[row][col] for that device. Slots not selected by the mask that was used
+* to fill the batch hold the identity. */
+struct VR_POSEBATCH_ALIGN PoseBatchMatrices_t
+{
+	float m[3][4][ k_unPoseBatchCapacity ];
+};
+
+/** Returns a mask with the bit set for every slot whose pose is valid and whose device is connected */
+inline TrackedDeviceMask_t PoseBatch_GetValidMask( const TrackedDevicePose_t *pPoses, uint32_t unPoseCount )
+{
+	TrackedDeviceMask_t mask = 0;
+	for ( uint32_t i = 0; i < unPoseCount && i < k_unPoseBatchCapacity; i++ )
+	{
+		if ( pPoses[i].bPoseIsValid && pPoses[i].bDeviceIsConnected )
+			mask |= (TrackedDeviceMask_t)1 << i;
+	}
+	return mask;
+}
+
+/** Returns the inverse of a rigid transform: the rotation is transposed and the translation
+* rotated back. This is exact for tracking poses and much cheaper than a general 4x4 inverse. */
+inline HmdMatrix34_t PoseBatch_InvertAffine( const HmdMatrix34_t &mat )
+{
+	HmdMatrix34_t out;
+	for ( int r = 0; r < 3; r++ )
+	{
+		for ( int c = 0; c < 3; c++ )
+			out.m[r][c] = mat.m[c][r];
+		out.m[r][3] = -( mat.m[0][r] * mat.m[0][3] + mat.m[1][r] * mat.m[1][3] + mat.m[2][r] * mat.m[2][3] );
+	}
+	return out;
+}
+
+/** Writes a 3x4 pose as a column-major 4x4, the layout OpenGL and most math libraries expect */
+inline void PoseBatch_ToColumnMajor44( const HmdMatrix34_t &mat, float *pflOut16 )
+{
+#if defined( VR_POSEBATCH_SSE )
+	__m128 r0 = _mm_loadu_ps( mat.m[0] );
+	__m128 r1 = _mm_loadu_ps( mat.m[1] );
+	__m128 r2 = _mm_loadu_ps( mat.m[2] );
+	__m128 r3 = _mm_set_ps( 1.f, 0.f, 0.f, 0.f );
+	_MM_TRANSPOSE4_PS( r0, r1, r2, r3 );
+	_mm_storeu_ps( pflOut16 + 0, r0 );
+	_mm_storeu_ps( pflOut16 + 4, r1 );
+	_mm_storeu_ps( pflOut16 + 8, r2 );
+	_mm_storeu_ps( pflOut16 + 12, r3 );
+#else
+	for ( int c = 0; c < 4; c++ )
+	{
+		pflOut16[ c * 4 + 0 ] = mat.m[0][c];
+		pflOut16[ c * 4 + 1 ] = mat.m[1][c];
+		pflOut16[ c * 4 + 2 ] = mat.m[2][c];
+		pflOut16[ c * 4 + 3 ] = c == 3 ? 1.f : 0.f;
+	}
+#endif
+}
+
+/** Converts every pose selected by mask straight to a column-major 4x4 in prflOut[ device ].
+* Slots not in the mask are left untouched. */
+inline void PoseBatch_ToColumnMajor44( const TrackedDevicePose_t *pPoses, uint32_t unPoseCount, TrackedDeviceMask_t mask, float ( *prflOut )[16] )
+{
+	for ( uint32_t i = 0; i < unPoseCount && i < k_unPoseBatchCapacity; i++ )
+	{
+		if ( mask & ( (TrackedDeviceMask_t)1 << i ) )
+			PoseBatch_ToColumnMajor44( pPoses[i].mDeviceToAbsoluteTracking, prflOut[i] );
+	}
+}
+
+/** Transposes the selected device-to-absolute matrices into a batch. Every other slot is set to identity. */
+inline void PoseBatch_Gather( const TrackedDevicePose_t *pPoses, uint32_t unPoseCount, TrackedDeviceMask_t mask, PoseBatchMatrices_t *pOut )
+{
+	for ( uint32_t i = 0; i < k_unPoseBatchCapacity; i++ )
+	{
+		if ( i < unPoseCount && ( mask & ( (TrackedDeviceMask_t)1 << i ) ) )
+		{
+			const HmdMatrix34_t &mat = pPoses[i].mDeviceToAbsoluteTracking;
+			for ( int r = 0; r < 3; r++ )
+				for ( int c = 0; c < 4; c++ )
+					pOut->m[r][c][i] = mat.m[r][c];
+		}
+		else
+		{
+			for ( int r = 0; r < 3; r++ )
+				for ( int c = 0; c < 4; c++ )
+					pOut->m[r][c][i] = r == c ? 1.f : 0.f;
+		}
+	}
+}
+
+/** Copies one slot of a batch back out as a 3x4 matrix */
+inline HmdMatrix34_t PoseBatch_GetMatrix( const PoseBatchMatrices_t &batch, uint32_t unDevice )
+{
+	HmdMatrix34_t out;
+	for ( int r = 0; r < 3; r++ )
+		for ( int c = 0; c < 4; c++ )
+			out.m[r][c] = batch.m[r][c][ unDevice ];
+	return out;
+}
+
+//-----------------------------------------------------------------------------
+// Lane helpers, one device per lane.
+//-----------------------------------------------------------------------------
+namespace posebatch_internal
+{
+#if defined( VR_POSEBATCH_AVX )
+	typedef __m256 Lanes_t;
+	static const uint32_t k_unLaneWidth = 8;
+	inline Lanes_t Load( const float *p ) { return _mm256_load_ps( p ); }
+	inline void Store( float *p, Lanes_t v ) { _mm256_store_ps( p, v ); }
+	inline Lanes_t Splat( float f ) { return _mm256_set1_ps( f ); }
+	inline Lanes_t Add( Lanes_t a, Lanes_t b ) { return _mm256_add_ps( a, b ); }
+	inline Lanes_t Sub( Lanes_t a, Lanes_t b ) { return _mm256_sub_ps( a, b ); }
+	inline Lanes_t Mul( Lanes_t a, Lanes_t b ) { return _mm256_mul_ps( a, b ); }
+	inline Lanes_t Neg( Lanes_t a ) { return _mm256_sub_ps( _mm256_setzero_ps(), a ); }
+#elif defined( VR_POSEBATCH_SSE )
+	typedef __m128 Lanes_t;
+	static const uint32_t k_unLaneWidth = 4;
+	inline Lanes_t Load( const float *p ) { return _mm_load_ps( p ); }
+	inline void Store( float *p, Lanes_t v ) { _mm_store_ps( p, v ); }
+	inline Lanes_t Splat( float f ) { return _mm_set1_ps( f ); }
+	inline Lanes_t Add( Lanes_t a, Lanes_t b ) { return _mm_add_ps( a, b ); }
+	inline Lanes_t Sub( Lanes_t a, Lanes_t b ) { return _mm_sub_ps( a, b ); }
+	inline Lanes_t Mul( Lanes_t a, Lanes_t b ) { return _mm_mul_ps( a, b ); }
+	inline Lanes_t Neg( Lanes_t a ) { return _mm_sub_ps( _mm_setzero_ps(), a ); }
+#else
+	typedef float Lanes_t;
+	static const uint32_t k_unLaneWidth = 1;
+	inline Lanes_t Load( const float *p ) { return *p; }
+	inline void Store( float *p, Lanes_t v ) { *p = v; }
+	inline Lanes_t Splat( float f ) { return f; }
+	inline Lanes_t Add( Lanes_t a, Lanes_t b ) { return a + b; }
+	inline Lanes_t Sub( Lanes_t a, Lanes_t b ) { return a - b; }
+	inline Lanes_t Mul( Lanes_t a, Lanes_t b ) { return a * b; }
+	inline Lanes_t Neg( Lanes_t a ) { return -a; }
+#endif
+}
+
+/** Inverts every rigid transform in the batch. pOut may alias in. */
+inline void PoseBatch_InvertAffine( const PoseBatchMatrices_t &in, PoseBatchMatrices_t *pOut )
+{
+	using namespace posebatch_internal;
+	for ( uint32_t i = 0; i < k_unPoseBatchCapacity; i += k_unLaneWidth )
+	{
+		Lanes_t m[3][4];
+		for ( int r = 0; r < 3; r++ )
+			for ( int c = 0; c < 4; c++ )
+				m[r][c] = Load( &in.m[r][c][i] );
+
+		for ( int r = 0; r < 3; r++ )
+		{
+			for ( int c = 0; c < 3; c++ )
+				Store( &pOut->m[r][c][i], m[c][r] );
+
+			Lanes_t t = Add( Add( Mul( m[0][r], m[0][3] ), Mul( m[1][r], m[1][3] ) ), Mul( m[2][r], m[2][3] ) );
+			Store( &pOut->m[r][3][i], Neg( t ) );
+		}
+	}
+}
+
+/** Computes mLeft * in for every slot of the batch, e.g. the inverted HMD pose times each
+* device pose to get device-to-head transforms. pOut may alias in. */
+inline void PoseBatch_MultiplyLeft( const HmdMatrix34_t &mLeft, const PoseBatchMatrices_t &in, PoseBatchMatrices_t *pOut )
+{
+	using namespace posebatch_internal;
+	Lanes_t l[3][4];
+	for ( int r = 0; r < 3; r++ )
+		for ( int c = 0; c < 4; c++ )
+			l[r][c] = Splat( mLeft.m[r][c] );
+
+	for ( uint32_t i = 0; i < k_unPoseBatchCapacity; i += k_unLaneWidth )
+	{
+		Lanes_t m[3][4];
+		for ( int r = 0; r < 3; r++ )
+			for ( int c = 0; c < 4; c++ )
+				m[r][c] = Load( &in.m[r][c][i] );
+
+		for ( int r = 0; r < 3; r++ )
+		{
+			for ( int c = 0; c < 4; c++ )
+			{
+				Lanes_t v = Add( Add( Mul( l[r][0], m[0][c] ), Mul( l[r][1], m[1][c] ) ), Mul( l[r][2], m[2][c] ) );
+				if ( c == 3 )
+					v = Add( v, l[r][3] );
+				Store( &pOut->m[r][c][i], v );
+			}
+		}
+	}
+}
+
+/** Writes every slot selected by mask as a column-major 4x4 into prflOut[ device ].
+* Slots not in the mask are left untouched. */
+inline void PoseBatch_ScatterColumnMajor44( const PoseBatchMatrices_t &batch, TrackedDeviceMask_t mask, float ( *prflOut )[16] )
+{
+#if defined( VR_POSEBATCH_SSE )
+	for ( uint32_t i = 0; i < k_unPoseBatchCapacity; i += 4 )
+	{
+		uint32_t unGroupMask = (uint32_t)( mask >> i ) & 0xF;
+		if ( !unGroupMask )
+			continue;
+
+		// each transpose turns one column of four devices into that column for each device
+		__m128 col[4][4];
+		for ( int c = 0; c < 4; c++ )
+		{
+			__m128 r0 = _mm_load_ps( &batch.m[0][c][i] );
+			__m128 r1 = _mm_load_ps( &batch.m[1][c][i] );
+			__m128 r2 = _mm_load_ps( &batch.m[2][c][i] );
+			__m128 r3 = _mm_set1_ps( c == 3 ? 1.f : 0.f );
+			_MM_TRANSPOSE4_PS( r0, r1, r2, r3 );
+			col[c][0] = r0; col[c][1] = r1; col[c][2] = r2; col[c][3] = r3;
+		}
+
+		for ( uint32_t d = 0; d < 4; d++ )
+		{
+			if ( !( unGroupMask & ( 1u << d ) ) )
+				continue;
+			for ( int c = 0; c < 4; c++ )
+				_mm_storeu_ps( prflOut[ i + d ] + c * 4, col[c][d] );
+		}
+	}
+#else
+	for ( uint32_t i = 0; i < k_unPoseBatchCapacity; i++ )
+	{
+		if ( mask & ( (TrackedDeviceMask_t)1 << i ) )
+			PoseBatch_ToColumnMajor44( PoseBatch_GetMatrix( batch, i ), prflOut[i] );
+	}
+#endif
+}
+
+} // namespace vr
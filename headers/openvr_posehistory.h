@@ -0,0 +1,306 @@
+//========= Copyright Valve Corporation ============//
+// openvr_posehistory.h
+//
+// Header-only, fixed capacity history of tracked device poses. One thread
+// records every WaitGetPoses or GetDeviceToAbsoluteTrackingPose result with a
+// monotonic timestamp, and any number of other threads can ask for a device's
+// pose at an arbitrary past time without taking a lock. This lets camera frames,
+// input events (eventAgeSeconds) and frame timings be matched to the pose that
+// was current when they happened.
+#pragma once
+
+#include "openvr.h"
+#include "openvr_clock.h"
+
+#include <atomic>
+#include <math.h>
+#include <string.h>
+
+namespace vr
+{
+
+/** Linearly interpolates two rigid transforms: translation is lerped and rotation slerped */
+inline HmdMatrix34_t PoseHistory_InterpolateMatrix( const HmdMatrix34_t &a, const HmdMatrix34_t &b, float flFraction )
+{
+	struct Quat { double w, x, y, z; };
+	struct Local
+	{
+		static Quat FromMatrix( const HmdMatrix34_t &m )
+		{
+			Quat q;
+			double flTrace = m.m[0][0] + m.m[1][1] + m.m[2][2];
+			if ( flTrace > 0 )
+			{
+				double s = 0.5 / sqrt( flTrace + 1.0 );
+				q.w = 0.25 / s;
+				q.x = ( m.m[2][1] - m.m[1][2] ) * s;
+				q.y = ( m.m[0][2] - m.m[2][0] ) * s;
+				q.z = ( m.m[1][0] - m.m[0][1] ) * s;
+			}
+			else if ( m.m[0][0] > m.m[1][1] && m.m[0][0] > m.m[2][2] )
+			{
+				double s = 2.0 * sqrt( 1.0 + m.m[0][0] - m.m[1][1] - m.m[2][2] );
+				q.w = ( m.m[2][1] - m.m[1][2] ) / s;
+				q.x = 0.25 * s;
+				q.y = ( m.m[0][1] + m.m[1][0] ) / s;
+				q.z = ( m.m[0][2] + m.m[2][0] ) / s;
+			}
+			else if ( m.m[1][1] > m.m[2][2] )
+			{
+				double s = 2.0 * sqrt( 1.0 + m.m[1][1] - m.m[0][0] - m.m[2][2] );
+				q.w = ( m.m[0][2] - m.m[2][0] ) / s;
+				q.x = ( m.m[0][1] + m.m[1][0] ) / s;
+				q.y = 0.25 * s;
+				q.z = ( m.m[1][2] + m.m[2][1] ) / s;
+			}
+			else
+			{
+				double s = 2.0 * sqrt( 1.0 + m.m[2][2] - m.m[0][0] - m.m[1][1] );
+				q.w = ( m.m[1][0] - m.m[0][1] ) / s;
+				q.x = ( m.m[0][2] + m.m[2][0] ) / s;
+				q.y = ( m.m[1][2] + m.m[2][1] ) / s;
+				q.z = 0.25 * s;
+			}
+			return q;
+		}
+	};
+
+	Quat qa = Local::FromMatrix( a );
+	Quat qb = Local::FromMatrix( b );
+
+	// take the short way around
+	double flDot = qa.w * qb.w + qa.x * qb.x + qa.y * qb.y + qa.z * qb.z;
+	if ( flDot < 0 )
+	{
+		qb.w = -qb.w; qb.x = -qb.x; qb.y = -qb.y; qb.z = -qb.z;
+		flDot = -flDot;
+	}
+
+	double flWeightA, flWeightB;
+	if ( flDot > 0.9995 )
+	{
+		// nearly parallel, a normalized lerp is accurate and avoids dividing by sin(~0)
+		flWeightA = 1.0 - flFraction;
+		flWeightB = flFraction;
+	}
+	else
+	{
+		double flTheta = acos( flDot );
+		double flSinTheta = sin( flTheta );
+		flWeightA = sin( ( 1.0 - flFraction ) * flTheta ) / flSinTheta;
+		flWeightB = sin( flFraction * flTheta ) / flSinTheta;
+	}
+
+	Quat q;
+	q.w = flWeightA * qa.w + flWeightB * qb.w;
+	q.x = flWeightA * qa.x + flWeightB * qb.x;
+	q.y = flWeightA * qa.y + flWeightB * qb.y;
+	q.z = flWeightA * qa.z + flWeightB * qb.z;
+	double flLen = sqrt( q.w * q.w + q.x * q.x + q.y * q.y + q.z * q.z );
+	q.w /= flLen; q.x /= flLen; q.y /= flLen; q.z /= flLen;
+
+	HmdMatrix34_t out;
+	out.m[0][0] = (float)( 1 - 2 * ( q.y * q.y + q.z * q.z ) );
+	out.m[0][1] = (float)( 2 * ( q.x * q.y - q.w * q.z ) );
+	out.m[0][2] = (float)( 2 * ( q.x * q.z + q.w * q.y ) );
+	out.m[1][0] = (float)( 2 * ( q.x * q.y + q.w * q.z ) );
+	out.m[1][1] = (float)( 1 - 2 * ( q.x * q.x + q.z * q.z ) );
+	out.m[1][2] = (float)( 2 * ( q.y * q.z - q.w * q.x ) );
+	out.m[2][0] = (float)( 2 * ( q.x * q.z - q.w * q.y ) );
+	out.m[2][1] = (float)( 2 * ( q.y * q.z + q.w * q.x ) );
+	out.m[2][2] = (float)( 1 - 2 * ( q.x * q.x + q.y * q.y ) );
+	for ( int r = 0; r < 3; r++ )
+		out.m[r][3] = a.m[r][3] + ( b.m[r][3] - a.m[r][3] ) * flFraction;
+	return out;
+}
+
+/** Interpolates two poses of the same device. Velocities are lerped, the flags come from a. */
+inline TrackedDevicePose_t PoseHistory_InterpolatePose( const TrackedDevicePose_t &a, const TrackedDevicePose_t &b, float flFraction )
+{
+	TrackedDevicePose_t out = a;
+	out.mDeviceToAbsoluteTracking = PoseHistory_InterpolateMatrix( a.mDeviceToAbsoluteTracking, b.mDeviceToAbsoluteTracking, flFraction );
+	for ( int k = 0; k < 3; k++ )
+	{
+		out.vVelocity.v[k] = a.vVelocity.v[k] + ( b.vVelocity.v[k] - a.vVelocity.v[k] ) * flFraction;
+		out.vAngularVelocity.v[k] = a.vAngularVelocity.v[k] + ( b.vAngularVelocity.v[k] - a.vAngularVelocity.v[k] ) * flFraction;
+	}
+	return out;
+}
+
+
+/** Lock-free ring of the last unCapacity pose sets.
+*
+* Record must only ever be called from one thread at a time. GetPoseAtTime can be called from
+* any number of threads concurrently with Record. Each slot is guarded by a sequence number, so
+* a reader that races with the writer overwriting the slot it is reading just retries.
+*
+* Timestamps must come from one monotonic clock, GetMonotonicSeconds from openvr_clock.h is the default.
+* To look up the pose for an event, use GetMonotonicSeconds() - eventAgeSeconds. */
+template< uint32_t unCapacity >
+class CVRPoseHistory
+{
+	static_assert( unCapacity >= 4 && ( unCapacity & ( unCapacity - 1 ) ) == 0, "CVRPoseHistory capacity must be a power of two of at least 4" );
+
+public:
+	CVRPoseHistory()
+		: m_ulWriteCount( 0 )
+	{
+		for ( uint32_t i = 0; i < unCapacity; i++ )
+		{
+			m_rSlots[i].ulSequence.store( 0, std::memory_order_relaxed );
+			m_rSlots[i].flTimestamp.store( 0.0, std::memory_order_relaxed );
+		}
+	}
+
+	/** Appends a pose set. Timestamps must not go backwards. Writer thread only. */
+	void Record( double flTimestampSeconds, const TrackedDevicePose_t *pPoses, uint32_t unPoseCount )
+	{
+		uint64_t ulIndex = m_ulWriteCount.load( std::memory_order_relaxed );
+		Slot_t &slot = m_rSlots[ ulIndex & ( unCapacity - 1 ) ];
+
+		// odd while the slot is being written
+		slot.ulSequence.store( ( ( ulIndex + 1 ) << 1 ) | 1, std::memory_order_relaxed );
+		std::atomic_thread_fence( std::memory_order_release );
+
+		slot.flTimestamp.store( flTimestampSeconds, std::memory_order_relaxed );
+		uint32_t unCount = unPoseCount < k_unMaxTrackedDeviceCount ? unPoseCount : k_unMaxTrackedDeviceCount;
+		memcpy( slot.rPoses, pPoses, unCount * sizeof( TrackedDevicePose_t ) );
+		memset( slot.rPoses + unCount, 0, ( k_unMaxTrackedDeviceCount - unCount ) * sizeof( TrackedDevicePose_t ) );
+
+		slot.ulSequence.store( ( ulIndex + 1 ) << 1, std::memory_order_release );
+		m_ulWriteCount.store( ulIndex + 1, std::memory_order_release );
+	}
+
+	/** Returns the device's pose at the given time, interpolated between the two recorded samples
+	* around it. Times after the newest sample return the newest pose. Returns false if nothing has
+	* been recorded, the time is older than the history, or the device has no valid pose there. */
+	bool GetPoseAtTime( TrackedDeviceIndex_t unDevice, double flTimestampSeconds, TrackedDevicePose_t *pOutPose ) const
+	{
+		if ( unDevice >= k_unMaxTrackedDeviceCount )
+			return false;
+
+		for ( ;; )
+		{
+			uint64_t ulWriteCount = m_ulWriteCount.load( std::memory_order_acquire );
+			if ( ulWriteCount == 0 )
+				return false;
+
+			uint64_t ulNewest = ulWriteCount - 1;
+			uint64_t ulOldest = ulWriteCount > unCapacity ? ulWriteCount - unCapacity : 0;
+
+			double flTime;
+			if ( !ReadTimestamp( ulNewest, &flTime ) )
+				continue;
+
+			if ( flTimestampSeconds >= flTime )
+			{
+				TrackedDevicePose_t pose;
+				if ( !ReadPose( ulNewest, unDevice, &pose ) )
+					continue;
+				if ( !pose.bPoseIsValid )
+					return false;
+				*pOutPose = pose;
+				return true;
+			}
+
+			// binary search for the last sample at or before the requested time
+			uint64_t ulLow = ulOldest, ulHigh = ulNewest;
+			bool bRaced = false;
+			while ( ulLow < ulHigh )
+			{
+				uint64_t ulMid = ulLow + ( ulHigh - ulLow ) / 2;
+				if ( !ReadTimestamp( ulMid, &flTime ) )
+				{
+					bRaced = true;
+					break;
+				}
+
+				if ( flTime <= flTimestampSeconds )
+					ulLow = ulMid + 1;
+				else
+					ulHigh = ulMid;
+			}
+			if ( bRaced )
+				continue;
+
+			// ulLow is the first sample after the requested time
+			if ( ulLow == ulOldest )
+				return false;
+
+			uint64_t ulBefore = ulLow - 1;
+			double flTimeBefore, flTimeAfter;
+			TrackedDevicePose_t poseBefore, poseAfter;
+			if ( !ReadTimestamp( ulBefore, &flTimeBefore ) || !ReadTimestamp( ulLow, &flTimeAfter )
+				|| !ReadPose( ulBefore, unDevice, &poseBefore ) || !ReadPose( ulLow, unDevice, &poseAfter ) )
+			{
+				continue;
+			}
+
+			if ( poseBefore.bPoseIsValid && poseAfter.bPoseIsValid )
+			{
+				double flSpan = flTimeAfter - flTimeBefore;
+				float flFraction = flSpan > 0 ? (float)( ( flTimestampSeconds - flTimeBefore ) / flSpan ) : 0.f;
+				*pOutPose = PoseHistory_InterpolatePose( poseBefore, poseAfter, flFraction );
+				return true;
+			}
+
+			// only one side is valid, use it if it is the nearer one
+			bool bBeforeIsNearer = ( flTimestampSeconds - flTimeBefore ) <= ( flTimeAfter - flTimestampSeconds );
+			const TrackedDevicePose_t &nearest = bBeforeIsNearer ? poseBefore : poseAfter;
+			if ( !nearest.bPoseIsValid )
+				return false;
+			*pOutPose = nearest;
+			return true;
+		}
+	}
+
+	/** Returns the time range currently covered by the history. Returns false if it is empty. */
+	bool GetTimeRange( double *pflOldestSeconds, double *pflNewestSeconds ) const
+	{
+		for ( ;; )
+		{
+			uint64_t ulWriteCount = m_ulWriteCount.load( std::memory_order_acquire );
+			if ( ulWriteCount == 0 )
+				return false;
+
+			uint64_t ulOldest = ulWriteCount > unCapacity ? ulWriteCount - unCapacity : 0;
+			if ( ReadTimestamp( ulOldest, pflOldestSeconds ) && ReadTimestamp( ulWriteCount - 1, pflNewestSeconds ) )
+				return true;
+		}
+	}
+
+private:
+	struct Slot_t
+	{
+		std::atomic< uint64_t > ulSequence;
+		std::atomic< double > flTimestamp;
+		TrackedDevicePose_t rPoses[ k_unMaxTrackedDeviceCount ];
+	};
+
+	bool ReadTimestamp( uint64_t ulIndex, double *pflTimestamp ) const
+	{
+		const Slot_t &slot = m_rSlots[ ulIndex & ( unCapacity - 1 ) ];
+		uint64_t ulExpected = ( ulIndex + 1 ) << 1;
+		if ( slot.ulSequence.load( std::memory_order_acquire ) != ulExpected )
+			return false;
+		*pflTimestamp = slot.flTimestamp.load( std::memory_order_relaxed );
+		std::atomic_thread_fence( std::memory_order_acquire );
+		return slot.ulSequence.load( std::memory_order_relaxed ) == ulExpected;
+	}
+
+	bool ReadPose( uint64_t ulIndex, TrackedDeviceIndex_t unDevice, TrackedDevicePose_t *pPose ) const
+	{
+		const Slot_t &slot = m_rSlots[ ulIndex & ( unCapacity - 1 ) ];
+		uint64_t ulExpected = ( ulIndex + 1 ) << 1;
+		if ( slot.ulSequence.load( std::memory_order_acquire ) != ulExpected )
+			return false;
+		memcpy( pPose, &slot.rPoses[ unDevice ], sizeof( TrackedDevicePose_t ) );
+		std::atomic_thread_fence( std::memory_order_acquire );
+		return slot.ulSequence.load( std::memory_order_relaxed ) == ulExpected;
+	}
+
+	std::atomic< uint64_t > m_ulWriteCount;
+	Slot_t m_rSlots[ unCapacity ];
+};
+
+} // namespace vr
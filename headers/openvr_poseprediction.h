@@ -0,0 +1,193 @@
+//========= Copyright Valve Corporation ============//
+// openvr_poseprediction.h
+//
+// Header-only client side pose extrapolation. Given one set of poses from
+// WaitGetPoses or GetDeviceToAbsoluteTrackingPose this predicts every device
+// to any number of target times in one pass, without another call into the
+// runtime per prediction time. Linear motion is integrated to second order
+// and rotation through the quaternion exponential of the rotation vector.
+#pragma once
+
+#include "openvr_posebatch.h"
+
+#include <math.h>
+
+namespace vr
+{
+
+/** Kinematic state of every device slot as a structure of arrays. Velocities and accelerations
+* are in tracking space, in m/s, m/s^2, rad/s and rad/s^2. */
+struct VR_POSEBATCH_ALIGN PosePredictionState_t
+{
+	PoseBatchMatrices_t mDeviceToAbsoluteTracking;
+	float vVelocity[3][ k_unPoseBatchCapacity ];
+	float vAngularVelocity[3][ k_unPoseBatchCapacity ];
+	float vAcceleration[3][ k_unPoseBatchCapacity ];
+	float vAngularAcceleration[3][ k_unPoseBatchCapacity ];
+
+	/** Slots that hold a valid pose. Everything else is identity at rest. */
+	TrackedDeviceMask_t validMask;
+};
+
+/** Fills the prediction state from a pose array. Accelerations are zeroed, use
+* PosePrediction_SetAcceleration to add them for devices that report them. */
+inline void PosePrediction_Gather( const TrackedDevicePose_t *pPoses, uint32_t unPoseCount, TrackedDeviceMask_t mask, PosePredictionState_t *pState )
+{
+	PoseBatch_Gather( pPoses, unPoseCount, mask, &pState->mDeviceToAbsoluteTracking );
+	pState->validMask = 0;
+	for ( uint32_t i = 0; i < k_unPoseBatchCapacity; i++ )
+	{
+		bool bValid = i < unPoseCount && ( mask & ( (TrackedDeviceMask_t)1 << i ) );
+		if ( bValid )
+			pState->validMask |= (TrackedDeviceMask_t)1 << i;
+
+		for ( int k = 0; k < 3; k++ )
+		{
+			pState->vVelocity[k][i] = bValid ? pPoses[i].vVelocity.v[k] : 0.f;
+			pState->vAngularVelocity[k][i] = bValid ? pPoses[i].vAngularVelocity.v[k] : 0.f;
+			pState->vAcceleration[k][i] = 0.f;
+			pState->vAngularAcceleration[k][i] = 0.f;
+		}
+	}
+}
+
+/** Sets the linear and angular acceleration of one slot, e.g. from a DriverPose_t or an app side
+* estimate. Slots without a valid pose stay at rest. */
+inline void PosePrediction_SetAcceleration( PosePredictionState_t *pState, TrackedDeviceIndex_t unDevice, const HmdVector3_t &vAcceleration, const HmdVector3_t &vAngularAcceleration )
+{
+	if ( unDevice >= k_unPoseBatchCapacity || !( pState->validMask & ( (TrackedDeviceMask_t)1 << unDevice ) ) )
+		return;
+
+	for ( int k = 0; k < 3; k++ )
+	{
+		pState->vAcceleration[k][ unDevice ] = vAcceleration.v[k];
+		pState->vAngularAcceleration[k][ unDevice ] = vAngularAcceleration.v[k];
+	}
+}
+
+/** Predicts every slot to each of the unTimeCount offsets (in seconds from the time the state
+* was sampled) and writes the matrices to pOut[ 0 .. unTimeCount-1 ].
+*
+* Position is p + v*t + a*t^2/2. The rotation change is the rotation vector w*t + alpha*t^2/2
+* turned into a quaternion and applied on the left, which is exact for constant angular velocity
+* and a first order approximation when angular acceleration is present. */
+inline void PosePrediction_Predict( const PosePredictionState_t &state, const float *pflSecondsFromSample, uint32_t unTimeCount, PoseBatchMatrices_t *pOut )
+{
+	using namespace posebatch_internal;
+
+	VR_POSEBATCH_ALIGN float rflScale[ k_unPoseBatchCapacity ];
+	VR_POSEBATCH_ALIGN float rflQuatW[ k_unPoseBatchCapacity ];
+
+	for ( uint32_t t = 0; t < unTimeCount; t++ )
+	{
+		const float flTime = pflSecondsFromSample[t];
+		const Lanes_t lTime = Splat( flTime );
+		const Lanes_t lHalfTimeSq = Splat( 0.5f * flTime * flTime );
+		PoseBatchMatrices_t &out = pOut[t];
+
+		// rotation vector per lane, and the quaternion terms that need transcendentals
+		VR_POSEBATCH_ALIGN float rflRotVec[3][ k_unPoseBatchCapacity ];
+		for ( uint32_t i = 0; i < k_unPoseBatchCapacity; i += k_unLaneWidth )
+		{
+			for ( int k = 0; k < 3; k++ )
+			{
+				Lanes_t lPhi = Add( Mul( Load( &state.vAngularVelocity[k][i] ), lTime ), Mul( Load( &state.vAngularAcceleration[k][i] ), lHalfTimeSq ) );
+				Store( &rflRotVec[k][i], lPhi );
+			}
+		}
+
+		for ( uint32_t i = 0; i < k_unPoseBatchCapacity; i++ )
+		{
+			float flThetaSq = rflRotVec[0][i] * rflRotVec[0][i] + rflRotVec[1][i] * rflRotVec[1][i] + rflRotVec[2][i] * rflRotVec[2][i];
+			if ( flThetaSq < 1e-8f )
+			{
+				// sin(x/2)/x and cos(x/2) by their Taylor series near zero
+				rflScale[i] = 0.5f - flThetaSq * ( 1.f / 48.f );
+				rflQuatW[i] = 1.f - flThetaSq * 0.125f;
+			}
+			else
+			{
+				float flTheta = sqrtf( flThetaSq );
+				rflScale[i] = sinf( 0.5f * flTheta ) / flTheta;
+				rflQuatW[i] = cosf( 0.5f * flTheta );
+			}
+		}
+
+		const Lanes_t lOne = Splat( 1.f );
+		const Lanes_t lTwo = Splat( 2.f );
+		for ( uint32_t i = 0; i < k_unPoseBatchCapacity; i += k_unLaneWidth )
+		{
+			Lanes_t lScale = Load( &rflScale[i] );
+			Lanes_t w = Load( &rflQuatW[i] );
+			Lanes_t x = Mul( Load( &rflRotVec[0][i] ), lScale );
+			Lanes_t y = Mul( Load( &rflRotVec[1][i] ), lScale );
+			Lanes_t z = Mul( Load( &rflRotVec[2][i] ), lScale );
+
+			Lanes_t xx = Mul( x, x ), yy = Mul( y, y ), zz = Mul( z, z );
+			Lanes_t xy = Mul( x, y ), xz = Mul( x, z ), yz = Mul( y, z );
+			Lanes_t wx = Mul( w, x ), wy = Mul( w, y ), wz = Mul( w, z );
+
+			Lanes_t d[3][3];
+			d[0][0] = Sub( lOne, Mul( lTwo, Add( yy, zz ) ) );
+			d[0][1] = Mul( lTwo, Sub( xy, wz ) );
+			d[0][2] = Mul( lTwo, Add( xz, wy ) );
+			d[1][0] = Mul( lTwo, Add( xy, wz ) );
+			d[1][1] = Sub( lOne, Mul( lTwo, Add( xx, zz ) ) );
+			d[1][2] = Mul( lTwo, Sub( yz, wx ) );
+			d[2][0] = Mul( lTwo, Sub( xz, wy ) );
+			d[2][1] = Mul( lTwo, Add( yz, wx ) );
+			d[2][2] = Sub( lOne, Mul( lTwo, Add( xx, yy ) ) );
+
+			Lanes_t m[3][3];
+			for ( int r = 0; r < 3; r++ )
+				for ( int c = 0; c < 3; c++ )
+					m[r][c] = Load( &state.mDeviceToAbsoluteTracking.m[r][c][i] );
+
+			for ( int r = 0; r < 3; r++ )
+			{
+				for ( int c = 0; c < 3; c++ )
+				{
+					Lanes_t v = Add( Add( Mul( d[r][0], m[0][c] ), Mul( d[r][1], m[1][c] ) ), Mul( d[r][2], m[2][c] ) );
+					Store( &out.m[r][c][i], v );
+				}
+
+				Lanes_t p = Load( &state.mDeviceToAbsoluteTracking.m[r][3][i] );
+				p = Add( p, Mul( Load( &state.vVelocity[r][i] ), lTime ) );
+				p = Add( p, Mul( Load( &state.vAcceleration[r][i] ), lHalfTimeSq ) );
+				Store( &out.m[r][3][i], p );
+			}
+		}
+	}
+}
+
+/** Convenience for a single target time that produces a pose array in the same shape as
+* GetDeviceToAbsoluteTrackingPose. Velocities are advanced by the accelerations and the
+* tracking result and validity flags are copied from the poses the state was gathered from. */
+inline void PosePrediction_PredictPoses( const PosePredictionState_t &state, const TrackedDevicePose_t *pSourcePoses, float flSecondsFromSample, TrackedDevicePose_t *pOutPoses, uint32_t unPoseCount )
+{
+	PoseBatchMatrices_t predicted;
+	PosePrediction_Predict( state, &flSecondsFromSample, 1, &predicted );
+	for ( uint32_t i = 0; i < unPoseCount && i < k_unPoseBatchCapacity; i++ )
+	{
+		TrackedDevicePose_t &pose = pOutPoses[i];
+		pose.eTrackingResult = pSourcePoses[i].eTrackingResult;
+		pose.bPoseIsValid = pSourcePoses[i].bPoseIsValid;
+		pose.bDeviceIsConnected = pSourcePoses[i].bDeviceIsConnected;
+		if ( !( state.validMask & ( (TrackedDeviceMask_t)1 << i ) ) )
+		{
+			pose.mDeviceToAbsoluteTracking = pSourcePoses[i].mDeviceToAbsoluteTracking;
+			pose.vVelocity = pSourcePoses[i].vVelocity;
+			pose.vAngularVelocity = pSourcePoses[i].vAngularVelocity;
+			continue;
+		}
+
+		pose.mDeviceToAbsoluteTracking = PoseBatch_GetMatrix( predicted, i );
+		for ( int k = 0; k < 3; k++ )
+		{
+			pose.vVelocity.v[k] = state.vVelocity[k][i] + state.vAcceleration[k][i] * flSecondsFromSample;
+			pose.vAngularVelocity.v[k] = state.vAngularVelocity[k][i] + state.vAngularAcceleration[k][i] * flSecondsFromSample;
+		}
+	}
+}
+
+} // namespace vr
@@ -0,0 +1,331 @@
+//========= Copyright Valve Corporation ============//
+// openvr_rendermodelloader.h
+//
+// Header-only asynchronous render model and texture loading.
+// IVRRenderModels::LoadRenderModel_Async and LoadTexture_Async have to be
+// called again and again until they stop returning VRRenderModelError_Loading,
+// which usually ends up as a sleep loop on the render thread. This takes
+// requests from any thread, merges requests for the same model name or texture
+// id, polls everything outstanding from one worker thread that backs off while
+// nothing finishes, and delivers results through futures or callbacks.
+#pragma once
+
+#include "openvr.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <future>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace vr
+{
+
+struct VRRenderModelLoadResult_t
+{
+	EVRRenderModelError eError;
+	RenderModel_t *pRenderModel;		// owned by the loader, valid until it is destroyed or FreeAll is called
+};
+
+struct VRTextureLoadResult_t
+{
+	EVRRenderModelError eError;
+	RenderModel_TextureMap_t *pTexture;	// owned by the loader, valid until it is destroyed or FreeAll is called
+};
+
+/** Called on the loader's worker thread, so keep it short and don't make GL or D3D calls from it */
+typedef void ( *VRRenderModelLoadedFn_t )( void *pContext, const char *pchRenderModelName, const VRRenderModelLoadResult_t &result );
+typedef void ( *VRTextureLoadedFn_t )( void *pContext, TextureID_t textureId, const VRTextureLoadResult_t &result );
+
+class CVRRenderModelLoader
+{
+public:
+	/** The worker waits unMinPollIntervalMs between polls, doubling up to unMaxPollIntervalMs while no load finishes */
+	explicit CVRRenderModelLoader( IVRRenderModels *pRenderModels, uint32_t unMinPollIntervalMs = 1, uint32_t unMaxPollIntervalMs = 16 )
+		: m_pRenderModels( pRenderModels ), m_unMinPollIntervalMs( unMinPollIntervalMs ), m_unMaxPollIntervalMs( unMaxPollIntervalMs ),
+		m_bQuit( false ), m_bNewRequest( false ), m_unOutstanding( 0 ), m_ulRuntimePolls( 0 ), m_ulMergedRequests( 0 )
+	{
+		m_thread = std::thread( &CVRRenderModelLoader::WorkerThread, this );
+	}
+
+	/** Requests still loading complete with VRRenderModelError_NotSupported, and everything loaded is freed */
+	~CVRRenderModelLoader()
+	{
+		{
+			std::lock_guard< std::mutex > lock( m_mutex );
+			m_bQuit = true;
+		}
+		m_wake.notify_one();
+		m_thread.join();
+		FreeAll();
+	}
+
+	/** Starts loading a render model, or joins the load already under way for the same name. Loaded
+	* models are kept, so asking again returns a ready future. Failed loads are not kept and the next
+	* request tries again. If a callback is given it runs once the load finishes, on the worker thread,
+	* or right away on the calling thread if the model is already loaded. */
+	std::shared_future< VRRenderModelLoadResult_t > RequestRenderModel( const char *pchRenderModelName, VRRenderModelLoadedFn_t pfnCallback = nullptr, void *pContext = nullptr )
+	{
+		return Request( m_mapModels, std::string( pchRenderModelName ), pfnCallback, pContext );
+	}
+
+	/** Same as RequestRenderModel, for the diffuse textures referenced by RenderModel_t::diffuseTextureId */
+	std::shared_future< VRTextureLoadResult_t > RequestTexture( TextureID_t textureId, VRTextureLoadedFn_t pfnCallback = nullptr, void *pContext = nullptr )
+	{
+		return Request( m_mapTextures, textureId, pfnCallback, pContext );
+	}
+
+	/** Frees every loaded model and texture. Results handed out earlier become invalid. Requests still
+	* loading are not affected. */
+	void FreeAll()
+	{
+		std::lock_guard< std::mutex > lock( m_mutex );
+		for ( ModelMap_t::iterator iter = m_mapModels.begin(); iter != m_mapModels.end(); )
+		{
+			if ( !iter->second.bDone )
+			{
+				++iter;
+				continue;
+			}
+			if ( iter->second.result.pRenderModel )
+				m_pRenderModels->FreeRenderModel( iter->second.result.pRenderModel );
+			iter = m_mapModels.erase( iter );
+		}
+		for ( TextureMap_t::iterator iter = m_mapTextures.begin(); iter != m_mapTextures.end(); )
+		{
+			if ( !iter->second.bDone )
+			{
+				++iter;
+				continue;
+			}
+			if ( iter->second.result.pTexture )
+				m_pRenderModels->FreeTexture( iter->second.result.pTexture );
+			iter = m_mapTextures.erase( iter );
+		}
+	}
+
+	/** Calls made to LoadRenderModel_Async and LoadTexture_Async so far */
+	uint64_t GetRuntimePollCount() const { std::lock_guard< std::mutex > lock( m_mutex ); return m_ulRuntimePolls; }
+
+	/** Requests that joined a load already under way or already finished */
+	uint64_t GetMergedRequestCount() const { std::lock_guard< std::mutex > lock( m_mutex ); return m_ulMergedRequests; }
+
+private:
+	template< typename TResult, typename TCallback >
+	struct Load_t
+	{
+		typedef TResult result_type;
+		typedef TCallback callback_type;
+
+		Load_t() : bDone( false ), result() {}
+
+		bool bDone;
+		TResult result;
+		std::promise< TResult > promise;
+		std::shared_future< TResult > future;
+		std::vector< std::pair< TCallback, void * > > vecCallbacks;
+	};
+	typedef Load_t< VRRenderModelLoadResult_t, VRRenderModelLoadedFn_t > ModelLoad_t;
+	typedef Load_t< VRTextureLoadResult_t, VRTextureLoadedFn_t > TextureLoad_t;
+	typedef std::map< std::string, ModelLoad_t > ModelMap_t;
+	typedef std::map< TextureID_t, TextureLoad_t > TextureMap_t;
+
+	/** A callback to run once the lock is released. Key and result are copies, so FreeAll or a retry
+	* erasing the entry in the meantime doesn't matter. */
+	template< typename TKey, typename TLoad >
+	struct Completion_t
+	{
+		TKey key;
+		typename TLoad::result_type result;
+		typename TLoad::callback_type pfnCallback;
+		void *pContext;
+	};
+	typedef Completion_t< std::string, ModelLoad_t > ModelCompletion_t;
+	typedef Completion_t< TextureID_t, TextureLoad_t > TextureCompletion_t;
+
+	template< typename TMap, typename TKey >
+	std::shared_future< typename TMap::mapped_type::result_type > Request( TMap &map, const TKey &key, typename TMap::mapped_type::callback_type pfnCallback, void *pContext );
+
+	EVRRenderModelError Poll( const std::string &sName, VRRenderModelLoadResult_t *pResult )
+	{
+		pResult->pRenderModel = nullptr;
+		return m_pRenderModels->LoadRenderModel_Async( sName.c_str(), &pResult->pRenderModel );
+	}
+
+	EVRRenderModelError Poll( TextureID_t textureId, VRTextureLoadResult_t *pResult )
+	{
+		pResult->pTexture = nullptr;
+		return m_pRenderModels->LoadTexture_Async( textureId, &pResult->pTexture );
+	}
+
+	static void Notify( const ModelCompletion_t &completion )
+	{
+		completion.pfnCallback( completion.pContext, completion.key.c_str(), completion.result );
+	}
+
+	static void Notify( const TextureCompletion_t &completion )
+	{
+		completion.pfnCallback( completion.pContext, completion.key, completion.result );
+	}
+
+	/** Polls every outstanding load in one map and completes the ones that finished. Their callbacks are
+	* queued in pvecCompletions to run after the lock is released. Returns how many finished. */
+	template< typename TMap, typename TCompletion >
+	uint32_t PollMap( TMap &map, std::vector< TCompletion > *pvecCompletions )
+	{
+		uint32_t unFinished = 0;
+		for ( typename TMap::iterator iter = map.begin(); iter != map.end(); )
+		{
+			typename TMap::mapped_type &load = iter->second;
+			if ( load.bDone )
+			{
+				++iter;
+				continue;
+			}
+
+			typename TMap::mapped_type::result_type result = typename TMap::mapped_type::result_type();
+			if ( m_bQuit )
+			{
+				result.eError = VRRenderModelError_NotSupported;
+			}
+			else
+			{
+				m_ulRuntimePolls++;
+				result.eError = Poll( iter->first, &result );
+				if ( result.eError == VRRenderModelError_Loading )
+				{
+					++iter;
+					continue;
+				}
+			}
+
+			load.bDone = true;
+			load.result = result;
+			load.promise.set_value( result );
+			for ( size_t i = 0; i < load.vecCallbacks.size(); i++ )
+			{
+				TCompletion completion = { iter->first, result, load.vecCallbacks[ i ].first, load.vecCallbacks[ i ].second };
+				pvecCompletions->push_back( completion );
+			}
+			unFinished++;
+
+			// only successful loads are kept; the future already holds the error for anyone waiting
+			if ( result.eError != VRRenderModelError_None )
+				iter = map.erase( iter );
+			else
+				++iter;
+		}
+		return unFinished;
+	}
+
+	void WorkerThread()
+	{
+		uint32_t unIntervalMs = m_unMinPollIntervalMs;
+		std::vector< ModelCompletion_t > vecModelCompletions;
+		std::vector< TextureCompletion_t > vecTextureCompletions;
+		std::unique_lock< std::mutex > lock( m_mutex );
+		for ( ;; )
+		{
+			bool bQuit = m_bQuit;
+			uint32_t unFinished = PollMap( m_mapModels, &vecModelCompletions ) + PollMap( m_mapTextures, &vecTextureCompletions );
+			m_unOutstanding -= unFinished;
+
+			if ( !vecModelCompletions.empty() || !vecTextureCompletions.empty() )
+			{
+				lock.unlock();
+				for ( size_t i = 0; i < vecModelCompletions.size(); i++ )
+					Notify( vecModelCompletions[ i ] );
+				for ( size_t i = 0; i < vecTextureCompletions.size(); i++ )
+					Notify( vecTextureCompletions[ i ] );
+				vecModelCompletions.clear();
+				vecTextureCompletions.clear();
+				lock.lock();
+			}
+
+			if ( bQuit )
+				return;
+
+			if ( m_unOutstanding == 0 )
+			{
+				// nothing to poll, sleep until there is
+				m_wake.wait( lock, [this]() { return m_bQuit || m_unOutstanding != 0; } );
+				m_bNewRequest = false;
+				unIntervalMs = m_unMinPollIntervalMs;
+				continue;
+			}
+
+			// back off while nothing finishes, go back to polling quickly once something does or a new request comes in
+			if ( unFinished )
+				unIntervalMs = m_unMinPollIntervalMs;
+			else if ( unIntervalMs * 2 < m_unMaxPollIntervalMs )
+				unIntervalMs *= 2;
+			else
+				unIntervalMs = m_unMaxPollIntervalMs;
+
+			m_wake.wait_for( lock, std::chrono::milliseconds( unIntervalMs ), [this]() { return m_bQuit || m_bNewRequest; } );
+			if ( m_bNewRequest )
+			{
+				m_bNewRequest = false;
+				unIntervalMs = m_unMinPollIntervalMs;
+			}
+		}
+	}
+
+	IVRRenderModels *m_pRenderModels;
+	uint32_t m_unMinPollIntervalMs;
+	uint32_t m_unMaxPollIntervalMs;
+
+	mutable std::mutex m_mutex;
+	std::condition_variable m_wake;
+	bool m_bQuit;
+	bool m_bNewRequest;
+	uint32_t m_unOutstanding;
+	ModelMap_t m_mapModels;
+	TextureMap_t m_mapTextures;
+	uint64_t m_ulRuntimePolls;
+	uint64_t m_ulMergedRequests;
+	std::thread m_thread;
+};
+
+template< typename TMap, typename TKey >
+std::shared_future< typename TMap::mapped_type::result_type > CVRRenderModelLoader::Request( TMap &map, const TKey &key, typename TMap::mapped_type::callback_type pfnCallback, void *pContext )
+{
+	std::unique_lock< std::mutex > lock( m_mutex );
+	typename TMap::iterator iter = map.find( key );
+	bool bNew = iter == map.end();
+	if ( bNew )
+	{
+		iter = map.insert( std::make_pair( key, typename TMap::mapped_type() ) ).first;
+		iter->second.future = iter->second.promise.get_future().share();
+		m_unOutstanding++;
+		m_bNewRequest = true;
+	}
+	else
+	{
+		m_ulMergedRequests++;
+	}
+
+	std::shared_future< typename TMap::mapped_type::result_type > future = iter->second.future;
+	if ( pfnCallback )
+	{
+		if ( iter->second.bDone )
+		{
+			// already loaded, answer on the calling thread
+			Completion_t< TKey, typename TMap::mapped_type > completion = { key, iter->second.result, pfnCallback, pContext };
+			lock.unlock();
+			Notify( completion );
+			return future;
+		}
+		iter->second.vecCallbacks.push_back( std::make_pair( pfnCallback, pContext ) );
+	}
+
+	lock.unlock();
+	if ( bNew )
+		m_wake.notify_one();
+	return future;
+}
+
+} // namespace vr
@@ -0,0 +1,209 @@
+//========= Copyright Valve Corporation ============//
+// openvr_renderscale.h
+//
+// Header-only adaptive render resolution governor. GetRecommendedRenderTargetSize
+// never changes and ShouldAppRenderWithLowResources is a single flag, so the
+// governor closes the loop itself. It reads the compositor's frame timing each
+// frame and recommends a render scale that keeps GPU time a configurable
+// headroom below the frame budget. Hysteresis stops the scale from
+// oscillating. Step() is a pure function of its inputs, so recorded traces
+// replay deterministically through RenderScaleGovernor_Replay.
+#pragma once
+
+#include "openvr.h"
+
+#include <math.h>
+
+namespace vr
+{
+
+struct VRRenderScaleGovernorSettings_t
+{
+	float flMinScale;				// per axis, relative to GetRecommendedRenderTargetSize
+	float flMaxScale;
+	float flFrameBudgetMs;			// 1000 / display frequency
+	float flHeadroom;				// fraction of the budget to leave free, e.g. 0.1 aims GPU time at 90% of the budget
+	float flHysteresis;				// load band around the target in which the scale is left alone
+	float flMaxStepUp;				// largest relative increase per change, e.g. 0.05
+	float flMaxStepDown;			// largest relative decrease per change, e.g. 0.2
+	uint32_t unFramesBeforeIncrease;	// consecutive frames below the band before scaling up
+	uint32_t unCooldownFrames;		// frames after a change during which no further increase is made
+	float flLoadSmoothing;			// weight of the newest frame in the smoothed GPU load, 0..1
+	float flLowResourceScale;		// cap while ShouldAppRenderWithLowResources is set
+};
+
+/** Sensible defaults for a display running at flDisplayFrequency Hz */
+inline VRRenderScaleGovernorSettings_t RenderScaleGovernor_GetDefaultSettings( float flDisplayFrequency )
+{
+	VRRenderScaleGovernorSettings_t settings;
+	settings.flMinScale = 0.6f;
+	settings.flMaxScale = 1.4f;
+	settings.flFrameBudgetMs = flDisplayFrequency > 0.f ? 1000.f / flDisplayFrequency : 1000.f / 90.f;
+	settings.flHeadroom = 0.1f;
+	settings.flHysteresis = 0.05f;
+	settings.flMaxStepUp = 0.05f;
+	settings.flMaxStepDown = 0.2f;
+	settings.unFramesBeforeIncrease = 45;
+	settings.unCooldownFrames = 10;
+	settings.flLoadSmoothing = 0.2f;
+	settings.flLowResourceScale = 0.8f;
+	return settings;
+}
+
+/** One frame of a recorded trace, i.e. everything Step() looks at */
+struct VRRenderScaleTraceFrame_t
+{
+	Compositor_FrameTiming timing;
+	uint64_t ulVsyncCounter;		// from IVRSystem::GetTimeSinceLastVsync
+	bool bLowResources;				// from IVRCompositor::ShouldAppRenderWithLowResources
+};
+
+class CVRRenderScaleGovernor
+{
+public:
+	explicit CVRRenderScaleGovernor( const VRRenderScaleGovernorSettings_t &settings )
+		: m_settings( settings )
+	{
+		Reset();
+	}
+
+	/** Back to scale 1 with no history */
+	void Reset()
+	{
+		m_flScale = 1.f < m_settings.flMinScale ? m_settings.flMinScale : ( 1.f > m_settings.flMaxScale ? m_settings.flMaxScale : 1.f );
+		m_flSmoothedLoad = -1.f;
+		m_unFramesBelowBand = 0;
+		m_unCooldown = 0;
+		m_bHaveLastFrame = false;
+		m_unLastFrameIndex = 0;
+		m_ulLastVsyncCounter = 0;
+	}
+
+	const VRRenderScaleGovernorSettings_t &GetSettings() const { return m_settings; }
+	float GetScale() const { return m_flScale; }
+
+	/** GPU time over budget, smoothed. 1 means the GPU used the whole frame. */
+	float GetSmoothedLoad() const { return m_flSmoothedLoad < 0.f ? 0.f : m_flSmoothedLoad; }
+
+	/** Feeds one frame and returns the scale to render the next one at. A frame index that was already
+	* seen is ignored. */
+	float Step( const Compositor_FrameTiming &timing, uint64_t ulVsyncCounter, bool bLowResources )
+	{
+		if ( m_bHaveLastFrame && timing.m_nFrameIndex == m_unLastFrameIndex )
+			return m_flScale;
+
+		// vsyncs that passed without a new frame mean we missed at least one
+		bool bMissedVsync = m_bHaveLastFrame && ulVsyncCounter > m_ulLastVsyncCounter + 1;
+		m_bHaveLastFrame = true;
+		m_unLastFrameIndex = timing.m_nFrameIndex;
+		m_ulLastVsyncCounter = ulVsyncCounter;
+
+		float flLoad = timing.m_flTotalRenderGpuMs / m_settings.flFrameBudgetMs;
+		m_flSmoothedLoad = m_flSmoothedLoad < 0.f ? flLoad : m_flSmoothedLoad + ( flLoad - m_flSmoothedLoad ) * m_settings.flLoadSmoothing;
+
+		float flTargetLoad = 1.f - m_settings.flHeadroom;
+
+		// reprojection or late frames caused only by the CPU won't get better at a lower resolution
+		bool bCpuBound = ( timing.m_nReprojectionFlags & VRCompositor_ReprojectionReason_Cpu ) && !( timing.m_nReprojectionFlags & VRCompositor_ReprojectionReason_Gpu );
+		bool bGpuMissed = ( timing.m_nReprojectionFlags & VRCompositor_ReprojectionReason_Gpu )
+			|| ( !bCpuBound && ( timing.m_nNumMisPresented > 0 || bMissedVsync ) );
+
+		float flScale = m_flScale;
+		if ( bGpuMissed || m_flSmoothedLoad > flTargetLoad + m_settings.flHysteresis )
+		{
+			// GPU cost goes with pixel count, i.e. the square of the scale
+			float flLoadForStep = bGpuMissed && m_flSmoothedLoad < 1.f ? 1.f : m_flSmoothedLoad;
+			float flFactor = sqrtf( flTargetLoad / flLoadForStep );
+			if ( flFactor < 1.f - m_settings.flMaxStepDown )
+				flFactor = 1.f - m_settings.flMaxStepDown;
+			flScale *= flFactor;
+		}
+		else if ( m_flSmoothedLoad < flTargetLoad - m_settings.flHysteresis && timing.m_flCompositorIdleCpuMs > 0.f && !bCpuBound )
+		{
+			if ( m_unCooldown == 0 && ++m_unFramesBelowBand >= m_settings.unFramesBeforeIncrease )
+			{
+				float flFactor = m_flSmoothedLoad > 0.f ? sqrtf( flTargetLoad / m_flSmoothedLoad ) : 1.f + m_settings.flMaxStepUp;
+				if ( flFactor > 1.f + m_settings.flMaxStepUp )
+					flFactor = 1.f + m_settings.flMaxStepUp;
+				flScale *= flFactor;
+			}
+		}
+		else
+		{
+			m_unFramesBelowBand = 0;
+		}
+
+		float flMaxScale = bLowResources && m_settings.flLowResourceScale < m_settings.flMaxScale ? m_settings.flLowResourceScale : m_settings.flMaxScale;
+		flScale = flScale < m_settings.flMinScale ? m_settings.flMinScale : ( flScale > flMaxScale ? flMaxScale : flScale );
+		if ( flScale != m_flScale )
+		{
+			// the smoothed load was measured at the old scale; only a step that actually happened moves it
+			float flRatio = flScale / m_flScale;
+			m_flSmoothedLoad *= flRatio * flRatio;
+			m_flScale = flScale;
+			m_unFramesBelowBand = 0;
+			m_unCooldown = m_settings.unCooldownFrames;
+		}
+
+		if ( m_unCooldown > 0 )
+			m_unCooldown--;
+
+		return m_flScale;
+	}
+
+	/** Reads the runtime's timing and steps. Call once per frame after WaitGetPoses. This steps on the
+	* frame before the newest one: the compositor may still present the newest frame again, so its
+	* reprojection flags and mispresent count aren't final yet. */
+	float Update( IVRSystem *pSystem, IVRCompositor *pCompositor )
+	{
+		Compositor_FrameTiming timing;
+		timing.m_nSize = sizeof( Compositor_FrameTiming );
+		if ( !pCompositor->GetFrameTiming( &timing, 1 ) )
+			return m_flScale;
+
+		// the counter is always read one frame after the timing's frame, so differences between
+		// consecutive steps still count the vsyncs between frames
+		float flSecondsSinceLastVsync;
+		uint64_t ulVsyncCounter = 0;
+		pSystem->GetTimeSinceLastVsync( &flSecondsSinceLastVsync, &ulVsyncCounter );
+		return Step( timing, ulVsyncCounter, pCompositor->ShouldAppRenderWithLowResources() );
+	}
+
+private:
+	VRRenderScaleGovernorSettings_t m_settings;
+	float m_flScale;
+	float m_flSmoothedLoad;
+	uint32_t m_unFramesBelowBand;
+	uint32_t m_unCooldown;
+	bool m_bHaveLastFrame;
+	uint32_t m_unLastFrameIndex;
+	uint64_t m_ulLastVsyncCounter;
+};
+
+/** Applies a scale to the recommended render target size, rounding to a multiple of 2 */
+inline void RenderScale_ApplyToSize( float flScale, uint32_t unRecommendedWidth, uint32_t unRecommendedHeight, uint32_t *punWidth, uint32_t *punHeight )
+{
+	*punWidth = ( (uint32_t)( unRecommendedWidth * flScale + 1.f ) ) & ~1u;
+	*punHeight = ( (uint32_t)( unRecommendedHeight * flScale + 1.f ) ) & ~1u;
+}
+
+/** Replays a recorded trace through a freshly reset governor and writes the scale after each frame.
+* The result only depends on the settings and the trace. Returns the number of scale changes. */
+inline uint32_t RenderScaleGovernor_Replay( CVRRenderScaleGovernor *pGovernor, const VRRenderScaleTraceFrame_t *pFrames, uint32_t unFrameCount, float *pflScales )
+{
+	pGovernor->Reset();
+	uint32_t unChanges = 0;
+	float flPrevious = pGovernor->GetScale();
+	for ( uint32_t i = 0; i < unFrameCount; i++ )
+	{
+		float flScale = pGovernor->Step( pFrames[i].timing, pFrames[i].ulVsyncCounter, pFrames[i].bLowResources );
+		if ( pflScales )
+			pflScales[i] = flScale;
+		if ( flScale != flPrevious )
+			unChanges++;
+		flPrevious = flScale;
+	}
+	return unChanges;
+}
+
+} // namespace vr
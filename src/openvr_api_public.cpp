@@ -7,6 +7,9 @@
 #include "vrcommon/envvartools.h"
 #include "vrcommon/hmderrors.h"
 #include "vrcommon/vrpathregistry.h"
+#include "vrcommon/propertycache.h"
+
+#include <atomic>
 
 using vr::EVRInitError;
 using vr::IVRSystem;
@@ -24,6 +27,22 @@ typedef void* (*VRClientCoreFactoryFn)(const char *pInterfaceName, int *pReturnC
 
 static uint32_t g_nVRToken = 0;
 
+static std::atomic< IVRSystem * > g_pPropertyCacheSystem( NULL );
+static std::atomic< bool > g_bPropertyCacheCreated( false );
+
+// The cache is a few hundred KB, so only processes that use the VR_GetCached* calls build it
+static CTrackedPropertyCache &GetPropertyCache()
+{
+	// flags the cache as built from inside the one-time initialization, so later calls don't write anything
+	struct PropertyCacheHolder_t
+	{
+		PropertyCacheHolder_t() { g_bPropertyCacheCreated.store( true, std::memory_order_release ); }
+		CTrackedPropertyCache cache;
+	};
+	static PropertyCacheHolder_t s_propertyCache;
+	return s_propertyCache.cache;
+}
+
 uint32_t VR_GetInitToken()
 {
 	return g_nVRToken;
@@ -33,6 +52,9 @@ EVRInitError VR_LoadHmdSystemInternal();
 
 uint32_t VR_InitInternal( EVRInitError *peError, vr::EVRApplicationType eApplicationType )
 {
+	// pick up any environment overrides the app set since the last init
+	RefreshEnvironmentSnapshot();
+
 	EVRInitError err = VR_LoadHmdSystemInternal();
 	if (err != vr::VRInitError_None)
 	{
@@ -67,6 +89,10 @@ uint32_t VR_InitInternal( EVRInitError *peError, vr::EVRApplicationType eApplica
 
 void VR_ShutdownInternal()
 {
+	g_pPropertyCacheSystem.store( NULL );
+	if ( g_bPropertyCacheCreated.load( std::memory_order_acquire ) )
+		GetPropertyCache().InvalidateAll();
+
 	if (g_pHmdSystem)
 	{
 		g_pHmdSystem->Cleanup();
@@ -274,5 +300,106 @@ const char *VR_GetStringForHmdError( EVRInitError error )
 	return VR_GetVRInitErrorAsEnglishDescription( error );
 }
 
+
+
+//-----------------------------------------------------------------------------
+// Purpose: The IVRSystem the property cache fills misses from. Fetched once
+//          per init and dropped again in VR_ShutdownInternal.
+//-----------------------------------------------------------------------------
+static IVRSystem *GetPropertyCacheSystem( ETrackedPropertyError *pError )
+{
+	IVRSystem *pSystem = g_pPropertyCacheSystem.load( std::memory_order_acquire );
+	if ( !pSystem && g_pHmdSystem )
+	{
+		pSystem = static_cast< IVRSystem * >( g_pHmdSystem->GetGenericInterface( IVRSystem_Version, NULL ) );
+		g_pPropertyCacheSystem.store( pSystem, std::memory_order_release );
+	}
+
+	if ( !pSystem && pError )
+		*pError = TrackedProp_CouldNotContactServer;
+	return pSystem;
+}
+
+
+bool VR_GetCachedBoolTrackedDeviceProperty( TrackedDeviceIndex_t unDeviceIndex, ETrackedDeviceProperty prop, ETrackedPropertyError *pError )
+{
+	IVRSystem *pSystem = GetPropertyCacheSystem( pError );
+	return pSystem ? GetPropertyCache().GetBool( pSystem, unDeviceIndex, prop, pError ) : false;
+}
+
+
+float VR_GetCachedFloatTrackedDeviceProperty( TrackedDeviceIndex_t unDeviceIndex, ETrackedDeviceProperty prop, ETrackedPropertyError *pError )
+{
+	IVRSystem *pSystem = GetPropertyCacheSystem( pError );
+	return pSystem ? GetPropertyCache().GetFloat( pSystem, unDeviceIndex, prop, pError ) : 0.f;
+}
+
+
+int32_t VR_GetCachedInt32TrackedDeviceProperty( TrackedDeviceIndex_t unDeviceIndex, ETrackedDeviceProperty prop, ETrackedPropertyError *pError )
+{
+	IVRSystem *pSystem = GetPropertyCacheSystem( pError );
+	return pSystem ? GetPropertyCache().GetInt32( pSystem, unDeviceIndex, prop, pError ) : 0;
+}
+
+
+uint64_t VR_GetCachedUint64TrackedDeviceProperty( TrackedDeviceIndex_t unDeviceIndex, ETrackedDeviceProperty prop, ETrackedPropertyError *pError )
+{
+	IVRSystem *pSystem = GetPropertyCacheSystem( pError );
+	return pSystem ? GetPropertyCache().GetUint64( pSystem, unDeviceIndex, prop, pError ) : 0;
+}
+
+
+HmdMatrix34_t VR_GetCachedMatrix34TrackedDeviceProperty( TrackedDeviceIndex_t unDeviceIndex, ETrackedDeviceProperty prop, ETrackedPropertyError *pError )
+{
+	IVRSystem *pSystem = GetPropertyCacheSystem( pError );
+	if ( pSystem )
+		return GetPropertyCache().GetMatrix34( pSystem, unDeviceIndex, prop, pError );
+
+	HmdMatrix34_t matZero = {};
+	return matZero;
+}
+
+
+uint32_t VR_GetCachedStringTrackedDeviceProperty( TrackedDeviceIndex_t unDeviceIndex, ETrackedDeviceProperty prop, char *pchValue, uint32_t unBufferSize, ETrackedPropertyError *pError )
+{
+	IVRSystem *pSystem = GetPropertyCacheSystem( pError );
+	return pSystem ? GetPropertyCache().GetString( pSystem, unDeviceIndex, prop, pchValue, unBufferSize, pError ) : 0;
+}
+
+
+bool VR_UpdateTrackedDevicePropertyCache( const VREvent_t *pEvent )
+{
+	return pEvent ? GetPropertyCache().ProcessEvent( *pEvent ) : false;
+}
+
+
+void VR_InvalidateTrackedDevicePropertyCache( TrackedDeviceIndex_t unDeviceIndex )
+{
+	if ( unDeviceIndex == k_unTrackedDeviceIndexInvalid )
+		GetPropertyCache().InvalidateAll();
+	else
+		GetPropertyCache().InvalidateDevice( unDeviceIndex );
 }
 
+
+
+uint32_t VR_GetTrackedDevicePropertiesBatch( const TrackedPropertyRequest_t *pRequests, uint32_t unRequestCount,
+	TrackedPropertyResult_t *pResults, void *pValueBuffer, uint32_t unValueBufferSize )
+{
+	ETrackedPropertyError eError;
+	IVRSystem *pSystem = GetPropertyCacheSystem( &eError );
+	if ( !pSystem )
+	{
+		for ( uint32_t i = 0; i < unRequestCount; i++ )
+		{
+			pResults[i].eError = eError;
+			pResults[i].unOffset = 0;
+			pResults[i].unSize = 0;
+		}
+		return 0;
+	}
+
+	return GetPropertyCache().GetProperties( pSystem, pRequests, unRequestCount, pResults, pValueBuffer, unValueBufferSize );
+}
+
+}
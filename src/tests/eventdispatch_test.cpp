@@ -0,0 +1,166 @@
+//========= Copyright Valve Corporation ============//
+// Stub runtime benchmark for CVREventDispatcher. A stub poll function feeds
+// numbered events for all four subsystems as fast as the pump thread takes
+// them, and one consumer thread per subsystem drains its queue. Checks that
+// every queue sees its events in order and that every event sent was either
+// received or counted as dropped, then prints the routing rate.
+//
+// Usage: eventdispatch_test [event count]
+#include "openvr_eventdispatch.h"
+
+#include <chrono>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <thread>
+
+using namespace vr;
+
+static const uint64_t k_ulDefaultEventCount = 4000000;
+static const uint32_t k_unPopBatch = 64;
+
+// one event type per subsystem under AddDefaultRoutes; VREvent_Quit matches no route
+static const uint32_t k_rEventTypes[ VREventSubsystem_Count ] =
+{
+	VREvent_ButtonPress,
+	VREvent_MouseMove,
+	VREvent_ChaperoneDataHasChanged,
+	VREvent_Quit,
+};
+
+static int g_nFailures = 0;
+
+typedef CVREventDispatcher< 4096 > Dispatcher_t;
+
+struct StubRuntime_t
+{
+	uint64_t ulTotal;
+	uint64_t ulPolled;
+	uint64_t rulSent[ VREventSubsystem_Count ];
+	std::atomic< bool > bExhausted;
+};
+
+struct Consumer_t
+{
+	Dispatcher_t::Queue_t *pQueue;
+	const std::atomic< bool > *pbPumpStopped;
+	std::atomic< uint32_t > *punReady;
+	uint64_t ulReceived;
+	uint64_t ulOutOfOrder;
+};
+
+
+//-----------------------------------------------------------------------------
+// Purpose: Stub for IVRSystem::PollNextEvent. Numbers the events of each
+//			subsystem from 1 in reserved0.
+//-----------------------------------------------------------------------------
+static bool PollStub( void *pContext, VREvent_t *pEvent )
+{
+	StubRuntime_t *pStub = static_cast< StubRuntime_t * >( pContext );
+	if ( pStub->ulPolled == pStub->ulTotal )
+	{
+		pStub->bExhausted.store( true, std::memory_order_release );
+		return false;
+	}
+
+	uint32_t unSubsystem = (uint32_t)( pStub->ulPolled++ % VREventSubsystem_Count );
+	memset( pEvent, 0, sizeof( VREvent_t ) );
+	pEvent->eventType = k_rEventTypes[ unSubsystem ];
+	pEvent->trackedDeviceIndex = k_unTrackedDeviceIndex_Hmd;
+	pEvent->data.reserved.reserved0 = ++pStub->rulSent[ unSubsystem ];
+	return true;
+}
+
+
+//-----------------------------------------------------------------------------
+// Purpose: Drains one queue until the pump has stopped and the queue is empty
+//-----------------------------------------------------------------------------
+static void RunConsumer( Consumer_t *pConsumer )
+{
+	VREvent_t rEvents[ k_unPopBatch ];
+	uint64_t ulLast = 0;
+	pConsumer->punReady->fetch_add( 1 );
+	for ( ;; )
+	{
+		// read the flag before popping so nothing pushed before it was set can be missed
+		bool bPumpStopped = pConsumer->pbPumpStopped->load( std::memory_order_acquire );
+		uint32_t unCount = pConsumer->pQueue->Pop( rEvents, k_unPopBatch );
+		if ( unCount == 0 )
+		{
+			if ( bPumpStopped )
+				break;
+			std::this_thread::yield();
+			continue;
+		}
+
+		for ( uint32_t i = 0; i < unCount; i++ )
+		{
+			uint64_t ulSequence = rEvents[i].data.reserved.reserved0;
+			if ( ulSequence <= ulLast )
+				pConsumer->ulOutOfOrder++;
+			ulLast = ulSequence;
+		}
+		pConsumer->ulReceived += unCount;
+	}
+}
+
+
+int main( int argc, char **argv )
+{
+	StubRuntime_t stub;
+	memset( stub.rulSent, 0, sizeof( stub.rulSent ) );
+	stub.ulTotal = argc > 1 ? strtoull( argv[1], NULL, 10 ) : k_ulDefaultEventCount;
+	stub.ulPolled = 0;
+	stub.bExhausted = false;
+
+	// static storage keeps the cache line aligned queues aligned without C++17 aligned new
+	static Dispatcher_t s_dispatcher( &PollStub, &stub );
+	s_dispatcher.AddDefaultRoutes();
+
+	std::atomic< bool > bPumpStopped( false );
+	std::atomic< uint32_t > unReady( 0 );
+	Consumer_t rConsumers[ VREventSubsystem_Count ];
+	std::thread rThreads[ VREventSubsystem_Count ];
+	for ( uint32_t s = 0; s < VREventSubsystem_Count; s++ )
+	{
+		rConsumers[s].pQueue = &s_dispatcher.GetQueue( (EVREventSubsystem)s );
+		rConsumers[s].pbPumpStopped = &bPumpStopped;
+		rConsumers[s].punReady = &unReady;
+		rConsumers[s].ulReceived = 0;
+		rConsumers[s].ulOutOfOrder = 0;
+		rThreads[s] = std::thread( RunConsumer, &rConsumers[s] );
+	}
+
+	while ( unReady.load() < VREventSubsystem_Count )
+		std::this_thread::yield();
+
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	s_dispatcher.Start( 0 );
+	while ( !stub.bExhausted.load( std::memory_order_acquire ) )
+		std::this_thread::sleep_for( std::chrono::microseconds( 100 ) );
+	s_dispatcher.Stop();
+	double flSeconds = std::chrono::duration< double >( std::chrono::steady_clock::now() - start ).count();
+
+	bPumpStopped.store( true, std::memory_order_release );
+	for ( uint32_t s = 0; s < VREventSubsystem_Count; s++ )
+		rThreads[s].join();
+
+	uint64_t ulDropped = 0;
+	for ( uint32_t s = 0; s < VREventSubsystem_Count; s++ )
+	{
+		const Consumer_t &consumer = rConsumers[s];
+		uint64_t ulQueueDropped = consumer.pQueue->GetDroppedCount();
+		bool bPass = consumer.ulOutOfOrder == 0 && consumer.ulReceived + ulQueueDropped == stub.rulSent[s];
+		if ( !bPass )
+			g_nFailures++;
+		printf( "%s queue %u  sent %llu  received %llu  dropped %llu  out of order %llu\n", bPass ? "PASS" : "FAIL", s,
+			(unsigned long long)stub.rulSent[s], (unsigned long long)consumer.ulReceived, (unsigned long long)ulQueueDropped, (unsigned long long)consumer.ulOutOfOrder );
+		ulDropped += ulQueueDropped;
+	}
+
+	printf( "routed %llu events in %.3f s, %.1f M events/s, %.2f%% dropped\n", (unsigned long long)stub.ulTotal, flSeconds,
+		stub.ulTotal / flSeconds * 1e-6, stub.ulTotal ? 100.0 * ulDropped / stub.ulTotal : 0.0 );
+
+	printf( "%d failure(s)\n", g_nFailures );
+	return g_nFailures == 0 ? 0 : 1;
+}
@@ -0,0 +1,174 @@
+//========= Copyright Valve Corporation ============//
+// Drives CVRHapticScheduler::Tick with synthetic times against a stub that records
+// when each pulse was emitted, and checks the pulse cadence and the drop count
+// around a stalled scheduler thread.
+#include "openvr_hapticscheduler.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <vector>
+
+using namespace vr;
+
+static const float k_flPulseInterval = 0.005f;
+static const double k_flTickStep = 0.001;
+
+static int g_nFailures = 0;
+
+struct RecordedPulse_t
+{
+	double flSeconds;
+	unsigned short usDuration;
+};
+
+struct PulseRecorder_t
+{
+	double flNowSeconds;
+	std::vector< RecordedPulse_t > vecPulses;
+};
+
+
+//-----------------------------------------------------------------------------
+// Purpose: Stub for IVRSystem::TriggerHapticPulse
+//-----------------------------------------------------------------------------
+static void RecordPulse( void *pContext, TrackedDeviceIndex_t unDeviceIndex, uint32_t unAxisId, unsigned short usDurationMicroSec )
+{
+	PulseRecorder_t *pRecorder = static_cast< PulseRecorder_t * >( pContext );
+	RecordedPulse_t pulse = { pRecorder->flNowSeconds, usDurationMicroSec };
+	pRecorder->vecPulses.push_back( pulse );
+}
+
+
+//-----------------------------------------------------------------------------
+// Purpose: Ticks every millisecond from flFrom to flTo inclusive
+//-----------------------------------------------------------------------------
+static void TickRange( CVRHapticScheduler &scheduler, PulseRecorder_t &recorder, double flFrom, double flTo )
+{
+	for ( int i = (int)floor( flFrom / k_flTickStep + 0.5 ); i * k_flTickStep <= flTo + 1e-9; i++ )
+	{
+		recorder.flNowSeconds = i * k_flTickStep;
+		scheduler.Tick( recorder.flNowSeconds );
+	}
+}
+
+
+//-----------------------------------------------------------------------------
+// Purpose: True if no two recorded pulses are closer than the pulse interval
+//-----------------------------------------------------------------------------
+static bool PulsesRespectInterval( const PulseRecorder_t &recorder )
+{
+	for ( size_t i = 1; i < recorder.vecPulses.size(); i++ )
+	{
+		if ( recorder.vecPulses[i].flSeconds - recorder.vecPulses[ i - 1 ].flSeconds < k_flPulseInterval - 1e-9 )
+			return false;
+	}
+	return true;
+}
+
+
+static void Check( const char *pchCase, bool bPass, const char *pchDetail, uint64_t ulActual, uint64_t ulExpected )
+{
+	if ( !bPass )
+		g_nFailures++;
+	printf( "%s %-34s %s %llu (expected %llu)\n", bPass ? "PASS" : "FAIL", pchCase, pchDetail, (unsigned long long)ulActual, (unsigned long long)ulExpected );
+}
+
+
+//-----------------------------------------------------------------------------
+// Purpose: A waveform that is only non-zero while the thread is stalled. The
+//			stalled slots count once; the silent tail after it must not keep
+//			re-counting them on every tick.
+//-----------------------------------------------------------------------------
+static void TestStallThenSilence()
+{
+	const VRHapticPoint_t rPoints[] = { { 0.f, 1.f }, { 0.022f, 1.f }, { 0.022f, 0.f }, { 0.1f, 0.f } };
+
+	PulseRecorder_t recorder;
+	CVRHapticScheduler scheduler( &RecordPulse, &recorder, k_flPulseInterval );
+	scheduler.Play( 0, 0, rPoints, 4, 0.0 );
+
+	recorder.flNowSeconds = 0.0;
+	scheduler.Tick( 0.0 );
+	recorder.flNowSeconds = 0.030;
+	scheduler.Tick( 0.030 );	// slots at 5, 10, 15 and 20 ms were missed
+	Check( "stall then silence", scheduler.GetStats().ulPulsesDropped == 4, "dropped after stall", scheduler.GetStats().ulPulsesDropped, 4 );
+
+	TickRange( scheduler, recorder, 0.031, 0.099 );
+	Check( "stall then silence", scheduler.GetStats().ulPulsesDropped == 4, "dropped after tail", scheduler.GetStats().ulPulsesDropped, 4 );
+	Check( "stall then silence", recorder.vecPulses.size() == 1, "pulses", recorder.vecPulses.size(), 1 );
+}
+
+
+//-----------------------------------------------------------------------------
+// Purpose: A constant waveform ticked on time never drops and pulses once
+//			per interval
+//-----------------------------------------------------------------------------
+static void TestSteadyCadence()
+{
+	const VRHapticPoint_t rPoints[] = { { 0.f, 0.5f }, { 0.05f, 0.5f } };
+
+	PulseRecorder_t recorder;
+	CVRHapticScheduler scheduler( &RecordPulse, &recorder, k_flPulseInterval );
+	scheduler.Play( 0, 0, rPoints, 2, 0.0 );
+	TickRange( scheduler, recorder, 0.0, 0.1 );
+
+	// 0, 5, ... 50 ms
+	Check( "steady cadence", scheduler.GetStats().ulPulsesDropped == 0, "dropped", scheduler.GetStats().ulPulsesDropped, 0 );
+	Check( "steady cadence", recorder.vecPulses.size() == 11, "pulses", recorder.vecPulses.size(), 11 );
+	Check( "steady cadence", PulsesRespectInterval( recorder ), "interval violations", !PulsesRespectInterval( recorder ), 0 );
+}
+
+
+//-----------------------------------------------------------------------------
+// Purpose: A stall in the middle of a waveform that keeps playing afterwards
+//-----------------------------------------------------------------------------
+static void TestStallThenResume()
+{
+	const VRHapticPoint_t rPoints[] = { { 0.f, 1.f }, { 0.1f, 1.f } };
+
+	PulseRecorder_t recorder;
+	CVRHapticScheduler scheduler( &RecordPulse, &recorder, k_flPulseInterval );
+	scheduler.Play( 0, 0, rPoints, 2, 0.0 );
+
+	recorder.flNowSeconds = 0.0;
+	scheduler.Tick( 0.0 );
+	TickRange( scheduler, recorder, 0.030, 0.1 );	// slots at 5 .. 25 ms were missed
+
+	// 0 ms, then 30, 35, ... 100 ms
+	Check( "stall then resume", scheduler.GetStats().ulPulsesDropped == 5, "dropped", scheduler.GetStats().ulPulsesDropped, 5 );
+	Check( "stall then resume", recorder.vecPulses.size() == 16, "pulses", recorder.vecPulses.size(), 16 );
+	Check( "stall then resume", PulsesRespectInterval( recorder ), "interval violations", !PulsesRespectInterval( recorder ), 0 );
+}
+
+
+//-----------------------------------------------------------------------------
+// Purpose: A click shorter than a tick plays once at full strength when its
+//			channel is free and is counted as dropped when it isn't
+//-----------------------------------------------------------------------------
+static void TestShortClick()
+{
+	const VRHapticPoint_t rClick[] = { { 0.f, 1.f }, { 0.0005f, 0.f } };
+
+	PulseRecorder_t recorder;
+	CVRHapticScheduler scheduler( &RecordPulse, &recorder, k_flPulseInterval, 1000 );
+	scheduler.Play( 0, 0, rClick, 2, 0.0002 );
+	TickRange( scheduler, recorder, 0.0, 0.004 );
+	Check( "short click", recorder.vecPulses.size() == 1 && recorder.vecPulses[0].usDuration == 1000, "full strength pulses", recorder.vecPulses.size(), 1 );
+
+	// lands while the channel waits out the interval after the first click
+	scheduler.Play( 0, 0, rClick, 2, 0.0042 );
+	TickRange( scheduler, recorder, 0.005, 0.02 );
+	Check( "short click", scheduler.GetStats().ulPulsesDropped == 1, "dropped", scheduler.GetStats().ulPulsesDropped, 1 );
+}
+
+
+int main()
+{
+	TestStallThenSilence();
+	TestSteadyCadence();
+	TestStallThenResume();
+	TestShortClick();
+
+	printf( "%d failure(s)\n", g_nFailures );
+	return g_nFailures == 0 ? 0 : 1;
+}
@@ -0,0 +1,287 @@
+//========= Copyright Valve Corporation ============//
+// Drives CVROverlayRawImage against a stub SetOverlayRaw that copies and
+// counts every byte it is handed. Checks the dirty rectangle merging and the
+// fold past k_unMaxDirtyRects, then replays a HUD whose text fields change at
+// different rates and compares the bytes moved with submitting the whole image
+// every frame.
+#include "openvr_overlayraw.h"
+
+#include <chrono>
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+
+using namespace vr;
+
+static const uint32_t k_unHudWidth = 1024;
+static const uint32_t k_unHudHeight = 512;
+static const uint32_t k_unDepth = 4;
+static const uint32_t k_unFieldWidth = 200;
+static const uint32_t k_unFieldHeight = 32;
+static const uint32_t k_unHudFrames = 900;
+
+static int g_nFailures = 0;
+
+/** Stands in for the runtime's copy of the overlay image */
+struct StubRuntime_t
+{
+	std::vector< uint8_t > vecImage;
+	uint64_t ulBytesReceived;
+	uint32_t unSubmits;
+	EVROverlayError eNextError;
+};
+
+
+//-----------------------------------------------------------------------------
+// Purpose: Stub for IVROverlay::SetOverlayRaw
+//-----------------------------------------------------------------------------
+static EVROverlayError SubmitStub( void *pContext, VROverlayHandle_t ulOverlayHandle, void *pvBuffer, uint32_t unWidth, uint32_t unHeight, uint32_t unDepth )
+{
+	StubRuntime_t *pStub = static_cast< StubRuntime_t * >( pContext );
+	if ( pStub->eNextError != VROverlayError_None )
+	{
+		EVROverlayError eError = pStub->eNextError;
+		pStub->eNextError = VROverlayError_None;
+		return eError;
+	}
+
+	size_t unSize = (size_t)unWidth * unHeight * unDepth;
+	pStub->vecImage.resize( unSize );
+	memcpy( pStub->vecImage.data(), pvBuffer, unSize );
+	pStub->ulBytesReceived += unSize;
+	pStub->unSubmits++;
+	return VROverlayError_None;
+}
+
+
+static void InitStub( StubRuntime_t *pStub )
+{
+	pStub->ulBytesReceived = 0;
+	pStub->unSubmits = 0;
+	pStub->eNextError = VROverlayError_None;
+}
+
+
+static void Check( const char *pchCase, bool bPass )
+{
+	if ( !bPass )
+		g_nFailures++;
+	printf( "%s %s\n", bPass ? "PASS" : "FAIL", pchCase );
+}
+
+
+static bool BContains( const VROverlayDirtyRect_t &outer, const VROverlayDirtyRect_t &inner )
+{
+	return outer.unX <= inner.unX && outer.unY <= inner.unY
+		&& outer.unX + outer.unWidth >= inner.unX + inner.unWidth && outer.unY + outer.unHeight >= inner.unY + inner.unHeight;
+}
+
+
+//-----------------------------------------------------------------------------
+// Purpose: True if every rectangle marked is inside one of the image's dirty
+//			rectangles and the dirty rectangles don't overlap each other
+//-----------------------------------------------------------------------------
+static bool BDirtyRectsCover( const CVROverlayRawImage &image, const std::vector< VROverlayDirtyRect_t > &vecMarked )
+{
+	for ( size_t m = 0; m < vecMarked.size(); m++ )
+	{
+		bool bCovered = false;
+		for ( uint32_t i = 0; i < image.GetDirtyRectCount() && !bCovered; i++ )
+			bCovered = BContains( image.GetDirtyRect( i ), vecMarked[m] );
+		if ( !bCovered )
+			return false;
+	}
+
+	for ( uint32_t i = 0; i < image.GetDirtyRectCount(); i++ )
+	{
+		for ( uint32_t j = i + 1; j < image.GetDirtyRectCount(); j++ )
+		{
+			const VROverlayDirtyRect_t &a = image.GetDirtyRect( i ), &b = image.GetDirtyRect( j );
+			if ( a.unX < b.unX + b.unWidth && b.unX < a.unX + a.unWidth && a.unY < b.unY + b.unHeight && b.unY < a.unY + a.unHeight )
+				return false;
+		}
+	}
+	return true;
+}
+
+
+static void TestMergeAndFold()
+{
+	StubRuntime_t stub;
+	InitStub( &stub );
+	CVROverlayRawImage image( &SubmitStub, &stub, 1, k_unHudWidth, k_unHudHeight, k_unDepth );
+	image.Flush();
+
+	// touching rectangles merge, and a rectangle that bridges two merges all three
+	VROverlayDirtyRect_t left = { 10, 10, 20, 20 }, right = { 30, 10, 20, 20 };
+	image.MarkDirty( left );
+	image.MarkDirty( right );
+	Check( "touching rects merge", image.GetDirtyRectCount() == 1 && image.GetDirtyRect( 0 ).unWidth == 40 );
+
+	VROverlayDirtyRect_t far = { 100, 10, 20, 20 }, bridge = { 45, 15, 60, 5 };
+	image.MarkDirty( far );
+	Check( "separate rects stay separate", image.GetDirtyRectCount() == 2 );
+	image.MarkDirty( bridge );
+	Check( "bridging rect merges all", image.GetDirtyRectCount() == 1 && image.GetDirtyRect( 0 ).unX == 10 && image.GetDirtyRect( 0 ).unWidth == 110 );
+
+	VROverlayDirtyRect_t clipped = { k_unHudWidth - 10, k_unHudHeight - 10, 100, 100 };
+	image.Flush();
+	image.MarkDirty( clipped );
+	Check( "rects are clipped to the image", image.GetDirtyRect( 0 ).unWidth == 10 && image.GetDirtyRect( 0 ).unHeight == 10 );
+	image.Flush();
+
+	// a grid of 40 separate rectangles, more than fit, folds into at most 16 that still cover all of them
+	std::vector< VROverlayDirtyRect_t > vecMarked;
+	bool bNeverOver = true;
+	for ( uint32_t i = 0; i < 40; i++ )
+	{
+		VROverlayDirtyRect_t rect = { ( i % 8 ) * 120 + 5, ( i / 8 ) * 100 + 5, 16 + i, 12 };
+		vecMarked.push_back( rect );
+		image.MarkDirty( rect );
+		bNeverOver &= image.GetDirtyRectCount() <= CVROverlayRawImage::k_unMaxDirtyRects;
+	}
+	Check( "fold keeps at most 16 rects", bNeverOver && image.GetDirtyRectCount() > 1 );
+	Check( "folded rects cover every marked rect without overlapping", BDirtyRectsCover( image, vecMarked ) );
+
+	uint64_t ulDirtyArea = 0;
+	for ( uint32_t i = 0; i < image.GetDirtyRectCount(); i++ )
+		ulDirtyArea += (uint64_t)image.GetDirtyRect( i ).unWidth * image.GetDirtyRect( i ).unHeight;
+	printf( "     40 rects folded into %u, %.1f%% of the image dirty\n", image.GetDirtyRectCount(), 100.0 * ulDirtyArea / ( k_unHudWidth * k_unHudHeight ) );
+
+	// a failed submit leaves the image dirty for the next flush
+	stub.eNextError = VROverlayError_RequestFailed;
+	bool bFailed = image.Flush() == VROverlayError_RequestFailed && image.IsDirty();
+	bool bRetried = image.Flush() == VROverlayError_None && !image.IsDirty() && stub.unSubmits == 4;
+	Check( "failed submit stays dirty and is retried", bFailed && bRetried );
+}
+
+
+//-----------------------------------------------------------------------------
+// Purpose: Draws one text field's worth of pixels for a given version of its text
+//-----------------------------------------------------------------------------
+static void DrawField( uint8_t *pPixels, uint32_t unField, uint32_t unVersion )
+{
+	for ( uint32_t y = 0; y < k_unFieldHeight; y++ )
+	{
+		for ( uint32_t x = 0; x < k_unFieldWidth * k_unDepth; x++ )
+			pPixels[ y * k_unFieldWidth * k_unDepth + x ] = (uint8_t)( 1 + unField * 61 + unVersion * 7 + ( ( x / k_unDepth ) ^ y ) );
+	}
+}
+
+
+static void TestHud()
+{
+	// one field changes every second at 90 Hz, one every 30 frames, one never
+	static const uint32_t k_runPeriods[3] = { 90, 30, 0 };
+	static const uint32_t k_runFieldX[3] = { 16, 412, 808 };
+	static const uint32_t k_runFieldY[3] = { 16, 240, 464 };
+
+	std::vector< uint8_t > vecField( k_unFieldWidth * k_unFieldHeight * k_unDepth );
+	typedef std::chrono::steady_clock Clock_t;
+
+	// incremental: redraw every field into the shadow copy each frame, submit only when something changed
+	StubRuntime_t incrementalStub;
+	InitStub( &incrementalStub );
+	CVROverlayRawImage image( &SubmitStub, &incrementalStub, 1, k_unHudWidth, k_unHudHeight, k_unDepth );
+	Clock_t::time_point start = Clock_t::now();
+	for ( uint32_t unFrame = 0; unFrame < k_unHudFrames; unFrame++ )
+	{
+		for ( uint32_t f = 0; f < 3; f++ )
+		{
+			DrawField( vecField.data(), f, k_runPeriods[f] ? unFrame / k_runPeriods[f] : 0 );
+			image.UpdateRect( k_runFieldX[f], k_runFieldY[f], k_unFieldWidth, k_unFieldHeight, vecField.data(), k_unFieldWidth * k_unDepth );
+		}
+		image.Flush();
+	}
+	double flIncrementalMs = std::chrono::duration< double, std::milli >( Clock_t::now() - start ).count();
+
+	// full: the same frames drawn into an app buffer and submitted whole every frame
+	StubRuntime_t fullStub;
+	InitStub( &fullStub );
+	std::vector< uint8_t > vecApp( k_unHudWidth * k_unHudHeight * k_unDepth, 0 );
+	start = Clock_t::now();
+	for ( uint32_t unFrame = 0; unFrame < k_unHudFrames; unFrame++ )
+	{
+		for ( uint32_t f = 0; f < 3; f++ )
+		{
+			DrawField( vecField.data(), f, k_runPeriods[f] ? unFrame / k_runPeriods[f] : 0 );
+			for ( uint32_t y = 0; y < k_unFieldHeight; y++ )
+				memcpy( &vecApp[ ( ( k_runFieldY[f] + y ) * k_unHudWidth + k_runFieldX[f] ) * k_unDepth ], &vecField[ y * k_unFieldWidth * k_unDepth ], k_unFieldWidth * k_unDepth );
+		}
+		SubmitStub( &fullStub, 1, vecApp.data(), k_unHudWidth, k_unHudHeight, k_unDepth );
+	}
+	double flFullMs = std::chrono::duration< double, std::milli >( Clock_t::now() - start ).count();
+
+	// the first frame and every 30th frame change something: 30 of 900
+	const uint64_t k_ulImageBytes = (uint64_t)k_unHudWidth * k_unHudHeight * k_unDepth;
+	const uint64_t k_ulFieldBytes = (uint64_t)k_unFieldWidth * k_unFieldHeight * k_unDepth;
+	const VROverlayRawStats_t &stats = image.GetStats();
+	Check( "HUD flushes 30 of 900 frames", stats.ulFlushes == 30 && stats.ulFlushesSkipped == 870 && incrementalStub.unSubmits == 30 );
+	Check( "HUD submits 30 whole images", stats.ulBytesSubmitted == 30 * k_ulImageBytes && incrementalStub.ulBytesReceived == 30 * k_ulImageBytes );
+
+	// three fields drawn on the first frame, then 9 and 29 changes
+	Check( "HUD copies only changed fields", stats.ulBytesCopied == ( 3 + 9 + 29 ) * k_ulFieldBytes );
+	Check( "HUD compares every field every frame", stats.ulBytesCompared == 3 * k_unHudFrames * k_ulFieldBytes );
+	Check( "runtime ends up with the same image", incrementalStub.vecImage == fullStub.vecImage );
+
+	printf( "     incremental: %.0f KB submitted per frame, %.3f ms per frame\n", incrementalStub.ulBytesReceived / 1024.0 / k_unHudFrames, flIncrementalMs / k_unHudFrames );
+	printf( "     full:        %.0f KB submitted per frame, %.3f ms per frame\n", fullStub.ulBytesReceived / 1024.0 / k_unHudFrames, flFullMs / k_unHudFrames );
+}
+
+
+//-----------------------------------------------------------------------------
+// Purpose: Many small widgets changing every frame, so every frame goes
+//			through the fold path
+//-----------------------------------------------------------------------------
+static void TestScatteredWidgets()
+{
+	static const uint32_t k_unWidgets = 48;
+	static const uint32_t k_unFrames = 300;
+	static const uint32_t k_unWidgetSize = 24;
+
+	StubRuntime_t stub;
+	InitStub( &stub );
+	CVROverlayRawImage image( &SubmitStub, &stub, 1, k_unHudWidth, k_unHudHeight, k_unDepth );
+	image.Flush();
+
+	std::vector< uint8_t > vecWidget( k_unWidgetSize * k_unWidgetSize * k_unDepth );
+	bool bCovered = true;
+	uint64_t ulDirtyArea = 0;
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	for ( uint32_t unFrame = 0; unFrame < k_unFrames; unFrame++ )
+	{
+		std::vector< VROverlayDirtyRect_t > vecMarked;
+		for ( uint32_t w = 0; w < k_unWidgets; w++ )
+		{
+			// a third of the widgets change each frame
+			if ( ( w + unFrame ) % 3 != 0 )
+				continue;
+			memset( vecWidget.data(), (int)( 1 + ( unFrame + w ) % 250 ), vecWidget.size() );
+			VROverlayDirtyRect_t rect = { ( w % 12 ) * 84 + 8, ( w / 12 ) * 120 + 8, k_unWidgetSize, k_unWidgetSize };
+			image.UpdateRect( rect.unX, rect.unY, rect.unWidth, rect.unHeight, vecWidget.data(), k_unWidgetSize * k_unDepth );
+			vecMarked.push_back( rect );
+		}
+
+		bCovered &= image.GetDirtyRectCount() <= CVROverlayRawImage::k_unMaxDirtyRects && BDirtyRectsCover( image, vecMarked );
+		for ( uint32_t i = 0; i < image.GetDirtyRectCount(); i++ )
+			ulDirtyArea += (uint64_t)image.GetDirtyRect( i ).unWidth * image.GetDirtyRect( i ).unHeight;
+		image.Flush();
+	}
+	double flMs = std::chrono::duration< double, std::milli >( std::chrono::steady_clock::now() - start ).count();
+
+	Check( "scattered widgets fold to 16 covering rects every frame", bCovered );
+	Check( "scattered widgets submit every frame", stub.unSubmits == k_unFrames + 1 );
+	printf( "     16 widgets per frame: %.1f%% of the image dirty on average, %.3f ms per frame\n",
+		100.0 * ulDirtyArea / ( (double)k_unFrames * k_unHudWidth * k_unHudHeight ), flMs / k_unFrames );
+}
+
+
+int main()
+{
+	TestMergeAndFold();
+	TestHud();
+	TestScatteredWidgets();
+
+	printf( "%d failure(s)\n", g_nFailures );
+	return g_nFailures == 0 ? 0 : 1;
+}
@@ -0,0 +1,186 @@
+//========= Copyright Valve Corporation ============//
+// Compares the batched pose conversion in openvr_posebatch.h against the
+// scalar path hellovr_opengl uses: convert each valid pose to a Matrix4, invert
+// the HMD pose with Matrix4_invert and multiply it into every device pose.
+// Checks that both produce the same device-to-head matrices, then times both.
+//
+// Usage: posebatch_test [iterations]
+#include "openvr_posebatch.h"
+
+extern "C"
+{
+#include "Matrices.h"
+}
+
+#include <chrono>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+using namespace vr;
+
+static const uint32_t k_unValidDeviceCount = 13;
+static const uint32_t k_unDefaultIterations = 200000;
+static const float k_flTolerance = 1e-5f;
+static const float k_flUntouched = -12345.f;
+
+static int g_nFailures = 0;
+
+
+//-----------------------------------------------------------------------------
+// Purpose: A rigid pose rotated flAngle about a unit axis, at the given position
+//-----------------------------------------------------------------------------
+static TrackedDevicePose_t MakePose( const float *pflAxis, float flAngle, const float *pflPosition )
+{
+	float c = cosf( flAngle ), s = sinf( flAngle ), t = 1.f - c;
+	float x = pflAxis[0], y = pflAxis[1], z = pflAxis[2];
+
+	TrackedDevicePose_t pose;
+	memset( &pose, 0, sizeof( pose ) );
+	HmdMatrix34_t &mat = pose.mDeviceToAbsoluteTracking;
+	mat.m[0][0] = t * x * x + c;		mat.m[0][1] = t * x * y - s * z;	mat.m[0][2] = t * x * z + s * y;
+	mat.m[1][0] = t * x * y + s * z;	mat.m[1][1] = t * y * y + c;		mat.m[1][2] = t * y * z - s * x;
+	mat.m[2][0] = t * x * z - s * y;	mat.m[2][1] = t * y * z + s * x;	mat.m[2][2] = t * z * z + c;
+	for ( int r = 0; r < 3; r++ )
+		mat.m[r][3] = pflPosition[r];
+	pose.eTrackingResult = TrackingResult_Running_OK;
+	pose.bPoseIsValid = true;
+	pose.bDeviceIsConnected = true;
+	return pose;
+}
+
+
+//-----------------------------------------------------------------------------
+// Purpose: hellovr_opengl's ConvertSteamVRMatrixToMatrix4
+//-----------------------------------------------------------------------------
+static Matrix4 ConvertSteamVRMatrixToMatrix4( const HmdMatrix34_t &matPose )
+{
+	Matrix4 mx = {
+		{
+			matPose.m[0][0], matPose.m[1][0], matPose.m[2][0], 0.0,
+			matPose.m[0][1], matPose.m[1][1], matPose.m[2][1], 0.0,
+			matPose.m[0][2], matPose.m[1][2], matPose.m[2][2], 0.0,
+			matPose.m[0][3], matPose.m[1][3], matPose.m[2][3], 1.0f
+		}
+	};
+	return mx;
+}
+
+
+//-----------------------------------------------------------------------------
+// Purpose: The per device path from hellovr_opengl's UpdateHMDMatrixPose, plus
+//			the HMD-relative multiply it does per model when rendering
+//-----------------------------------------------------------------------------
+static void ConvertScalar( const TrackedDevicePose_t *pPoses, float ( *prflOut )[16] )
+{
+	Matrix4 rmat4DevicePose[ k_unMaxTrackedDeviceCount ];
+	for ( uint32_t nDevice = 0; nDevice < k_unMaxTrackedDeviceCount; nDevice++ )
+	{
+		if ( pPoses[ nDevice ].bPoseIsValid )
+			rmat4DevicePose[ nDevice ] = ConvertSteamVRMatrixToMatrix4( pPoses[ nDevice ].mDeviceToAbsoluteTracking );
+	}
+
+	Matrix4 mat4HMDPose = rmat4DevicePose[ k_unTrackedDeviceIndex_Hmd ];
+	Matrix4_invert( &mat4HMDPose );
+
+	for ( uint32_t nDevice = 0; nDevice < k_unMaxTrackedDeviceCount; nDevice++ )
+	{
+		if ( !pPoses[ nDevice ].bPoseIsValid )
+			continue;
+		Matrix4 mat = Matrix4_multiply_Matrix4( &mat4HMDPose, &rmat4DevicePose[ nDevice ] );
+		memcpy( prflOut[ nDevice ], mat.m, sizeof( mat.m ) );
+	}
+}
+
+
+//-----------------------------------------------------------------------------
+// Purpose: The same result through the batch helpers
+//-----------------------------------------------------------------------------
+static void ConvertBatch( const TrackedDevicePose_t *pPoses, float ( *prflOut )[16] )
+{
+	static PoseBatchMatrices_t s_batch;
+	TrackedDeviceMask_t mask = PoseBatch_GetValidMask( pPoses, k_unMaxTrackedDeviceCount );
+	PoseBatch_Gather( pPoses, k_unMaxTrackedDeviceCount, mask, &s_batch );
+	HmdMatrix34_t matHeadFromAbsolute = PoseBatch_InvertAffine( pPoses[ k_unTrackedDeviceIndex_Hmd ].mDeviceToAbsoluteTracking );
+	PoseBatch_MultiplyLeft( matHeadFromAbsolute, s_batch, &s_batch );
+	PoseBatch_ScatterColumnMajor44( s_batch, mask, prflOut );
+}
+
+
+//-----------------------------------------------------------------------------
+// Purpose: Runs one path unIterations times, returns nanoseconds per frame
+//-----------------------------------------------------------------------------
+static double TimePath( void ( *pfnConvert )( const TrackedDevicePose_t *, float ( * )[16] ), const TrackedDevicePose_t *pPoses, uint32_t unIterations, float *pflSink )
+{
+	float rflOut[ k_unMaxTrackedDeviceCount ][16];
+	memset( rflOut, 0, sizeof( rflOut ) );
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	for ( uint32_t i = 0; i < unIterations; i++ )
+	{
+		pfnConvert( pPoses, rflOut );
+		*pflSink += rflOut[ i % k_unValidDeviceCount ][ i % 16 ];
+	}
+	double flSeconds = std::chrono::duration< double >( std::chrono::steady_clock::now() - start ).count();
+	return flSeconds * 1e9 / unIterations;
+}
+
+
+int main( int argc, char **argv )
+{
+	uint32_t unIterations = argc > 1 ? (uint32_t)strtoul( argv[1], NULL, 10 ) : k_unDefaultIterations;
+
+	// the HMD and 12 other valid devices scattered over the first slots, the rest disconnected
+	TrackedDevicePose_t rPoses[ k_unMaxTrackedDeviceCount ];
+	memset( rPoses, 0, sizeof( rPoses ) );
+	uint32_t unValid = 0;
+	for ( uint32_t i = 0; i < k_unMaxTrackedDeviceCount && unValid < k_unValidDeviceCount; i++ )
+	{
+		if ( i == 4 || i == 9 )
+			continue;
+
+		float flAxisLength = sqrtf( 1.f + i * i + 4.f );
+		float rflAxis[3] = { 1.f / flAxisLength, (float)i / flAxisLength, -2.f / flAxisLength };
+		float rflPosition[3] = { 0.1f * i, 1.5f - 0.05f * i, -0.3f + 0.07f * i };
+		rPoses[i] = MakePose( rflAxis, 0.37f * ( i + 1 ), rflPosition );
+		unValid++;
+	}
+
+	float rflScalar[ k_unMaxTrackedDeviceCount ][16], rflBatch[ k_unMaxTrackedDeviceCount ][16];
+	for ( uint32_t i = 0; i < k_unMaxTrackedDeviceCount; i++ )
+	{
+		for ( int k = 0; k < 16; k++ )
+			rflScalar[i][k] = rflBatch[i][k] = k_flUntouched;
+	}
+	ConvertScalar( rPoses, rflScalar );
+	ConvertBatch( rPoses, rflBatch );
+
+	for ( uint32_t i = 0; i < k_unMaxTrackedDeviceCount; i++ )
+	{
+		float flError = 0.f;
+		for ( int k = 0; k < 16; k++ )
+			flError = fmaxf( flError, fabsf( rflScalar[i][k] - rflBatch[i][k] ) );
+
+		// invalid slots must be left alone by both paths
+		bool bPass = flError <= k_flTolerance && ( rPoses[i].bPoseIsValid || rflBatch[i][0] == k_flUntouched );
+		if ( !bPass )
+			g_nFailures++;
+		printf( "%s device %2u %-7s max error %.2e\n", bPass ? "PASS" : "FAIL", i, rPoses[i].bPoseIsValid ? "valid" : "invalid", flError );
+	}
+
+	float flSink = 0.f;
+	double flScalarNs = TimePath( &ConvertScalar, rPoses, unIterations, &flSink );
+	double flBatchNs = TimePath( &ConvertBatch, rPoses, unIterations, &flSink );
+#if defined( VR_POSEBATCH_AVX )
+	const char *pchPath = "AVX";
+#elif defined( VR_POSEBATCH_SSE )
+	const char *pchPath = "SSE";
+#else
+	const char *pchPath = "scalar";
+#endif
+	printf( "%u valid of %u slots, %u iterations: scalar %.0f ns/frame, batch (%s) %.0f ns/frame (sink %g)\n",
+		k_unValidDeviceCount, k_unMaxTrackedDeviceCount, unIterations, flScalarNs, pchPath, flBatchNs, flSink );
+
+	printf( "%d failure(s)\n", g_nFailures );
+	return g_nFailures == 0 ? 0 : 1;
+}
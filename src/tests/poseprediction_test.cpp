@@ -0,0 +1,140 @@
+//========= Copyright Valve Corporation ============//
+// Checks PosePrediction_Predict against trajectories with closed form solutions.
+// Each trajectory runs in its own device slot of one batch so every lane of the
+// SIMD path is exercised together.
+#include "openvr_poseprediction.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+using namespace vr;
+
+// Predictions are computed in float, references in double
+static const double k_flPositionTolerance = 1e-5;	// meters
+static const double k_flRotationTolerance = 1e-5;	// per rotation matrix element
+
+static const float k_rflTimes[] = { 0.f, 0.005f, 0.011f, 0.02f, 0.05f, 0.1f, 0.25f };
+static const uint32_t k_unTimeCount = sizeof( k_rflTimes ) / sizeof( k_rflTimes[0] );
+
+static int g_nFailures = 0;
+
+
+//-----------------------------------------------------------------------------
+// Purpose: Rotation of flAngle radians about a unit axis (Rodrigues' formula)
+//-----------------------------------------------------------------------------
+static void AxisAngleToMatrix( const double *pflAxis, double flAngle, double ( *prflOut )[3] )
+{
+	double c = cos( flAngle ), s = sin( flAngle ), t = 1.0 - c;
+	double x = pflAxis[0], y = pflAxis[1], z = pflAxis[2];
+	prflOut[0][0] = t * x * x + c;		prflOut[0][1] = t * x * y - s * z;	prflOut[0][2] = t * x * z + s * y;
+	prflOut[1][0] = t * x * y + s * z;	prflOut[1][1] = t * y * y + c;		prflOut[1][2] = t * y * z - s * x;
+	prflOut[2][0] = t * x * z - s * y;	prflOut[2][1] = t * y * z + s * x;	prflOut[2][2] = t * z * z + c;
+}
+
+
+//-----------------------------------------------------------------------------
+// Purpose: A pose with an arbitrary starting orientation and position
+//-----------------------------------------------------------------------------
+static TrackedDevicePose_t MakePose( const double *pflPosition, const HmdVector3_t &vVelocity, const HmdVector3_t &vAngularVelocity )
+{
+	static const double k_rflStartAxis[3] = { 0.267261241912424, 0.534522483824849, 0.801783725737273 };
+	double rflStart[3][3];
+	AxisAngleToMatrix( k_rflStartAxis, 0.7, rflStart );
+
+	TrackedDevicePose_t pose;
+	memset( &pose, 0, sizeof( pose ) );
+	for ( int r = 0; r < 3; r++ )
+	{
+		for ( int c = 0; c < 3; c++ )
+			pose.mDeviceToAbsoluteTracking.m[r][c] = (float)rflStart[r][c];
+		pose.mDeviceToAbsoluteTracking.m[r][3] = (float)pflPosition[r];
+	}
+	pose.vVelocity = vVelocity;
+	pose.vAngularVelocity = vAngularVelocity;
+	pose.eTrackingResult = TrackingResult_Running_OK;
+	pose.bPoseIsValid = true;
+	pose.bDeviceIsConnected = true;
+	return pose;
+}
+
+
+//-----------------------------------------------------------------------------
+// Purpose: Compares one predicted slot against the expected rotation and position
+//-----------------------------------------------------------------------------
+static void Check( const char *pchCase, float flTime, const PoseBatchMatrices_t &predicted, uint32_t unSlot, double ( *prflRotation )[3], const double *pflPosition )
+{
+	double flRotationError = 0.0, flPositionError = 0.0;
+	for ( int r = 0; r < 3; r++ )
+	{
+		for ( int c = 0; c < 3; c++ )
+			flRotationError = fmax( flRotationError, fabs( predicted.m[r][c][ unSlot ] - prflRotation[r][c] ) );
+		flPositionError = fmax( flPositionError, fabs( predicted.m[r][3][ unSlot ] - pflPosition[r] ) );
+	}
+
+	bool bPass = flRotationError <= k_flRotationTolerance && flPositionError <= k_flPositionTolerance;
+	if ( !bPass )
+		g_nFailures++;
+	printf( "%s %-28s t=%.3f  rotation error %.2e  position error %.2e\n", bPass ? "PASS" : "FAIL", pchCase, flTime, flRotationError, flPositionError );
+}
+
+
+int main()
+{
+	const uint32_t k_unConstantVelocity = 0, k_unConstantAcceleration = 3, k_unConstantAngularVelocity = 9;
+
+	const double rflStartPosition[3] = { 0.1, 1.6, -0.4 };
+	const HmdVector3_t vZero = { { 0.f, 0.f, 0.f } };
+	const HmdVector3_t vVelocity = { { 0.5f, -1.25f, 0.3f } };
+	const HmdVector3_t vAcceleration = { { -2.f, 9.81f, 0.75f } };
+
+	// 2 pi rad/s about a fixed axis that isn't aligned with any coordinate axis
+	const double rflSpinAxis[3] = { 0.6, -0.48, 0.64 };
+	const double flSpinRate = 2.0 * 3.14159265358979323846;
+	const HmdVector3_t vAngularVelocity = { { (float)( rflSpinAxis[0] * flSpinRate ), (float)( rflSpinAxis[1] * flSpinRate ), (float)( rflSpinAxis[2] * flSpinRate ) } };
+
+	TrackedDevicePose_t rPoses[ k_unMaxTrackedDeviceCount ];
+	memset( rPoses, 0, sizeof( rPoses ) );
+	rPoses[ k_unConstantVelocity ] = MakePose( rflStartPosition, vVelocity, vZero );
+	rPoses[ k_unConstantAcceleration ] = MakePose( rflStartPosition, vVelocity, vZero );
+	rPoses[ k_unConstantAngularVelocity ] = MakePose( rflStartPosition, vZero, vAngularVelocity );
+
+	PosePredictionState_t state;
+	PosePrediction_Gather( rPoses, k_unMaxTrackedDeviceCount, PoseBatch_GetValidMask( rPoses, k_unMaxTrackedDeviceCount ), &state );
+	PosePrediction_SetAcceleration( &state, k_unConstantAcceleration, vAcceleration, vZero );
+
+	PoseBatchMatrices_t rPredicted[ k_unTimeCount ];
+	PosePrediction_Predict( state, k_rflTimes, k_unTimeCount, rPredicted );
+
+	double rflStart[3][3];
+	for ( int r = 0; r < 3; r++ )
+		for ( int c = 0; c < 3; c++ )
+			rflStart[r][c] = rPoses[0].mDeviceToAbsoluteTracking.m[r][c];
+
+	for ( uint32_t t = 0; t < k_unTimeCount; t++ )
+	{
+		double flTime = k_rflTimes[t];
+		double rflPosition[3];
+
+		// p(t) = p0 + v t, orientation unchanged
+		for ( int k = 0; k < 3; k++ )
+			rflPosition[k] = rflStartPosition[k] + vVelocity.v[k] * flTime;
+		Check( "constant velocity", k_rflTimes[t], rPredicted[t], k_unConstantVelocity, rflStart, rflPosition );
+
+		// p(t) = p0 + v t + a t^2 / 2, orientation unchanged
+		for ( int k = 0; k < 3; k++ )
+			rflPosition[k] = rflStartPosition[k] + vVelocity.v[k] * flTime + 0.5 * vAcceleration.v[k] * flTime * flTime;
+		Check( "constant acceleration", k_rflTimes[t], rPredicted[t], k_unConstantAcceleration, rflStart, rflPosition );
+
+		// R(t) = Rot( axis, w t ) * R0 with the angular velocity in tracking space, position unchanged
+		double rflSpin[3][3], rflRotation[3][3];
+		AxisAngleToMatrix( rflSpinAxis, flSpinRate * flTime, rflSpin );
+		for ( int r = 0; r < 3; r++ )
+			for ( int c = 0; c < 3; c++ )
+				rflRotation[r][c] = rflSpin[r][0] * rflStart[0][c] + rflSpin[r][1] * rflStart[1][c] + rflSpin[r][2] * rflStart[2][c];
+		Check( "constant angular velocity", k_rflTimes[t], rPredicted[t], k_unConstantAngularVelocity, rflRotation, rflStartPosition );
+	}
+
+	printf( "%d failure(s)\n", g_nFailures );
+	return g_nFailures == 0 ? 0 : 1;
+}
@@ -0,0 +1,143 @@
+//========= Copyright Valve Corporation ============//
+// Replays a synthetic frame timing trace through CVRRenderScaleGovernor and
+// checks the scales it passes through. The trace covers a GPU overload, the
+// scale pinned at its minimum while the overload lasts, recovery, CPU only
+// reprojection and the cap while the runtime asks for low resources.
+#include "openvr_renderscale.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+
+using namespace vr;
+
+static const float k_flScaleTolerance = 1e-4f;
+
+// 100 Hz, with shorter waits than the defaults to keep the trace short
+static const float k_flDisplayFrequency = 100.f;
+static const float k_flLoadSmoothing = 0.5f;
+static const uint32_t k_unFramesBeforeIncrease = 5;
+static const uint32_t k_unCooldownFrames = 3;
+
+static int g_nFailures = 0;
+
+
+struct ScaleChange_t
+{
+	uint32_t unFrame;
+	float flScale;
+};
+
+static void AddChange( std::vector< ScaleChange_t > &vecChanges, uint32_t unFrame, float flScale )
+{
+	ScaleChange_t change = { unFrame, flScale };
+	vecChanges.push_back( change );
+}
+
+
+//-----------------------------------------------------------------------------
+// Purpose: Appends unCount frames with GPU time at flLoad of the frame budget
+//-----------------------------------------------------------------------------
+static void AddFrames( std::vector< VRRenderScaleTraceFrame_t > &vecTrace, uint32_t unCount, float flLoad, uint32_t unReprojectionFlags, uint32_t unMisPresented, uint32_t unVsyncsPerFrame, bool bLowResources )
+{
+	for ( uint32_t i = 0; i < unCount; i++ )
+	{
+		VRRenderScaleTraceFrame_t frame;
+		memset( &frame, 0, sizeof( frame ) );
+		frame.timing.m_nSize = sizeof( Compositor_FrameTiming );
+		frame.timing.m_nFrameIndex = (uint32_t)vecTrace.size() + 1;
+		frame.timing.m_flTotalRenderGpuMs = flLoad * 1000.f / k_flDisplayFrequency;
+		frame.timing.m_flCompositorIdleCpuMs = 1.f;
+		frame.timing.m_nReprojectionFlags = unReprojectionFlags;
+		frame.timing.m_nNumMisPresented = unMisPresented;
+		frame.ulVsyncCounter = ( vecTrace.empty() ? 0 : vecTrace.back().ulVsyncCounter ) + unVsyncsPerFrame;
+		frame.bLowResources = bLowResources;
+		vecTrace.push_back( frame );
+	}
+}
+
+
+int main()
+{
+	VRRenderScaleGovernorSettings_t settings = RenderScaleGovernor_GetDefaultSettings( k_flDisplayFrequency );
+	settings.flLoadSmoothing = k_flLoadSmoothing;
+	settings.unFramesBeforeIncrease = k_unFramesBeforeIncrease;
+	settings.unCooldownFrames = k_unCooldownFrames;
+
+	// target load 0.9, band 0.85 .. 0.95
+	std::vector< VRRenderScaleTraceFrame_t > vecTrace;
+	AddFrames( vecTrace, 20, 0.9f, 0, 0, 1, false );		// steady inside the band
+	AddFrames( vecTrace, 20, 2.f, 0, 0, 1, false );		// overload: 0.8, 0.64, then pinned at 0.6
+	AddFrames( vecTrace, 60, 0.5f, 0, 0, 1, false );		// recovery: +5% per step
+	AddFrames( vecTrace, 30, 0.5f, VRCompositor_ReprojectionReason_Cpu, 1, 2, false );	// CPU bound and missing vsyncs, nothing changes
+	AddFrames( vecTrace, 30, 0.5f, 0, 0, 1, true );		// capped at the low resource scale
+	AddFrames( vecTrace, 10, 0.5f, 0, 0, 1, false );		// cap lifted
+
+	// Expected changes, by trace frame. Overload steps down by at most 20% per frame until the minimum.
+	// While pinned there the smoothed load keeps tracking the overload, so recovery waits for it to decay
+	// back below the band (frame 42) and the wait before the first increase ends at frame 46. Each
+	// further increase waits out the cooldown and the frames before increase again, every 7 frames.
+	std::vector< ScaleChange_t > vecExpected;
+	AddChange( vecExpected, 20, 0.8f );
+	AddChange( vecExpected, 21, 0.64f );
+	AddChange( vecExpected, 22, 0.6f );
+	float flRecovered = 0.6f;
+	for ( uint32_t unFrame = 46; unFrame < 100; unFrame += 7 )
+	{
+		flRecovered *= 1.f + settings.flMaxStepUp;
+		AddChange( vecExpected, unFrame, flRecovered );
+	}
+
+	// the low resource cap applies at once, increases resume as soon as it's lifted
+	AddChange( vecExpected, 130, settings.flLowResourceScale );
+	AddChange( vecExpected, 160, settings.flLowResourceScale * ( 1.f + settings.flMaxStepUp ) );
+	AddChange( vecExpected, 167, settings.flLowResourceScale * ( 1.f + settings.flMaxStepUp ) * ( 1.f + settings.flMaxStepUp ) );
+
+	CVRRenderScaleGovernor governor( settings );
+	std::vector< float > vecScales( vecTrace.size() );
+	uint32_t unChanges = RenderScaleGovernor_Replay( &governor, &vecTrace[0], (uint32_t)vecTrace.size(), &vecScales[0] );
+
+	std::vector< ScaleChange_t > vecActual;
+	float flPrevious = 1.f;
+	for ( uint32_t i = 0; i < vecScales.size(); i++ )
+	{
+		if ( vecScales[i] != flPrevious )
+			AddChange( vecActual, i, vecScales[i] );
+		flPrevious = vecScales[i];
+	}
+
+	bool bChangesPass = unChanges == vecExpected.size();
+	if ( !bChangesPass )
+		g_nFailures++;
+	printf( "%s changes %u (expected %u)\n", bChangesPass ? "PASS" : "FAIL", unChanges, (uint32_t)vecExpected.size() );
+
+	ScaleChange_t none = { 0, 0.f };
+	for ( size_t i = 0; i < vecExpected.size() || i < vecActual.size(); i++ )
+	{
+		const ScaleChange_t &actual = i < vecActual.size() ? vecActual[i] : none;
+		const ScaleChange_t &expected = i < vecExpected.size() ? vecExpected[i] : none;
+		bool bPass = actual.unFrame == expected.unFrame && fabsf( actual.flScale - expected.flScale ) <= k_flScaleTolerance;
+		if ( !bPass )
+			g_nFailures++;
+		printf( "%s frame %3u scale %.4f (expected frame %3u scale %.4f)\n", bPass ? "PASS" : "FAIL", actual.unFrame, actual.flScale, expected.unFrame, expected.flScale );
+	}
+
+	// at the end of the overload the scale has been pinned for 17 frames at twice the budget
+	RenderScaleGovernor_Replay( &governor, &vecTrace[0], 40, NULL );
+	bool bPinnedLoad = fabsf( governor.GetSmoothedLoad() - 2.f ) <= 0.01f;
+	if ( !bPinnedLoad )
+		g_nFailures++;
+	printf( "%s smoothed load while pinned %.3f (expected 2.000)\n", bPinnedLoad ? "PASS" : "FAIL", governor.GetSmoothedLoad() );
+
+	// the same trace has to give the same scales every time
+	std::vector< float > vecAgain( vecTrace.size() );
+	RenderScaleGovernor_Replay( &governor, &vecTrace[0], (uint32_t)vecTrace.size(), &vecAgain[0] );
+	bool bDeterministic = vecAgain == vecScales;
+	if ( !bDeterministic )
+		g_nFailures++;
+	printf( "%s replay is deterministic\n", bDeterministic ? "PASS" : "FAIL" );
+
+	printf( "%d failure(s)\n", g_nFailures );
+	return g_nFailures == 0 ? 0 : 1;
+}
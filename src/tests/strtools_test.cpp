@@ -0,0 +1,352 @@
+//========= Copyright Valve Corporation ============//
+// Checks the integer formatting and parsing helpers in strtools: round trips
+// against snprintf, the error cases of the parsers and formatters, and that
+// Uint64ToString/StringToUint64 still behave like snprintf/strtoull. Then times
+// them against snprintf and strtoull.
+//
+// Usage: strtools_test [iterations]
+#include "vrcommon/strtools.h"
+
+#include <chrono>
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+static const uint32_t k_unRandomValues = 10000;
+static const uint32_t k_unDefaultBenchmarkValues = 1000000;
+
+static int g_nFailures = 0;
+
+
+static void Check( const char *pchCase, bool bPass )
+{
+	if ( !bPass )
+		g_nFailures++;
+	printf( "%s %s\n", bPass ? "PASS" : "FAIL", pchCase );
+}
+
+
+//-----------------------------------------------------------------------------
+// Purpose: xorshift64, so the values are the same on every run
+//-----------------------------------------------------------------------------
+static uint64_t NextRandom( uint64_t *pulState )
+{
+	uint64_t x = *pulState;
+	x ^= x << 13;
+	x ^= x >> 7;
+	x ^= x << 17;
+	*pulState = x;
+	return x;
+}
+
+
+//-----------------------------------------------------------------------------
+// Purpose: Values of every digit count, their neighbours and the type limits
+//-----------------------------------------------------------------------------
+static std::vector< uint64_t > GetTestValues()
+{
+	std::vector< uint64_t > vecValues;
+	uint64_t ulPower = 1;
+	for ( int i = 0; i < 20; i++ )
+	{
+		vecValues.push_back( ulPower - 1 );
+		vecValues.push_back( ulPower );
+		vecValues.push_back( ulPower + 1 );
+		if ( i < 19 )
+			ulPower *= 10;
+	}
+	vecValues.push_back( INT32_MAX );
+	vecValues.push_back( (uint64_t)INT32_MAX + 1 );
+	vecValues.push_back( UINT32_MAX );
+	vecValues.push_back( (uint64_t)UINT32_MAX + 1 );
+	vecValues.push_back( INT64_MAX );
+	vecValues.push_back( (uint64_t)INT64_MAX + 1 );
+	vecValues.push_back( UINT64_MAX );
+
+	// random values with a random number of significant bits
+	uint64_t ulState = 0x9E3779B97F4A7C15ull;
+	for ( uint32_t i = 0; i < k_unRandomValues; i++ )
+	{
+		uint64_t ulValue = NextRandom( &ulState );
+		vecValues.push_back( ulValue >> ( ulValue % 64 ) );
+	}
+	return vecValues;
+}
+
+
+static void TestRoundTrips( const std::vector< uint64_t > &vecValues )
+{
+	char rchExpected[ 32 ], rchBuffer[ 32 ];
+	bool rbPass[8] = { true, true, true, true, true, true, true, true };
+
+	for ( size_t i = 0; i < vecValues.size(); i++ )
+	{
+		uint64_t ulValue = vecValues[i];
+
+		// Uint64
+		snprintf( rchExpected, sizeof( rchExpected ), "%" PRIu64, ulValue );
+		ToCharsResult_t toResult = Uint64ToChars( rchBuffer, rchBuffer + sizeof( rchBuffer ), ulValue );
+		uint64_t ulParsed = 0;
+		FromCharsResult_t fromResult = CharsToUint64( rchBuffer, toResult.pchEnd, &ulParsed );
+		rbPass[0] &= toResult.eError == StringConversionError_None && std::string( rchBuffer, toResult.pchEnd ) == rchExpected
+			&& fromResult.eError == StringConversionError_None && fromResult.pchEnd == toResult.pchEnd && ulParsed == ulValue;
+		rbPass[1] &= Uint64ToString( ulValue ) == rchExpected && StringToUint64( rchExpected ) == ulValue;
+
+		// Int64, both signs
+		for ( int nSign = 0; nSign < 2; nSign++ )
+		{
+			int64_t nValue = nSign ? (int64_t)( 0 - ulValue ) : (int64_t)ulValue;
+			snprintf( rchExpected, sizeof( rchExpected ), "%" PRId64, nValue );
+			toResult = Int64ToChars( rchBuffer, rchBuffer + sizeof( rchBuffer ), nValue );
+			int64_t nParsed = 0;
+			fromResult = CharsToInt64( rchBuffer, toResult.pchEnd, &nParsed );
+			rbPass[2] &= toResult.eError == StringConversionError_None && std::string( rchBuffer, toResult.pchEnd ) == rchExpected
+				&& fromResult.eError == StringConversionError_None && nParsed == nValue;
+
+			int32_t nValue32 = (int32_t)nValue;
+			snprintf( rchExpected, sizeof( rchExpected ), "%" PRId32, nValue32 );
+			toResult = Int32ToChars( rchBuffer, rchBuffer + sizeof( rchBuffer ), nValue32 );
+			int32_t nParsed32 = 0;
+			fromResult = CharsToInt32( rchBuffer, toResult.pchEnd, &nParsed32 );
+			rbPass[3] &= toResult.eError == StringConversionError_None && std::string( rchBuffer, toResult.pchEnd ) == rchExpected
+				&& fromResult.eError == StringConversionError_None && nParsed32 == nValue32;
+		}
+
+		// Uint32
+		uint32_t unValue = (uint32_t)ulValue;
+		snprintf( rchExpected, sizeof( rchExpected ), "%" PRIu32, unValue );
+		toResult = Uint32ToChars( rchBuffer, rchBuffer + sizeof( rchBuffer ), unValue );
+		uint32_t unParsed = 0;
+		fromResult = CharsToUint32( rchBuffer, toResult.pchEnd, &unParsed );
+		rbPass[4] &= toResult.eError == StringConversionError_None && std::string( rchBuffer, toResult.pchEnd ) == rchExpected
+			&& fromResult.eError == StringConversionError_None && unParsed == unValue;
+
+		// hex, also read back with a 0x prefix
+		snprintf( rchExpected, sizeof( rchExpected ), "%" PRIX64, ulValue );
+		rchBuffer[0] = '0';
+		rchBuffer[1] = 'x';
+		toResult = Uint64ToHexChars( rchBuffer + 2, rchBuffer + sizeof( rchBuffer ), ulValue );
+		fromResult = HexCharsToUint64( rchBuffer, toResult.pchEnd, &ulParsed );
+		rbPass[5] &= toResult.eError == StringConversionError_None && std::string( rchBuffer + 2, toResult.pchEnd ) == rchExpected
+			&& fromResult.eError == StringConversionError_None && fromResult.pchEnd == toResult.pchEnd && ulParsed == ulValue;
+
+		snprintf( rchExpected, sizeof( rchExpected ), "%" PRIX32, unValue );
+		toResult = Uint32ToHexChars( rchBuffer, rchBuffer + sizeof( rchBuffer ), unValue );
+		fromResult = HexCharsToUint32( rchBuffer, toResult.pchEnd, &unParsed );
+		rbPass[6] &= toResult.eError == StringConversionError_None && std::string( rchBuffer, toResult.pchEnd ) == rchExpected
+			&& fromResult.eError == StringConversionError_None && unParsed == unValue;
+
+		// lower case hex parses too
+		snprintf( rchExpected, sizeof( rchExpected ), "%" PRIx64, ulValue );
+		fromResult = HexCharsToUint64( rchExpected, rchExpected + strlen( rchExpected ), &ulParsed );
+		rbPass[7] &= fromResult.eError == StringConversionError_None && ulParsed == ulValue;
+	}
+
+	Check( "round trip Uint64ToChars/CharsToUint64", rbPass[0] );
+	Check( "round trip Uint64ToString/StringToUint64", rbPass[1] );
+	Check( "round trip Int64ToChars/CharsToInt64", rbPass[2] );
+	Check( "round trip Int32ToChars/CharsToInt32", rbPass[3] );
+	Check( "round trip Uint32ToChars/CharsToUint32", rbPass[4] );
+	Check( "round trip Uint64ToHexChars/HexCharsToUint64 with 0x", rbPass[5] );
+	Check( "round trip Uint32ToHexChars/HexCharsToUint32", rbPass[6] );
+	Check( "lower case hex", rbPass[7] );
+}
+
+
+//-----------------------------------------------------------------------------
+// Purpose: Parses pchInput as a whole string and checks the error, where
+//			parsing stopped and the value. The value must be untouched on error.
+//-----------------------------------------------------------------------------
+template< typename T >
+static void CheckParse( const char *pchCase, FromCharsResult_t ( *pfnParse )( const char *, const char *, T * ), const char *pchInput,
+	EStringConversionError eExpectedError, size_t unExpectedEnd, T expectedValue )
+{
+	const T k_untouched = (T)42;
+	T value = k_untouched;
+	FromCharsResult_t result = pfnParse( pchInput, pchInput + strlen( pchInput ), &value );
+	bool bPass = result.eError == eExpectedError && result.pchEnd == pchInput + unExpectedEnd
+		&& value == ( eExpectedError == StringConversionError_None ? expectedValue : k_untouched );
+	Check( pchCase, bPass );
+}
+
+
+static void TestParseErrors()
+{
+	// overflow consumes the whole digit run
+	CheckParse< uint64_t >( "CharsToUint64 max", &CharsToUint64, "18446744073709551615", StringConversionError_None, 20, UINT64_MAX );
+	CheckParse< uint64_t >( "CharsToUint64 max + 1", &CharsToUint64, "18446744073709551616", StringConversionError_OutOfRange, 20, 0 );
+	CheckParse< uint64_t >( "CharsToUint64 far too long", &CharsToUint64, "99999999999999999999999x", StringConversionError_OutOfRange, 23, 0 );
+	CheckParse< uint32_t >( "CharsToUint32 max + 1", &CharsToUint32, "4294967296", StringConversionError_OutOfRange, 10, 0 );
+	CheckParse< int32_t >( "CharsToInt32 min", &CharsToInt32, "-2147483648", StringConversionError_None, 11, INT32_MIN );
+	CheckParse< int32_t >( "CharsToInt32 max + 1", &CharsToInt32, "2147483648", StringConversionError_OutOfRange, 10, 0 );
+	CheckParse< int32_t >( "CharsToInt32 min - 1", &CharsToInt32, "-2147483649", StringConversionError_OutOfRange, 11, 0 );
+	CheckParse< int64_t >( "CharsToInt64 min", &CharsToInt64, "-9223372036854775808", StringConversionError_None, 20, INT64_MIN );
+	CheckParse< int64_t >( "CharsToInt64 max + 1", &CharsToInt64, "9223372036854775808", StringConversionError_OutOfRange, 19, 0 );
+	CheckParse< uint32_t >( "HexCharsToUint32 9 digits", &HexCharsToUint32, "100000000", StringConversionError_OutOfRange, 9, 0 );
+	CheckParse< uint32_t >( "HexCharsToUint32 leading zeros", &HexCharsToUint32, "00000000FFFFFFFF", StringConversionError_None, 16, UINT32_MAX );
+	CheckParse< uint64_t >( "HexCharsToUint64 17 digits", &HexCharsToUint64, "0x10000000000000000", StringConversionError_OutOfRange, 19, 0 );
+
+	// empty range and no digits
+	CheckParse< uint64_t >( "CharsToUint64 empty", &CharsToUint64, "", StringConversionError_InvalidArgument, 0, 0 );
+	CheckParse< int32_t >( "CharsToInt32 empty", &CharsToInt32, "", StringConversionError_InvalidArgument, 0, 0 );
+	CheckParse< uint64_t >( "HexCharsToUint64 empty", &HexCharsToUint64, "", StringConversionError_InvalidArgument, 0, 0 );
+	CheckParse< uint64_t >( "CharsToUint64 letters", &CharsToUint64, "abc", StringConversionError_InvalidArgument, 0, 0 );
+	CheckParse< uint64_t >( "CharsToUint64 leading space", &CharsToUint64, " 5", StringConversionError_InvalidArgument, 0, 0 );
+
+	// signs
+	CheckParse< uint64_t >( "CharsToUint64 plus", &CharsToUint64, "+5", StringConversionError_InvalidArgument, 0, 0 );
+	CheckParse< uint64_t >( "CharsToUint64 minus", &CharsToUint64, "-5", StringConversionError_InvalidArgument, 0, 0 );
+	CheckParse< int64_t >( "CharsToInt64 plus", &CharsToInt64, "+5", StringConversionError_InvalidArgument, 0, 0 );
+	CheckParse< int64_t >( "CharsToInt64 minus", &CharsToInt64, "-5", StringConversionError_None, 2, -5 );
+	CheckParse< int64_t >( "CharsToInt64 minus alone", &CharsToInt64, "-", StringConversionError_InvalidArgument, 0, 0 );
+	CheckParse< int32_t >( "CharsToInt32 minus zero", &CharsToInt32, "-0", StringConversionError_None, 2, 0 );
+	CheckParse< uint32_t >( "HexCharsToUint32 minus", &HexCharsToUint32, "-1", StringConversionError_InvalidArgument, 0, 0 );
+
+	// hex prefix is only a prefix when a digit follows it
+	CheckParse< uint32_t >( "HexCharsToUint32 0x1F", &HexCharsToUint32, "0x1F", StringConversionError_None, 4, 0x1F );
+	CheckParse< uint32_t >( "HexCharsToUint32 0X10", &HexCharsToUint32, "0X10", StringConversionError_None, 4, 0x10 );
+	CheckParse< uint32_t >( "HexCharsToUint32 0x alone", &HexCharsToUint32, "0x", StringConversionError_None, 1, 0 );
+	CheckParse< uint32_t >( "HexCharsToUint32 0xg", &HexCharsToUint32, "0xg", StringConversionError_None, 1, 0 );
+	CheckParse< uint32_t >( "HexCharsToUint32 x1", &HexCharsToUint32, "x1", StringConversionError_InvalidArgument, 0, 0 );
+	CheckParse< uint64_t >( "CharsToUint64 0x10", &CharsToUint64, "0x10", StringConversionError_None, 1, 0 );
+
+	// parsing stops at the first character that isn't part of the number
+	CheckParse< uint64_t >( "CharsToUint64 trailing text", &CharsToUint64, "123abc", StringConversionError_None, 3, 123 );
+	CheckParse< int32_t >( "CharsToInt32 trailing minus", &CharsToInt32, "-12-3", StringConversionError_None, 3, -12 );
+	CheckParse< uint32_t >( "HexCharsToUint32 trailing text", &HexCharsToUint32, "beefy", StringConversionError_None, 4, 0xBEEF );
+}
+
+
+//-----------------------------------------------------------------------------
+// Purpose: Formats into a buffer of exactly unSize characters
+//-----------------------------------------------------------------------------
+static void CheckFormatFits( const char *pchCase, ToCharsResult_t ( *pfnFormat )( char *, char *, uint64_t ), uint64_t ulValue, size_t unSize, bool bExpectFits )
+{
+	char rchBuffer[ 32 ];
+	memset( rchBuffer, '#', sizeof( rchBuffer ) );
+	ToCharsResult_t result = pfnFormat( rchBuffer, rchBuffer + unSize, ulValue );
+	bool bPass = bExpectFits
+		? result.eError == StringConversionError_None && result.pchEnd == rchBuffer + unSize
+		: result.eError == StringConversionError_BufferTooSmall && result.pchEnd == rchBuffer + unSize;
+	bPass &= rchBuffer[ unSize ] == '#';	// never writes past the end
+	Check( pchCase, bPass );
+}
+
+
+static void TestFormatErrors()
+{
+	CheckFormatFits( "Uint64ToChars max, 20 chars", &Uint64ToChars, UINT64_MAX, 20, true );
+	CheckFormatFits( "Uint64ToChars max, 19 chars", &Uint64ToChars, UINT64_MAX, 19, false );
+	CheckFormatFits( "Uint64ToChars 0, 0 chars", &Uint64ToChars, 0, 0, false );
+	CheckFormatFits( "Uint64ToChars 0, 1 char", &Uint64ToChars, 0, 1, true );
+	CheckFormatFits( "Uint64ToHexChars max, 16 chars", &Uint64ToHexChars, UINT64_MAX, 16, true );
+	CheckFormatFits( "Uint64ToHexChars max, 15 chars", &Uint64ToHexChars, UINT64_MAX, 15, false );
+
+	char rchBuffer[ 32 ];
+	memset( rchBuffer, '#', sizeof( rchBuffer ) );
+	ToCharsResult_t result = Int64ToChars( rchBuffer, rchBuffer + 19, INT64_MIN );
+	Check( "Int64ToChars min, 19 chars", result.eError == StringConversionError_BufferTooSmall && result.pchEnd == rchBuffer + 19 && rchBuffer[19] == '#' );
+	result = Int64ToChars( rchBuffer, rchBuffer + 20, INT64_MIN );
+	Check( "Int64ToChars min, 20 chars", result.eError == StringConversionError_None && std::string( rchBuffer, result.pchEnd ) == "-9223372036854775808" );
+	result = Int32ToChars( rchBuffer, rchBuffer + 1, -1 );
+	Check( "Int32ToChars -1, 1 char", result.eError == StringConversionError_BufferTooSmall && result.pchEnd == rchBuffer + 1 );
+}
+
+
+//-----------------------------------------------------------------------------
+// Purpose: StringToUint64 keeps strtoull( base 0 ) behaviour outside plain decimal
+//-----------------------------------------------------------------------------
+static void TestStringToUint64()
+{
+	static const char *k_rpchInputs[] =
+	{
+		"0", "7", "12345", "18446744073709551615", "18446744073709551616", "99999999999999999999999",
+		"0x10", "0X1f", "010", "00", " 42", "\t42", "+42", "-1", "12abc", "abc", "", "0x", "08",
+	};
+
+	bool bPass = true;
+	for ( size_t i = 0; i < sizeof( k_rpchInputs ) / sizeof( k_rpchInputs[0] ); i++ )
+	{
+		uint64_t ulExpected = strtoull( k_rpchInputs[i], NULL, 0 );
+		uint64_t ulActual = StringToUint64( k_rpchInputs[i] );
+		if ( ulActual != ulExpected )
+		{
+			printf( "     StringToUint64( \"%s\" ) = %" PRIu64 ", strtoull gives %" PRIu64 "\n", k_rpchInputs[i], ulActual, ulExpected );
+			bPass = false;
+		}
+	}
+	Check( "StringToUint64 matches strtoull", bPass );
+}
+
+
+//-----------------------------------------------------------------------------
+// Purpose: Times formatting and parsing against the C library
+//-----------------------------------------------------------------------------
+static void Benchmark( uint32_t unCount )
+{
+	std::vector< uint64_t > vecValues( unCount );
+	uint64_t ulState = 0x2545F4914F6CDD1Dull;
+	for ( uint32_t i = 0; i < unCount; i++ )
+	{
+		uint64_t ulValue = NextRandom( &ulState );
+		vecValues[i] = ulValue >> ( ulValue % 64 );
+	}
+
+	std::vector< char > vecText( (size_t)unCount * 21 );
+	char rchBuffer[ 32 ];
+	uint64_t ulSink = 0;
+	typedef std::chrono::steady_clock Clock_t;
+
+	Clock_t::time_point start = Clock_t::now();
+	for ( uint32_t i = 0; i < unCount; i++ )
+	{
+		int nLength = snprintf( rchBuffer, sizeof( rchBuffer ), "%" PRIu64, vecValues[i] );
+		ulSink += (uint64_t)nLength + (uint8_t)rchBuffer[0];
+	}
+	double flSnprintf = std::chrono::duration< double >( Clock_t::now() - start ).count();
+
+	// the formatted text is kept for the parse runs
+	start = Clock_t::now();
+	for ( uint32_t i = 0; i < unCount; i++ )
+	{
+		char *pchText = &vecText[ (size_t)i * 21 ];
+		ToCharsResult_t result = Uint64ToChars( pchText, pchText + 20, vecValues[i] );
+		*result.pchEnd = '\0';
+		ulSink += (uint64_t)( result.pchEnd - pchText );
+	}
+	double flToChars = std::chrono::duration< double >( Clock_t::now() - start ).count();
+
+	start = Clock_t::now();
+	for ( uint32_t i = 0; i < unCount; i++ )
+		ulSink += strtoull( &vecText[ (size_t)i * 21 ], NULL, 10 );
+	double flStrtoull = std::chrono::duration< double >( Clock_t::now() - start ).count();
+
+	start = Clock_t::now();
+	for ( uint32_t i = 0; i < unCount; i++ )
+	{
+		const char *pchText = &vecText[ (size_t)i * 21 ];
+		uint64_t ulValue = 0;
+		CharsToUint64( pchText, pchText + strlen( pchText ), &ulValue );
+		ulSink += ulValue;
+	}
+	double flFromChars = std::chrono::duration< double >( Clock_t::now() - start ).count();
+
+	printf( "%u values: Uint64ToChars %.1f ns, snprintf %.1f ns, CharsToUint64 %.1f ns, strtoull %.1f ns (sink %" PRIu64 ")\n", unCount,
+		flToChars * 1e9 / unCount, flSnprintf * 1e9 / unCount, flFromChars * 1e9 / unCount, flStrtoull * 1e9 / unCount, ulSink );
+}
+
+
+int main( int argc, char **argv )
+{
+	TestRoundTrips( GetTestValues() );
+	TestParseErrors();
+	TestFormatErrors();
+	TestStringToUint64();
+
+	Benchmark( argc > 1 ? (uint32_t)strtoul( argv[1], NULL, 10 ) : k_unDefaultBenchmarkValues );
+
+	printf( "%d failure(s)\n", g_nFailures );
+	return g_nFailures == 0 ? 0 : 1;
+}
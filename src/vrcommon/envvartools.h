@@ -2,6 +2,47 @@
 #pragma once
 
 #include <string>
+#include <vector>
+#include <memory>
+#include <stdint.h>
 
+/** Returns the value of the variable from the current environment snapshot, or "" if it is not set */
 std::string GetEnvironmentVariable( const char *pchVarName );
+
+/** Sets (or with a NULL value, removes) a variable and refreshes the environment snapshot */
 bool SetEnvironmentVariable( const char *pchVarName, const char *pchVarValue );
+
+/** An immutable copy of the process environment with hashed, allocation-free lookup */
+class CEnvironmentSnapshot
+{
+public:
+	/** Captures the current process environment */
+	CEnvironmentSnapshot();
+
+	/** Returns the value the variable had when the snapshot was taken, or NULL if it was not set.
+	* The pointer stays valid for the lifetime of the snapshot. */
+	const char *GetValue( const char *pchVarName ) const;
+
+private:
+	struct Entry_t
+	{
+		uint32_t unHash;
+		uint32_t unNameOffset;
+		uint32_t unValueOffset;
+	};
+
+	// every variable as "NAME\0VALUE\0"
+	std::vector< char > m_vecStrings;
+	std::vector< Entry_t > m_vecEntries;
+
+	// open addressing, entry index + 1 so zero marks an empty bucket
+	std::vector< uint32_t > m_vecBuckets;
+};
+
+/** Returns the current environment snapshot, capturing it on first use. Hold on to the returned
+* pointer for as long as values looked up from it are in use. Changes made to the environment
+* outside of SetEnvironmentVariable are not seen until RefreshEnvironmentSnapshot is called. */
+std::shared_ptr< const CEnvironmentSnapshot > GetEnvironmentSnapshot();
+
+/** Captures a new environment snapshot and publishes it to subsequent GetEnvironmentSnapshot calls */
+void RefreshEnvironmentSnapshot();
@@ -1,46 +1,196 @@
 //========= Copyright Valve Corporation ============//
 #include "envvartools.h"
 #include <stdlib.h>
+#include <string.h>
 
 #if defined(_WIN32)
 #include <Windows.h>
 
 #undef GetEnvironmentVariable
 #undef SetEnvironmentVariable
+#elif defined(OSX)
+#include <crt_externs.h>
+#elif defined(POSIX)
+extern char **environ;
 #endif
 
 
-std::string GetEnvironmentVariable( const char *pchVarName )
+//-----------------------------------------------------------------------------
+// Purpose: Variable names are case insensitive on Windows, so hash and compare
+//          them that way there.
+//-----------------------------------------------------------------------------
+static uint32_t HashVarName( const char *pchName, size_t unLen )
 {
+	uint32_t unHash = 2166136261u;
+	for ( size_t i = 0; i < unLen; i++ )
+	{
+		uint8_t c = (uint8_t)pchName[i];
 #if defined(_WIN32)
-	char rchValue[32767]; // max size for an env var on Windows
-	DWORD cChars = GetEnvironmentVariableA( pchVarName, rchValue, sizeof( rchValue ) );
-	if( cChars == 0 )
-		return "";
-	else
-		return rchValue;
+		if ( (uint8_t)( c - 'A' ) < 26 )
+			c |= 0x20;
+#endif
+		unHash = ( unHash ^ c ) * 16777619u;
+	}
+	return unHash;
+}
+
+static bool BVarNamesMatch( const char *pchA, const char *pchB )
+{
+#if defined(_WIN32)
+	return 0 == _stricmp( pchA, pchB );
+#else
+	return 0 == strcmp( pchA, pchB );
+#endif
+}
+
+
+//-----------------------------------------------------------------------------
+// Purpose: Captures the current process environment
+//-----------------------------------------------------------------------------
+CEnvironmentSnapshot::CEnvironmentSnapshot()
+{
+	std::vector< const char * > vecVars;
+#if defined(_WIN32)
+	char *pchBlock = GetEnvironmentStringsA();
+	if ( pchBlock )
+	{
+		for ( const char *pchVar = pchBlock; *pchVar; pchVar += strlen( pchVar ) + 1 )
+			vecVars.push_back( pchVar );
+	}
 #elif defined(POSIX)
-	char *pchValue = getenv( pchVarName );
+#if defined(OSX)
+	char **ppchEnviron = *_NSGetEnviron();
+#else
+	char **ppchEnviron = environ;
+#endif
+	for ( char **ppchVar = ppchEnviron; ppchVar && *ppchVar; ppchVar++ )
+		vecVars.push_back( *ppchVar );
+#else
+#error "Unsupported Platform"
+#endif
+
+	size_t unTotalLen = 0;
+	for ( size_t i = 0; i < vecVars.size(); i++ )
+		unTotalLen += strlen( vecVars[i] ) + 1;
+	m_vecStrings.reserve( unTotalLen + vecVars.size() );
+	m_vecEntries.reserve( vecVars.size() );
+
+	uint32_t unBuckets = 16;
+	while ( unBuckets < vecVars.size() * 2 )
+		unBuckets *= 2;
+	m_vecBuckets.resize( unBuckets, 0 );
+
+	for ( size_t i = 0; i < vecVars.size(); i++ )
+	{
+		// Windows keeps per-drive working directories as "=C:=C:\dir", so the
+		// separator is the first '=' after the first character
+		const char *pchVar = vecVars[i];
+		const char *pchEquals = pchVar[0] ? strchr( pchVar + 1, '=' ) : NULL;
+		if ( !pchEquals )
+			continue;
+
+		size_t unNameLen = pchEquals - pchVar;
+		Entry_t entry;
+		entry.unHash = HashVarName( pchVar, unNameLen );
+		entry.unNameOffset = (uint32_t)m_vecStrings.size();
+		m_vecStrings.insert( m_vecStrings.end(), pchVar, pchEquals );
+		m_vecStrings.push_back( '\0' );
+		entry.unValueOffset = (uint32_t)m_vecStrings.size();
+		m_vecStrings.insert( m_vecStrings.end(), pchEquals + 1, pchEquals + 1 + strlen( pchEquals + 1 ) + 1 );
+
+		// like getenv, the first definition of a name wins
+		uint32_t unBucket = entry.unHash & ( unBuckets - 1 );
+		bool bDuplicate = false;
+		for ( ; m_vecBuckets[ unBucket ] != 0; unBucket = ( unBucket + 1 ) & ( unBuckets - 1 ) )
+		{
+			const Entry_t &other = m_vecEntries[ m_vecBuckets[ unBucket ] - 1 ];
+			if ( other.unHash == entry.unHash && BVarNamesMatch( &m_vecStrings[ other.unNameOffset ], &m_vecStrings[ entry.unNameOffset ] ) )
+			{
+				bDuplicate = true;
+				break;
+			}
+		}
+		if ( bDuplicate )
+			continue;
+
+		m_vecEntries.push_back( entry );
+		m_vecBuckets[ unBucket ] = (uint32_t)m_vecEntries.size();
+	}
+
+#if defined(_WIN32)
+	if ( pchBlock )
+		FreeEnvironmentStringsA( pchBlock );
+#endif
+}
+
+
+//-----------------------------------------------------------------------------
+// Purpose: Returns the value the variable had when the snapshot was taken
+//-----------------------------------------------------------------------------
+const char *CEnvironmentSnapshot::GetValue( const char *pchVarName ) const
+{
+	if ( !pchVarName )
+		return NULL;
+
+	uint32_t unHash = HashVarName( pchVarName, strlen( pchVarName ) );
+	uint32_t unMask = (uint32_t)m_vecBuckets.size() - 1;
+	for ( uint32_t unBucket = unHash & unMask; m_vecBuckets[ unBucket ] != 0; unBucket = ( unBucket + 1 ) & unMask )
+	{
+		const Entry_t &entry = m_vecEntries[ m_vecBuckets[ unBucket ] - 1 ];
+		if ( entry.unHash == unHash && BVarNamesMatch( &m_vecStrings[ entry.unNameOffset ], pchVarName ) )
+			return &m_vecStrings[ entry.unValueOffset ];
+	}
+	return NULL;
+}
+
+
+static std::shared_ptr< const CEnvironmentSnapshot > g_pEnvironmentSnapshot;
+
+std::shared_ptr< const CEnvironmentSnapshot > GetEnvironmentSnapshot()
+{
+	std::shared_ptr< const CEnvironmentSnapshot > pSnapshot = std::atomic_load( &g_pEnvironmentSnapshot );
+	if ( !pSnapshot )
+	{
+		RefreshEnvironmentSnapshot();
+		pSnapshot = std::atomic_load( &g_pEnvironmentSnapshot );
+	}
+	return pSnapshot;
+}
+
+
+void RefreshEnvironmentSnapshot()
+{
+	std::shared_ptr< const CEnvironmentSnapshot > pSnapshot = std::make_shared< CEnvironmentSnapshot >();
+	std::atomic_store( &g_pEnvironmentSnapshot, pSnapshot );
+}
+
+
+std::string GetEnvironmentVariable( const char *pchVarName )
+{
+	std::shared_ptr< const CEnvironmentSnapshot > pSnapshot = GetEnvironmentSnapshot();
+	const char *pchValue = pSnapshot->GetValue( pchVarName );
 	if( pchValue )
 		return pchValue;
 	else
 		return "";
-#else
-#error "Unsupported Platform"
-#endif
 }
 
 
 bool SetEnvironmentVariable( const char *pchVarName, const char *pchVarValue )
 {
 #if defined(_WIN32)
-	return 0 != SetEnvironmentVariableA( pchVarName, pchVarValue );
+	bool bSuccess = 0 != SetEnvironmentVariableA( pchVarName, pchVarValue );
 #elif defined(POSIX)
+	bool bSuccess;
 	if( pchVarValue == NULL )
-		return 0 == unsetenv( pchVarName );
+		bSuccess = 0 == unsetenv( pchVarName );
 	else
-		return 0 == setenv( pchVarName, pchVarValue, 1 );
+		bSuccess = 0 == setenv( pchVarName, pchVarValue, 1 );
 #else
 #error "Unsupported Platform"
 #endif
+
+	if ( bSuccess )
+		RefreshEnvironmentSnapshot();
+	return bSuccess;
 }
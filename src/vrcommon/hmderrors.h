@@ -6,3 +6,30 @@
 const char *GetEnglishStringForHmdError( vr::EVRInitError eError );
 const char *GetIDForVRInitError( vr::EVRInitError eError );
 
+/** Returns the symbol name (e.g. "VRCompositorError_DoNotHaveFocus") for a value of any of the error
+* enums in openvr.h, or NULL if the value is not a known member. Lookups are a single table index. */
+const char *GetErrorEnumName( vr::EVRInitError eError );
+const char *GetErrorEnumName( vr::ETrackedPropertyError eError );
+const char *GetErrorEnumName( vr::EVRApplicationError eError );
+const char *GetErrorEnumName( vr::EVRSettingsError eError );
+const char *GetErrorEnumName( vr::EVRCompositorError eError );
+const char *GetErrorEnumName( vr::EVROverlayError eError );
+const char *GetErrorEnumName( vr::EVRFirmwareError eError );
+const char *GetErrorEnumName( vr::EVRNotificationError eError );
+const char *GetErrorEnumName( vr::EVRTrackedCameraError eError );
+const char *GetErrorEnumName( vr::EVRRenderModelError eError );
+const char *GetErrorEnumName( vr::EVRScreenshotError eError );
+
+/** Looks up an error enum value from its symbol name through a hash of the names. Returns false
+* and leaves the output untouched if the name is not a member of that enum. */
+bool GetErrorEnumFromName( const char *pchName, vr::EVRInitError *peError );
+bool GetErrorEnumFromName( const char *pchName, vr::ETrackedPropertyError *peError );
+bool GetErrorEnumFromName( const char *pchName, vr::EVRApplicationError *peError );
+bool GetErrorEnumFromName( const char *pchName, vr::EVRSettingsError *peError );
+bool GetErrorEnumFromName( const char *pchName, vr::EVRCompositorError *peError );
+bool GetErrorEnumFromName( const char *pchName, vr::EVROverlayError *peError );
+bool GetErrorEnumFromName( const char *pchName, vr::EVRFirmwareError *peError );
+bool GetErrorEnumFromName( const char *pchName, vr::EVRNotificationError *peError );
+bool GetErrorEnumFromName( const char *pchName, vr::EVRTrackedCameraError *peError );
+bool GetErrorEnumFromName( const char *pchName, vr::EVRRenderModelError *peError );
+bool GetErrorEnumFromName( const char *pchName, vr::EVRScreenshotError *peError );
@@ -1,12 +1,12 @@
 //========= Copyright Valve Corporation ============//
 #include "hmderrors.h"
 #include <stdio.h>
+#include <string.h>
 #include <algorithm>
+#include <vector>
 
 using namespace vr;
 
-#define RETURN_ENUM_AS_STRING(enumValue) case enumValue: return #enumValue;
-
 
 const char *GetEnglishStringForHmdError( vr::EVRInitError eError )
 {
@@ -102,103 +102,377 @@ const char *GetEnglishStringForHmdError( vr::EVRInitError eError )
 }
 
 
-const char *GetIDForVRInitError( vr::EVRInitError eError )
+//-----------------------------------------------------------------------------
+// Purpose: Name tables for the error enums in openvr.h. The entries and their
+//          name hashes are compile time constants; the value and name indices
+//          are built from them on first use.
+//-----------------------------------------------------------------------------
+struct VREnumName_t
 {
-	switch( eError )
+	int32_t nValue;
+	const char *pchName;
+	uint32_t unNameHash;
+};
+
+// FNV-1a, written recursively so it can run at compile time
+static constexpr uint32_t HashEnumName( const char *pchName, uint32_t unHash = 2166136261u )
+{
+	return *pchName ? HashEnumName( pchName + 1, ( unHash ^ (uint8_t)*pchName ) * 16777619u ) : unHash;
+}
+
+#define VR_ENUM_NAME( enumValue ) { enumValue, #enumValue, HashEnumName( #enumValue ) },
+
+static const VREnumName_t k_rVRInitErrorNames[] =
+{
+	VR_ENUM_NAME( VRInitError_None )
+	VR_ENUM_NAME( VRInitError_Unknown )
+	VR_ENUM_NAME( VRInitError_Init_InstallationNotFound )
+	VR_ENUM_NAME( VRInitError_Init_InstallationCorrupt )
+	VR_ENUM_NAME( VRInitError_Init_VRClientDLLNotFound )
+	VR_ENUM_NAME( VRInitError_Init_FileNotFound )
+	VR_ENUM_NAME( VRInitError_Init_FactoryNotFound )
+	VR_ENUM_NAME( VRInitError_Init_InterfaceNotFound )
+	VR_ENUM_NAME( VRInitError_Init_InvalidInterface )
+	VR_ENUM_NAME( VRInitError_Init_UserConfigDirectoryInvalid )
+	VR_ENUM_NAME( VRInitError_Init_HmdNotFound )
+	VR_ENUM_NAME( VRInitError_Init_NotInitialized )
+	VR_ENUM_NAME( VRInitError_Init_PathRegistryNotFound )
+	VR_ENUM_NAME( VRInitError_Init_NoConfigPath )
+	VR_ENUM_NAME( VRInitError_Init_NoLogPath )
+	VR_ENUM_NAME( VRInitError_Init_PathRegistryNotWritable )
+	VR_ENUM_NAME( VRInitError_Init_AppInfoInitFailed )
+	VR_ENUM_NAME( VRInitError_Init_Retry )
+	VR_ENUM_NAME( VRInitError_Init_InitCanceledByUser )
+	VR_ENUM_NAME( VRInitError_Init_AnotherAppLaunching )
+	VR_ENUM_NAME( VRInitError_Init_SettingsInitFailed )
+	VR_ENUM_NAME( VRInitError_Init_ShuttingDown )
+	VR_ENUM_NAME( VRInitError_Init_TooManyObjects )
+	VR_ENUM_NAME( VRInitError_Init_NoServerForBackgroundApp )
+	VR_ENUM_NAME( VRInitError_Init_NotSupportedWithCompositor )
+	VR_ENUM_NAME( VRInitError_Init_NotAvailableToUtilityApps )
+	VR_ENUM_NAME( VRInitError_Init_Internal )
+	VR_ENUM_NAME( VRInitError_Init_HmdDriverIdIsNone )
+	VR_ENUM_NAME( VRInitError_Init_HmdNotFoundPresenceFailed )
+	VR_ENUM_NAME( VRInitError_Init_VRMonitorNotFound )
+	VR_ENUM_NAME( VRInitError_Init_VRMonitorStartupFailed )
+	VR_ENUM_NAME( VRInitError_Init_LowPowerWatchdogNotSupported )
+	VR_ENUM_NAME( VRInitError_Init_InvalidApplicationType )
+	VR_ENUM_NAME( VRInitError_Init_NotAvailableToWatchdogApps )
+	VR_ENUM_NAME( VRInitError_Init_WatchdogDisabledInSettings )
+	VR_ENUM_NAME( VRInitError_Init_VRDashboardNotFound )
+	VR_ENUM_NAME( VRInitError_Init_VRDashboardStartupFailed )
+	VR_ENUM_NAME( VRInitError_Driver_Failed )
+	VR_ENUM_NAME( VRInitError_Driver_Unknown )
+	VR_ENUM_NAME( VRInitError_Driver_HmdUnknown )
+	VR_ENUM_NAME( VRInitError_Driver_NotLoaded )
+	VR_ENUM_NAME( VRInitError_Driver_RuntimeOutOfDate )
+	VR_ENUM_NAME( VRInitError_Driver_HmdInUse )
+	VR_ENUM_NAME( VRInitError_Driver_NotCalibrated )
+	VR_ENUM_NAME( VRInitError_Driver_CalibrationInvalid )
+	VR_ENUM_NAME( VRInitError_Driver_HmdDisplayNotFound )
+	VR_ENUM_NAME( VRInitError_Driver_TrackedDeviceInterfaceUnknown )
+	VR_ENUM_NAME( VRInitError_Driver_HmdDriverIdOutOfBounds )
+	VR_ENUM_NAME( VRInitError_Driver_HmdDisplayMirrored )
+	VR_ENUM_NAME( VRInitError_IPC_ServerInitFailed )
+	VR_ENUM_NAME( VRInitError_IPC_ConnectFailed )
+	VR_ENUM_NAME( VRInitError_IPC_SharedStateInitFailed )
+	VR_ENUM_NAME( VRInitError_IPC_CompositorInitFailed )
+	VR_ENUM_NAME( VRInitError_IPC_MutexInitFailed )
+	VR_ENUM_NAME( VRInitError_IPC_Failed )
+	VR_ENUM_NAME( VRInitError_IPC_CompositorConnectFailed )
+	VR_ENUM_NAME( VRInitError_IPC_CompositorInvalidConnectResponse )
+	VR_ENUM_NAME( VRInitError_IPC_ConnectFailedAfterMultipleAttempts )
+	VR_ENUM_NAME( VRInitError_Compositor_Failed )
+	VR_ENUM_NAME( VRInitError_Compositor_D3D11HardwareRequired )
+	VR_ENUM_NAME( VRInitError_Compositor_FirmwareRequiresUpdate )
+	VR_ENUM_NAME( VRInitError_Compositor_OverlayInitFailed )
+	VR_ENUM_NAME( VRInitError_Compositor_ScreenshotsInitFailed )
+	VR_ENUM_NAME( VRInitError_VendorSpecific_UnableToConnectToOculusRuntime )
+	VR_ENUM_NAME( VRInitError_VendorSpecific_HmdFound_CantOpenDevice )
+	VR_ENUM_NAME( VRInitError_VendorSpecific_HmdFound_UnableToRequestConfigStart )
+	VR_ENUM_NAME( VRInitError_VendorSpecific_HmdFound_NoStoredConfig )
+	VR_ENUM_NAME( VRInitError_VendorSpecific_HmdFound_ConfigTooBig )
+	VR_ENUM_NAME( VRInitError_VendorSpecific_HmdFound_ConfigTooSmall )
+	VR_ENUM_NAME( VRInitError_VendorSpecific_HmdFound_UnableToInitZLib )
+	VR_ENUM_NAME( VRInitError_VendorSpecific_HmdFound_CantReadFirmwareVersion )
+	VR_ENUM_NAME( VRInitError_VendorSpecific_HmdFound_UnableToSendUserDataStart )
+	VR_ENUM_NAME( VRInitError_VendorSpecific_HmdFound_UnableToGetUserDataStart )
+	VR_ENUM_NAME( VRInitError_VendorSpecific_HmdFound_UnableToGetUserDataNext )
+	VR_ENUM_NAME( VRInitError_VendorSpecific_HmdFound_UserDataAddressRange )
+	VR_ENUM_NAME( VRInitError_VendorSpecific_HmdFound_UserDataError )
+	VR_ENUM_NAME( VRInitError_VendorSpecific_HmdFound_ConfigFailedSanityCheck )
+	VR_ENUM_NAME( VRInitError_Steam_SteamInstallationNotFound )
+};
+
+static const VREnumName_t k_rTrackedPropertyErrorNames[] =
+{
+	VR_ENUM_NAME( TrackedProp_Success )
+	VR_ENUM_NAME( TrackedProp_WrongDataType )
+	VR_ENUM_NAME( TrackedProp_WrongDeviceClass )
+	VR_ENUM_NAME( TrackedProp_BufferTooSmall )
+	VR_ENUM_NAME( TrackedProp_UnknownProperty )
+	VR_ENUM_NAME( TrackedProp_InvalidDevice )
+	VR_ENUM_NAME( TrackedProp_CouldNotContactServer )
+	VR_ENUM_NAME( TrackedProp_ValueNotProvidedByDevice )
+	VR_ENUM_NAME( TrackedProp_StringExceedsMaximumLength )
+	VR_ENUM_NAME( TrackedProp_NotYetAvailable )
+	VR_ENUM_NAME( TrackedProp_PermissionDenied )
+};
+
+static const VREnumName_t k_rVRApplicationErrorNames[] =
+{
+	VR_ENUM_NAME( VRApplicationError_None )
+	VR_ENUM_NAME( VRApplicationError_AppKeyAlreadyExists )
+	VR_ENUM_NAME( VRApplicationError_NoManifest )
+	VR_ENUM_NAME( VRApplicationError_NoApplication )
+	VR_ENUM_NAME( VRApplicationError_InvalidIndex )
+	VR_ENUM_NAME( VRApplicationError_UnknownApplication )
+	VR_ENUM_NAME( VRApplicationError_IPCFailed )
+	VR_ENUM_NAME( VRApplicationError_ApplicationAlreadyRunning )
+	VR_ENUM_NAME( VRApplicationError_InvalidManifest )
+	VR_ENUM_NAME( VRApplicationError_InvalidApplication )
+	VR_ENUM_NAME( VRApplicationError_LaunchFailed )
+	VR_ENUM_NAME( VRApplicationError_ApplicationAlreadyStarting )
+	VR_ENUM_NAME( VRApplicationError_LaunchInProgress )
+	VR_ENUM_NAME( VRApplicationError_OldApplicationQuitting )
+	VR_ENUM_NAME( VRApplicationError_TransitionAborted )
+	VR_ENUM_NAME( VRApplicationError_IsTemplate )
+	VR_ENUM_NAME( VRApplicationError_BufferTooSmall )
+	VR_ENUM_NAME( VRApplicationError_PropertyNotSet )
+	VR_ENUM_NAME( VRApplicationError_UnknownProperty )
+	VR_ENUM_NAME( VRApplicationError_InvalidParameter )
+};
+
+static const VREnumName_t k_rVRSettingsErrorNames[] =
+{
+	VR_ENUM_NAME( VRSettingsError_None )
+	VR_ENUM_NAME( VRSettingsError_IPCFailed )
+	VR_ENUM_NAME( VRSettingsError_WriteFailed )
+	VR_ENUM_NAME( VRSettingsError_ReadFailed )
+	VR_ENUM_NAME( VRSettingsError_JsonParseFailed )
+	VR_ENUM_NAME( VRSettingsError_UnsetSettingHasNoDefault )
+};
+
+static const VREnumName_t k_rVRCompositorErrorNames[] =
+{
+	VR_ENUM_NAME( VRCompositorError_None )
+	VR_ENUM_NAME( VRCompositorError_RequestFailed )
+	VR_ENUM_NAME( VRCompositorError_IncompatibleVersion )
+	VR_ENUM_NAME( VRCompositorError_DoNotHaveFocus )
+	VR_ENUM_NAME( VRCompositorError_InvalidTexture )
+	VR_ENUM_NAME( VRCompositorError_IsNotSceneApplication )
+	VR_ENUM_NAME( VRCompositorError_TextureIsOnWrongDevice )
+	VR_ENUM_NAME( VRCompositorError_TextureUsesUnsupportedFormat )
+	VR_ENUM_NAME( VRCompositorError_SharedTexturesNotSupported )
+	VR_ENUM_NAME( VRCompositorError_IndexOutOfRange )
+	VR_ENUM_NAME( VRCompositorError_AlreadySubmitted )
+};
+
+static const VREnumName_t k_rVROverlayErrorNames[] =
+{
+	VR_ENUM_NAME( VROverlayError_None )
+	VR_ENUM_NAME( VROverlayError_UnknownOverlay )
+	VR_ENUM_NAME( VROverlayError_InvalidHandle )
+	VR_ENUM_NAME( VROverlayError_PermissionDenied )
+	VR_ENUM_NAME( VROverlayError_OverlayLimitExceeded )
+	VR_ENUM_NAME( VROverlayError_WrongVisibilityType )
+	VR_ENUM_NAME( VROverlayError_KeyTooLong )
+	VR_ENUM_NAME( VROverlayError_NameTooLong )
+	VR_ENUM_NAME( VROverlayError_KeyInUse )
+	VR_ENUM_NAME( VROverlayError_WrongTransformType )
+	VR_ENUM_NAME( VROverlayError_InvalidTrackedDevice )
+	VR_ENUM_NAME( VROverlayError_InvalidParameter )
+	VR_ENUM_NAME( VROverlayError_ThumbnailCantBeDestroyed )
+	VR_ENUM_NAME( VROverlayError_ArrayTooSmall )
+	VR_ENUM_NAME( VROverlayError_RequestFailed )
+	VR_ENUM_NAME( VROverlayError_InvalidTexture )
+	VR_ENUM_NAME( VROverlayError_UnableToLoadFile )
+	VR_ENUM_NAME( VROverlayError_KeyboardAlreadyInUse )
+	VR_ENUM_NAME( VROverlayError_NoNeighbor )
+	VR_ENUM_NAME( VROverlayError_TooManyMaskPrimitives )
+	VR_ENUM_NAME( VROverlayError_BadMaskPrimitive )
+};
+
+static const VREnumName_t k_rVRFirmwareErrorNames[] =
+{
+	VR_ENUM_NAME( VRFirmwareError_None )
+	VR_ENUM_NAME( VRFirmwareError_Success )
+	VR_ENUM_NAME( VRFirmwareError_Fail )
+};
+
+static const VREnumName_t k_rVRNotificationErrorNames[] =
+{
+	VR_ENUM_NAME( VRNotificationError_OK )
+	VR_ENUM_NAME( VRNotificationError_InvalidNotificationId )
+	VR_ENUM_NAME( VRNotificationError_NotificationQueueFull )
+	VR_ENUM_NAME( VRNotificationError_InvalidOverlayHandle )
+	VR_ENUM_NAME( VRNotificationError_SystemWithUserValueAlreadyExists )
+};
+
+static const VREnumName_t k_rVRTrackedCameraErrorNames[] =
+{
+	VR_ENUM_NAME( VRTrackedCameraError_None )
+	VR_ENUM_NAME( VRTrackedCameraError_OperationFailed )
+	VR_ENUM_NAME( VRTrackedCameraError_InvalidHandle )
+	VR_ENUM_NAME( VRTrackedCameraError_InvalidFrameHeaderVersion )
+	VR_ENUM_NAME( VRTrackedCameraError_OutOfHandles )
+	VR_ENUM_NAME( VRTrackedCameraError_IPCFailure )
+	VR_ENUM_NAME( VRTrackedCameraError_NotSupportedForThisDevice )
+	VR_ENUM_NAME( VRTrackedCameraError_SharedMemoryFailure )
+	VR_ENUM_NAME( VRTrackedCameraError_FrameBufferingFailure )
+	VR_ENUM_NAME( VRTrackedCameraError_StreamSetupFailure )
+	VR_ENUM_NAME( VRTrackedCameraError_InvalidGLTextureId )
+	VR_ENUM_NAME( VRTrackedCameraError_InvalidSharedTextureHandle )
+	VR_ENUM_NAME( VRTrackedCameraError_FailedToGetGLTextureId )
+	VR_ENUM_NAME( VRTrackedCameraError_SharedTextureFailure )
+	VR_ENUM_NAME( VRTrackedCameraError_NoFrameAvailable )
+	VR_ENUM_NAME( VRTrackedCameraError_InvalidArgument )
+	VR_ENUM_NAME( VRTrackedCameraError_InvalidFrameBufferSize )
+};
+
+static const VREnumName_t k_rVRRenderModelErrorNames[] =
+{
+	VR_ENUM_NAME( VRRenderModelError_None )
+	VR_ENUM_NAME( VRRenderModelError_Loading )
+	VR_ENUM_NAME( VRRenderModelError_NotSupported )
+	VR_ENUM_NAME( VRRenderModelError_InvalidArg )
+	VR_ENUM_NAME( VRRenderModelError_InvalidModel )
+	VR_ENUM_NAME( VRRenderModelError_NoShapes )
+	VR_ENUM_NAME( VRRenderModelError_MultipleShapes )
+	VR_ENUM_NAME( VRRenderModelError_TooManyVertices )
+	VR_ENUM_NAME( VRRenderModelError_MultipleTextures )
+	VR_ENUM_NAME( VRRenderModelError_BufferTooSmall )
+	VR_ENUM_NAME( VRRenderModelError_NotEnoughNormals )
+	VR_ENUM_NAME( VRRenderModelError_NotEnoughTexCoords )
+	VR_ENUM_NAME( VRRenderModelError_InvalidTexture )
+};
+
+static const VREnumName_t k_rVRScreenshotErrorNames[] =
+{
+	VR_ENUM_NAME( VRScreenshotError_None )
+	VR_ENUM_NAME( VRScreenshotError_RequestFailed )
+	VR_ENUM_NAME( VRScreenshotError_IncompatibleVersion )
+	VR_ENUM_NAME( VRScreenshotError_NotFound )
+	VR_ENUM_NAME( VRScreenshotError_BufferTooSmall )
+	VR_ENUM_NAME( VRScreenshotError_ScreenshotAlreadyInProgress )
+};
+
+#undef VR_ENUM_NAME
+
+class CVREnumNameTable
+{
+public:
+	CVREnumNameTable( const VREnumName_t *pEntries, uint32_t unCount )
+		: m_pEntries( pEntries )
+		, m_nMinValue( 0 )
 	{
-		RETURN_ENUM_AS_STRING( VRInitError_None );
-		RETURN_ENUM_AS_STRING( VRInitError_Unknown );
-
-		RETURN_ENUM_AS_STRING( VRInitError_Init_InstallationNotFound );
-		RETURN_ENUM_AS_STRING( VRInitError_Init_InstallationCorrupt );
-		RETURN_ENUM_AS_STRING( VRInitError_Init_VRClientDLLNotFound );
-		RETURN_ENUM_AS_STRING( VRInitError_Init_FileNotFound );
-		RETURN_ENUM_AS_STRING( VRInitError_Init_FactoryNotFound );
-		RETURN_ENUM_AS_STRING( VRInitError_Init_InterfaceNotFound );
-		RETURN_ENUM_AS_STRING( VRInitError_Init_InvalidInterface );
-		RETURN_ENUM_AS_STRING( VRInitError_Init_UserConfigDirectoryInvalid );
-		RETURN_ENUM_AS_STRING( VRInitError_Init_HmdNotFound );
-		RETURN_ENUM_AS_STRING( VRInitError_Init_NotInitialized );
-		RETURN_ENUM_AS_STRING( VRInitError_Init_PathRegistryNotFound );
-		RETURN_ENUM_AS_STRING( VRInitError_Init_NoConfigPath );
-		RETURN_ENUM_AS_STRING( VRInitError_Init_NoLogPath );
-		RETURN_ENUM_AS_STRING( VRInitError_Init_PathRegistryNotWritable );
-		RETURN_ENUM_AS_STRING( VRInitError_Init_AppInfoInitFailed );
-		RETURN_ENUM_AS_STRING( VRInitError_Init_Retry );
-		RETURN_ENUM_AS_STRING( VRInitError_Init_InitCanceledByUser );
-		RETURN_ENUM_AS_STRING( VRInitError_Init_AnotherAppLaunching );
-		RETURN_ENUM_AS_STRING( VRInitError_Init_SettingsInitFailed );
-		RETURN_ENUM_AS_STRING( VRInitError_Init_ShuttingDown );
-		RETURN_ENUM_AS_STRING( VRInitError_Init_TooManyObjects );
-		RETURN_ENUM_AS_STRING( VRInitError_Init_NoServerForBackgroundApp );
-		RETURN_ENUM_AS_STRING( VRInitError_Init_NotSupportedWithCompositor );
-		RETURN_ENUM_AS_STRING( VRInitError_Init_NotAvailableToUtilityApps );
-		RETURN_ENUM_AS_STRING( VRInitError_Init_Internal );
-		RETURN_ENUM_AS_STRING( VRInitError_Init_VRMonitorNotFound );
-		RETURN_ENUM_AS_STRING( VRInitError_Init_VRMonitorStartupFailed );
-		RETURN_ENUM_AS_STRING( VRInitError_Init_LowPowerWatchdogNotSupported );
-		RETURN_ENUM_AS_STRING( VRInitError_Init_InvalidApplicationType );
-		RETURN_ENUM_AS_STRING( VRInitError_Init_NotAvailableToWatchdogApps );
-		RETURN_ENUM_AS_STRING( VRInitError_Init_WatchdogDisabledInSettings );
-
-		RETURN_ENUM_AS_STRING( VRInitError_Init_HmdDriverIdIsNone );
-		RETURN_ENUM_AS_STRING( VRInitError_Init_HmdNotFoundPresenceFailed );
-
-		RETURN_ENUM_AS_STRING( VRInitError_Driver_Failed );
-		RETURN_ENUM_AS_STRING( VRInitError_Driver_Unknown );
-		RETURN_ENUM_AS_STRING( VRInitError_Driver_HmdUnknown);
-		RETURN_ENUM_AS_STRING( VRInitError_Driver_NotLoaded);
-		RETURN_ENUM_AS_STRING( VRInitError_Driver_RuntimeOutOfDate);
-		RETURN_ENUM_AS_STRING( VRInitError_Driver_HmdInUse);
-		RETURN_ENUM_AS_STRING( VRInitError_Driver_NotCalibrated);
-		RETURN_ENUM_AS_STRING( VRInitError_Driver_CalibrationInvalid);
-		RETURN_ENUM_AS_STRING( VRInitError_Driver_HmdDisplayNotFound);
-		RETURN_ENUM_AS_STRING( VRInitError_Driver_TrackedDeviceInterfaceUnknown );
-		// RETURN_ENUM_AS_STRING( VRInitError_Driver_HmdDisplayNotFoundAfterFix );
-		RETURN_ENUM_AS_STRING( VRInitError_Driver_HmdDriverIdOutOfBounds );
-		RETURN_ENUM_AS_STRING( VRInitError_Driver_HmdDisplayMirrored );
-
-		RETURN_ENUM_AS_STRING( VRInitError_IPC_ServerInitFailed);
-		RETURN_ENUM_AS_STRING( VRInitError_IPC_ConnectFailed);
-		RETURN_ENUM_AS_STRING( VRInitError_IPC_SharedStateInitFailed);
-		RETURN_ENUM_AS_STRING( VRInitError_IPC_CompositorInitFailed);
-		RETURN_ENUM_AS_STRING( VRInitError_IPC_MutexInitFailed);
-		RETURN_ENUM_AS_STRING( VRInitError_IPC_Failed);
-		RETURN_ENUM_AS_STRING( VRInitError_IPC_CompositorConnectFailed);
-		RETURN_ENUM_AS_STRING( VRInitError_IPC_CompositorInvalidConnectResponse);
-		RETURN_ENUM_AS_STRING( VRInitError_IPC_ConnectFailedAfterMultipleAttempts);
-
-		RETURN_ENUM_AS_STRING( VRInitError_Compositor_Failed );
-		RETURN_ENUM_AS_STRING( VRInitError_Compositor_D3D11HardwareRequired );
-		RETURN_ENUM_AS_STRING( VRInitError_Compositor_FirmwareRequiresUpdate );
-		RETURN_ENUM_AS_STRING( VRInitError_Compositor_OverlayInitFailed );
-
-		// Oculus
-		RETURN_ENUM_AS_STRING( VRInitError_VendorSpecific_UnableToConnectToOculusRuntime);
-
-		// Lighthouse
-		RETURN_ENUM_AS_STRING( VRInitError_VendorSpecific_HmdFound_CantOpenDevice);
-		RETURN_ENUM_AS_STRING( VRInitError_VendorSpecific_HmdFound_UnableToRequestConfigStart);
-		RETURN_ENUM_AS_STRING( VRInitError_VendorSpecific_HmdFound_NoStoredConfig);
-		RETURN_ENUM_AS_STRING( VRInitError_VendorSpecific_HmdFound_ConfigFailedSanityCheck );
-		RETURN_ENUM_AS_STRING( VRInitError_VendorSpecific_HmdFound_ConfigTooBig );
-		RETURN_ENUM_AS_STRING( VRInitError_VendorSpecific_HmdFound_ConfigTooSmall );
-		RETURN_ENUM_AS_STRING( VRInitError_VendorSpecific_HmdFound_UnableToInitZLib );
-		RETURN_ENUM_AS_STRING( VRInitError_VendorSpecific_HmdFound_CantReadFirmwareVersion );
-		RETURN_ENUM_AS_STRING( VRInitError_VendorSpecific_HmdFound_UnableToSendUserDataStart );
-		RETURN_ENUM_AS_STRING( VRInitError_VendorSpecific_HmdFound_UnableToGetUserDataStart );
-		RETURN_ENUM_AS_STRING( VRInitError_VendorSpecific_HmdFound_UnableToGetUserDataNext );
-		RETURN_ENUM_AS_STRING( VRInitError_VendorSpecific_HmdFound_UserDataAddressRange );
-		RETURN_ENUM_AS_STRING( VRInitError_VendorSpecific_HmdFound_UserDataError );
-
-		RETURN_ENUM_AS_STRING( VRInitError_Steam_SteamInstallationNotFound );
+		int32_t nMaxValue = 0;
+		for ( uint32_t i = 0; i < unCount; i++ )
+		{
+			m_nMinValue = std::min( m_nMinValue, pEntries[i].nValue );
+			nMaxValue = std::max( nMaxValue, pEntries[i].nValue );
+		}
 
-	default:
+		// every enum in openvr.h is small and dense enough for a direct index,
+		// entries are stored +1 so zero means "no such value"
+		m_vecValueIndex.resize( nMaxValue - m_nMinValue + 1, 0 );
+		for ( uint32_t i = 0; i < unCount; i++ )
 		{
-			static char buf[128];
-			sprintf( buf, "Unknown error (%d)", eError );
-			return buf;
+			uint16_t &unSlot = m_vecValueIndex[ pEntries[i].nValue - m_nMinValue ];
+			if ( unSlot == 0 )
+				unSlot = (uint16_t)( i + 1 );
+		}
+
+		// open addressing at a load factor of at most 1/2
+		uint32_t unBuckets = 4;
+		while ( unBuckets < unCount * 2 )
+			unBuckets *= 2;
+		m_vecNameBuckets.resize( unBuckets, 0 );
+		for ( uint32_t i = 0; i < unCount; i++ )
+		{
+			uint32_t unBucket = pEntries[i].unNameHash & ( unBuckets - 1 );
+			while ( m_vecNameBuckets[ unBucket ] != 0 )
+				unBucket = ( unBucket + 1 ) & ( unBuckets - 1 );
+			m_vecNameBuckets[ unBucket ] = (uint16_t)( i + 1 );
+		}
+	}
+
+	const char *GetName( int32_t nValue ) const
+	{
+		uint32_t unOffset = (uint32_t)( nValue - m_nMinValue );
+		if ( unOffset >= m_vecValueIndex.size() || m_vecValueIndex[ unOffset ] == 0 )
+			return NULL;
+		return m_pEntries[ m_vecValueIndex[ unOffset ] - 1 ].pchName;
+	}
+
+	bool GetValue( const char *pchName, int32_t *pnValue ) const
+	{
+		if ( !pchName )
+			return false;
+
+		uint32_t unHash = HashEnumName( pchName );
+		uint32_t unMask = (uint32_t)m_vecNameBuckets.size() - 1;
+		for ( uint32_t unBucket = unHash & unMask; m_vecNameBuckets[ unBucket ] != 0; unBucket = ( unBucket + 1 ) & unMask )
+		{
+			const VREnumName_t &entry = m_pEntries[ m_vecNameBuckets[ unBucket ] - 1 ];
+			if ( entry.unNameHash == unHash && !strcmp( entry.pchName, pchName ) )
+			{
+				*pnValue = entry.nValue;
+				return true;
+			}
 		}
+		return false;
+	}
+
+private:
+	const VREnumName_t *m_pEntries;
+	int32_t m_nMinValue;
+	std::vector< uint16_t > m_vecValueIndex;
+	std::vector< uint16_t > m_vecNameBuckets;
+};
+
+#define DEFINE_ERROR_ENUM_NAME_TABLE( EnumType, rEntries ) \
+	static const CVREnumNameTable &Get##EnumType##NameTable() \
+	{ \
+		static const CVREnumNameTable s_table( rEntries, sizeof( rEntries ) / sizeof( rEntries[0] ) ); \
+		return s_table; \
+	} \
+	const char *GetErrorEnumName( vr::EnumType eError ) \
+	{ \
+		return Get##EnumType##NameTable().GetName( (int32_t)eError ); \
+	} \
+	bool GetErrorEnumFromName( const char *pchName, vr::EnumType *peError ) \
+	{ \
+		int32_t nValue; \
+		if ( !Get##EnumType##NameTable().GetValue( pchName, &nValue ) ) \
+			return false; \
+		*peError = (vr::EnumType)nValue; \
+		return true; \
 	}
+
+DEFINE_ERROR_ENUM_NAME_TABLE( EVRInitError, k_rVRInitErrorNames )
+DEFINE_ERROR_ENUM_NAME_TABLE( ETrackedPropertyError, k_rTrackedPropertyErrorNames )
+DEFINE_ERROR_ENUM_NAME_TABLE( EVRApplicationError, k_rVRApplicationErrorNames )
+DEFINE_ERROR_ENUM_NAME_TABLE( EVRSettingsError, k_rVRSettingsErrorNames )
+DEFINE_ERROR_ENUM_NAME_TABLE( EVRCompositorError, k_rVRCompositorErrorNames )
+DEFINE_ERROR_ENUM_NAME_TABLE( EVROverlayError, k_rVROverlayErrorNames )
+DEFINE_ERROR_ENUM_NAME_TABLE( EVRFirmwareError, k_rVRFirmwareErrorNames )
+DEFINE_ERROR_ENUM_NAME_TABLE( EVRNotificationError, k_rVRNotificationErrorNames )
+DEFINE_ERROR_ENUM_NAME_TABLE( EVRTrackedCameraError, k_rVRTrackedCameraErrorNames )
+DEFINE_ERROR_ENUM_NAME_TABLE( EVRRenderModelError, k_rVRRenderModelErrorNames )
+DEFINE_ERROR_ENUM_NAME_TABLE( EVRScreenshotError, k_rVRScreenshotErrorNames )
+
+#undef DEFINE_ERROR_ENUM_NAME_TABLE
+
+
+const char *GetIDForVRInitError( vr::EVRInitError eError )
+{
+	const char *pchName = GetErrorEnumName( eError );
+	if ( pchName )
+		return pchName;
+
+	static char buf[128];
+	sprintf( buf, "Unknown error (%d)", eError );
+	return buf;
 }
 
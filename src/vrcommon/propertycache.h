@@ -0,0 +1,93 @@
+//========= Copyright Valve Corporation ============//
+#pragma once
+
+#include "openvr.h"
+
+#include <atomic>
+#include <mutex>
+#include <stdint.h>
+
+/** Client side cache of tracked device properties.
+*
+* Each device has a fixed table of property slots. Reads take no lock: every slot is guarded by a
+* sequence number and tagged with the device generation it was filled in, so invalidating a device
+* is a single increment and stale slots are simply ignored. Misses go to the runtime and are filled
+* under a per device lock, so only the first reader of a property pays for the call.
+*
+* Strings longer than k_unMaxCachedStringSize and transient errors (NotYetAvailable,
+* CouldNotContactServer, ...) are never cached. */
+class CTrackedPropertyCache
+{
+public:
+	static const uint32_t k_unSlotsPerDevice = 64;
+	static const uint32_t k_unMaxCachedStringSize = 256;
+
+	CTrackedPropertyCache();
+
+	bool GetBool( vr::IVRSystem *pSystem, vr::TrackedDeviceIndex_t unDeviceIndex, vr::ETrackedDeviceProperty prop, vr::ETrackedPropertyError *pError );
+	float GetFloat( vr::IVRSystem *pSystem, vr::TrackedDeviceIndex_t unDeviceIndex, vr::ETrackedDeviceProperty prop, vr::ETrackedPropertyError *pError );
+	int32_t GetInt32( vr::IVRSystem *pSystem, vr::TrackedDeviceIndex_t unDeviceIndex, vr::ETrackedDeviceProperty prop, vr::ETrackedPropertyError *pError );
+	uint64_t GetUint64( vr::IVRSystem *pSystem, vr::TrackedDeviceIndex_t unDeviceIndex, vr::ETrackedDeviceProperty prop, vr::ETrackedPropertyError *pError );
+	vr::HmdMatrix34_t GetMatrix34( vr::IVRSystem *pSystem, vr::TrackedDeviceIndex_t unDeviceIndex, vr::ETrackedDeviceProperty prop, vr::ETrackedPropertyError *pError );
+
+	/** Same contract as IVRSystem::GetStringTrackedDeviceProperty: returns the size including the
+	* terminator, and TrackedProp_BufferTooSmall without writing if the buffer can't hold it. */
+	uint32_t GetString( vr::IVRSystem *pSystem, vr::TrackedDeviceIndex_t unDeviceIndex, vr::ETrackedDeviceProperty prop, char *pchValue, uint32_t unBufferSize, vr::ETrackedPropertyError *pError );
+
+	/** Reads a batch of properties into one packed value buffer, see VR_GetTrackedDevicePropertiesBatch.
+	* Returns the value buffer size the whole batch needs. */
+	uint32_t GetProperties( vr::IVRSystem *pSystem, const vr::TrackedPropertyRequest_t *pRequests, uint32_t unRequestCount,
+		vr::TrackedPropertyResult_t *pResults, void *pValueBuffer, uint32_t unValueBufferSize );
+
+	/** Drops everything cached for one device */
+	void InvalidateDevice( vr::TrackedDeviceIndex_t unDeviceIndex );
+
+	/** Drops everything */
+	void InvalidateAll();
+
+	/** Invalidates the device an event is about if the event can change its properties.
+	* Returns true if anything was invalidated. */
+	bool ProcessEvent( const vr::VREvent_t &event );
+
+private:
+	enum EPropertyType
+	{
+		PropertyType_Bool = 1,
+		PropertyType_Float,
+		PropertyType_Int32,
+		PropertyType_Uint64,
+		PropertyType_Matrix34,
+		PropertyType_String,
+	};
+
+	static const uint32_t k_unSlotDataWords = k_unMaxCachedStringSize / 4;
+
+	struct Slot_t
+	{
+		std::atomic< uint32_t > unSequence;		// odd while being written
+		std::atomic< uint32_t > unProperty;		// Prop_Invalid (0) marks a slot that was never used
+		std::atomic< uint32_t > unGeneration;
+		std::atomic< uint32_t > unTypeAndError;	// EPropertyType << 16 | ETrackedPropertyError
+		std::atomic< uint32_t > unSize;			// bytes of value, for strings including the terminator
+		std::atomic< uint32_t > rData[ k_unSlotDataWords ];
+	};
+
+	struct Device_t
+	{
+		std::atomic< uint32_t > unGeneration;
+		std::mutex writeMutex;
+		Slot_t rSlots[ k_unSlotsPerDevice ];
+	};
+
+	template< typename T, typename FnQuery >
+	T GetScalar( vr::TrackedDeviceIndex_t unDeviceIndex, vr::ETrackedDeviceProperty prop, EPropertyType eType, vr::ETrackedPropertyError *pError, FnQuery fnQuery );
+
+	bool Lookup( vr::TrackedDeviceIndex_t unDeviceIndex, vr::ETrackedDeviceProperty prop, EPropertyType eType, uint32_t unGeneration,
+		void *pValue, uint32_t unValueSize, uint32_t *punSize, vr::ETrackedPropertyError *peError );
+	void Store( vr::TrackedDeviceIndex_t unDeviceIndex, vr::ETrackedDeviceProperty prop, EPropertyType eType, uint32_t unGeneration,
+		const void *pValue, uint32_t unSize, vr::ETrackedPropertyError eError );
+
+	static bool BIsCacheableError( vr::ETrackedPropertyError eError );
+
+	Device_t m_rDevices[ vr::k_unMaxTrackedDeviceCount ];
+};
@@ -0,0 +1,387 @@
+//========= Copyright Valve Corporation ============//
+#include "propertycache.h"
+#include <string.h>
+
+using namespace vr;
+
+
+//-----------------------------------------------------------------------------
+// Purpose: Property IDs are clustered in blocks of 1000, so spread them with a
+//          multiplicative hash before taking the low bits
+//-----------------------------------------------------------------------------
+static uint32_t PropertySlotHash( ETrackedDeviceProperty prop )
+{
+	return (uint32_t)prop * 2654435761u;
+}
+
+
+CTrackedPropertyCache::CTrackedPropertyCache()
+{
+	for ( uint32_t unDevice = 0; unDevice < k_unMaxTrackedDeviceCount; unDevice++ )
+	{
+		Device_t &device = m_rDevices[ unDevice ];
+		device.unGeneration.store( 1, std::memory_order_relaxed );
+		for ( uint32_t i = 0; i < k_unSlotsPerDevice; i++ )
+		{
+			device.rSlots[i].unSequence.store( 0, std::memory_order_relaxed );
+			device.rSlots[i].unProperty.store( Prop_Invalid, std::memory_order_relaxed );
+			device.rSlots[i].unGeneration.store( 0, std::memory_order_relaxed );
+		}
+	}
+}
+
+
+//-----------------------------------------------------------------------------
+// Purpose: Errors that describe the property itself rather than the moment it
+//          was asked for, and so will be the same next time
+//-----------------------------------------------------------------------------
+bool CTrackedPropertyCache::BIsCacheableError( ETrackedPropertyError eError )
+{
+	switch ( eError )
+	{
+	case TrackedProp_Success:
+	case TrackedProp_WrongDataType:
+	case TrackedProp_WrongDeviceClass:
+	case TrackedProp_UnknownProperty:
+	case TrackedProp_ValueNotProvidedByDevice:
+		return true;
+	default:
+		return false;
+	}
+}
+
+
+//-----------------------------------------------------------------------------
+// Purpose: Looks a property up without locking. On a hit copies up to
+//          unValueSize bytes of the value and returns true.
+//-----------------------------------------------------------------------------
+bool CTrackedPropertyCache::Lookup( TrackedDeviceIndex_t unDeviceIndex, ETrackedDeviceProperty prop, EPropertyType eType, uint32_t unGeneration,
+	void *pValue, uint32_t unValueSize, uint32_t *punSize, ETrackedPropertyError *peError )
+{
+	const Device_t &device = m_rDevices[ unDeviceIndex ];
+	uint32_t rTemp[ k_unSlotDataWords ];
+
+	uint32_t unHash = PropertySlotHash( prop );
+	for ( uint32_t i = 0; i < k_unSlotsPerDevice; i++ )
+	{
+		const Slot_t &slot = device.rSlots[ ( unHash + i ) & ( k_unSlotsPerDevice - 1 ) ];
+
+		uint32_t unSequence = slot.unSequence.load( std::memory_order_acquire );
+		if ( unSequence & 1 )
+			return false;
+
+		uint32_t unProperty = slot.unProperty.load( std::memory_order_relaxed );
+		if ( unProperty == Prop_Invalid )
+			return false;
+		if ( unProperty != (uint32_t)prop )
+			continue;
+
+		uint32_t unSlotGeneration = slot.unGeneration.load( std::memory_order_relaxed );
+		uint32_t unTypeAndError = slot.unTypeAndError.load( std::memory_order_relaxed );
+		uint32_t unSize = slot.unSize.load( std::memory_order_relaxed );
+		if ( unSlotGeneration != unGeneration || ( unTypeAndError >> 16 ) != (uint32_t)eType )
+			continue;
+
+		uint32_t unCopySize = unSize < unValueSize ? unSize : unValueSize;
+		for ( uint32_t w = 0; w < ( unCopySize + 3 ) / 4; w++ )
+			rTemp[w] = slot.rData[w].load( std::memory_order_relaxed );
+
+		std::atomic_thread_fence( std::memory_order_acquire );
+		if ( slot.unSequence.load( std::memory_order_relaxed ) != unSequence )
+			return false;
+
+		memcpy( pValue, rTemp, unCopySize );
+		*punSize = unSize;
+		*peError = (ETrackedPropertyError)( unTypeAndError & 0xFFFF );
+		return true;
+	}
+	return false;
+}
+
+
+//-----------------------------------------------------------------------------
+// Purpose: Fills a slot with a value read from the runtime, unless the device
+//          was invalidated since unGeneration was read
+//-----------------------------------------------------------------------------
+void CTrackedPropertyCache::Store( TrackedDeviceIndex_t unDeviceIndex, ETrackedDeviceProperty prop, EPropertyType eType, uint32_t unGeneration,
+	const void *pValue, uint32_t unSize, ETrackedPropertyError eError )
+{
+	if ( !BIsCacheableError( eError ) || unSize > k_unMaxCachedStringSize )
+		return;
+
+	Device_t &device = m_rDevices[ unDeviceIndex ];
+	std::lock_guard< std::mutex > lock( device.writeMutex );
+	if ( device.unGeneration.load( std::memory_order_relaxed ) != unGeneration )
+		return;
+
+	// reuse the slot already holding this property, else the first stale or unused one
+	Slot_t *pTarget = NULL;
+	uint32_t unHash = PropertySlotHash( prop );
+	for ( uint32_t i = 0; i < k_unSlotsPerDevice; i++ )
+	{
+		Slot_t &slot = device.rSlots[ ( unHash + i ) & ( k_unSlotsPerDevice - 1 ) ];
+		uint32_t unProperty = slot.unProperty.load( std::memory_order_relaxed );
+		if ( unProperty == (uint32_t)prop )
+		{
+			pTarget = &slot;
+			break;
+		}
+
+		bool bReusable = unProperty == Prop_Invalid || slot.unGeneration.load( std::memory_order_relaxed ) != unGeneration;
+		if ( bReusable && !pTarget )
+			pTarget = &slot;
+		if ( unProperty == Prop_Invalid )
+			break;
+	}
+
+	if ( !pTarget )
+		return;
+
+	uint32_t rTemp[ k_unSlotDataWords ];
+	memcpy( rTemp, pValue, unSize );
+
+	uint32_t unSequence = pTarget->unSequence.load( std::memory_order_relaxed );
+	pTarget->unSequence.store( unSequence + 1, std::memory_order_relaxed );
+	std::atomic_thread_fence( std::memory_order_release );
+
+	pTarget->unProperty.store( (uint32_t)prop, std::memory_order_relaxed );
+	pTarget->unGeneration.store( unGeneration, std::memory_order_relaxed );
+	pTarget->unTypeAndError.store( ( (uint32_t)eType << 16 ) | (uint32_t)eError, std::memory_order_relaxed );
+	pTarget->unSize.store( unSize, std::memory_order_relaxed );
+	for ( uint32_t w = 0; w < ( unSize + 3 ) / 4; w++ )
+		pTarget->rData[w].store( rTemp[w], std::memory_order_relaxed );
+
+	pTarget->unSequence.store( unSequence + 2, std::memory_order_release );
+}
+
+
+template< typename T, typename FnQuery >
+T CTrackedPropertyCache::GetScalar( TrackedDeviceIndex_t unDeviceIndex, ETrackedDeviceProperty prop, EPropertyType eType, ETrackedPropertyError *pError, FnQuery fnQuery )
+{
+	if ( unDeviceIndex >= k_unMaxTrackedDeviceCount )
+		return fnQuery( pError );
+
+	uint32_t unGeneration = m_rDevices[ unDeviceIndex ].unGeneration.load( std::memory_order_acquire );
+
+	T value;
+	uint32_t unSize;
+	ETrackedPropertyError eError;
+	if ( !Lookup( unDeviceIndex, prop, eType, unGeneration, &value, sizeof( value ), &unSize, &eError ) )
+	{
+		value = fnQuery( &eError );
+		Store( unDeviceIndex, prop, eType, unGeneration, &value, sizeof( value ), eError );
+	}
+
+	if ( pError )
+		*pError = eError;
+	return value;
+}
+
+
+bool CTrackedPropertyCache::GetBool( IVRSystem *pSystem, TrackedDeviceIndex_t unDeviceIndex, ETrackedDeviceProperty prop, ETrackedPropertyError *pError )
+{
+	return GetScalar< bool >( unDeviceIndex, prop, PropertyType_Bool, pError,
+		[&]( ETrackedPropertyError *pErr ) { return pSystem->GetBoolTrackedDeviceProperty( unDeviceIndex, prop, pErr ); } );
+}
+
+
+float CTrackedPropertyCache::GetFloat( IVRSystem *pSystem, TrackedDeviceIndex_t unDeviceIndex, ETrackedDeviceProperty prop, ETrackedPropertyError *pError )
+{
+	return GetScalar< float >( unDeviceIndex, prop, PropertyType_Float, pError,
+		[&]( ETrackedPropertyError *pErr ) { return pSystem->GetFloatTrackedDeviceProperty( unDeviceIndex, prop, pErr ); } );
+}
+
+
+int32_t CTrackedPropertyCache::GetInt32( IVRSystem *pSystem, TrackedDeviceIndex_t unDeviceIndex, ETrackedDeviceProperty prop, ETrackedPropertyError *pError )
+{
+	return GetScalar< int32_t >( unDeviceIndex, prop, PropertyType_Int32, pError,
+		[&]( ETrackedPropertyError *pErr ) { return pSystem->GetInt32TrackedDeviceProperty( unDeviceIndex, prop, pErr ); } );
+}
+
+
+uint64_t CTrackedPropertyCache::GetUint64( IVRSystem *pSystem, TrackedDeviceIndex_t unDeviceIndex, ETrackedDeviceProperty prop, ETrackedPropertyError *pError )
+{
+	return GetScalar< uint64_t >( unDeviceIndex, prop, PropertyType_Uint64, pError,
+		[&]( ETrackedPropertyError *pErr ) { return pSystem->GetUint64TrackedDeviceProperty( unDeviceIndex, prop, pErr ); } );
+}
+
+
+HmdMatrix34_t CTrackedPropertyCache::GetMatrix34( IVRSystem *pSystem, TrackedDeviceIndex_t unDeviceIndex, ETrackedDeviceProperty prop, ETrackedPropertyError *pError )
+{
+	return GetScalar< HmdMatrix34_t >( unDeviceIndex, prop, PropertyType_Matrix34, pError,
+		[&]( ETrackedPropertyError *pErr ) { return pSystem->GetMatrix34TrackedDeviceProperty( unDeviceIndex, prop, pErr ); } );
+}
+
+
+//-----------------------------------------------------------------------------
+// Purpose: Serves strings that fit in a slot from the cache and passes longer
+//          ones straight through to the runtime
+//-----------------------------------------------------------------------------
+uint32_t CTrackedPropertyCache::GetString( IVRSystem *pSystem, TrackedDeviceIndex_t unDeviceIndex, ETrackedDeviceProperty prop, char *pchValue, uint32_t unBufferSize, ETrackedPropertyError *pError )
+{
+	if ( unDeviceIndex >= k_unMaxTrackedDeviceCount )
+		return pSystem->GetStringTrackedDeviceProperty( unDeviceIndex, prop, pchValue, unBufferSize, pError );
+
+	uint32_t unGeneration = m_rDevices[ unDeviceIndex ].unGeneration.load( std::memory_order_acquire );
+
+	char rchValue[ k_unMaxCachedStringSize ];
+	uint32_t unSize;
+	ETrackedPropertyError eError;
+	if ( !Lookup( unDeviceIndex, prop, PropertyType_String, unGeneration, rchValue, sizeof( rchValue ), &unSize, &eError ) )
+	{
+		unSize = pSystem->GetStringTrackedDeviceProperty( unDeviceIndex, prop, rchValue, sizeof( rchValue ), &eError );
+		if ( eError == TrackedProp_BufferTooSmall )
+			return pSystem->GetStringTrackedDeviceProperty( unDeviceIndex, prop, pchValue, unBufferSize, pError );
+
+		Store( unDeviceIndex, prop, PropertyType_String, unGeneration, rchValue, unSize, eError );
+	}
+
+	if ( eError == TrackedProp_Success && unSize > 0 )
+	{
+		if ( !pchValue || unBufferSize < unSize )
+			eError = TrackedProp_BufferTooSmall;
+		else
+			memcpy( pchValue, rchValue, unSize );
+	}
+
+	if ( pError )
+		*pError = eError;
+	return unSize;
+}
+
+
+//-----------------------------------------------------------------------------
+// Purpose: Reads every request in order, placing each value at the next offset
+//          aligned for its type. Values that don't fit still advance the
+//          offset so the return value is the size the whole batch needs.
+//-----------------------------------------------------------------------------
+uint32_t CTrackedPropertyCache::GetProperties( IVRSystem *pSystem, const TrackedPropertyRequest_t *pRequests, uint32_t unRequestCount,
+	TrackedPropertyResult_t *pResults, void *pValueBuffer, uint32_t unValueBufferSize )
+{
+	uint8_t *pBuffer = static_cast< uint8_t * >( pValueBuffer );
+	if ( !pBuffer )
+		unValueBufferSize = 0;
+
+	uint32_t unOffset = 0;
+	for ( uint32_t i = 0; i < unRequestCount; i++ )
+	{
+		const TrackedPropertyRequest_t &request = pRequests[i];
+		TrackedPropertyResult_t &result = pResults[i];
+
+		union
+		{
+			bool bValue;
+			float flValue;
+			int32_t nValue;
+			uint64_t ulValue;
+			HmdMatrix34_t matValue;
+		} value;
+		uint32_t unSize;
+		uint32_t unAlign;
+
+		switch ( request.unTag )
+		{
+		case k_unBoolPropertyTag:
+			value.bValue = GetBool( pSystem, request.unDeviceIndex, request.prop, &result.eError );
+			unSize = unAlign = sizeof( bool );
+			break;
+		case k_unFloatPropertyTag:
+			value.flValue = GetFloat( pSystem, request.unDeviceIndex, request.prop, &result.eError );
+			unSize = unAlign = sizeof( float );
+			break;
+		case k_unInt32PropertyTag:
+			value.nValue = GetInt32( pSystem, request.unDeviceIndex, request.prop, &result.eError );
+			unSize = unAlign = sizeof( int32_t );
+			break;
+		case k_unUint64PropertyTag:
+			value.ulValue = GetUint64( pSystem, request.unDeviceIndex, request.prop, &result.eError );
+			unSize = unAlign = sizeof( uint64_t );
+			break;
+		case k_unHmdMatrix34PropertyTag:
+			value.matValue = GetMatrix34( pSystem, request.unDeviceIndex, request.prop, &result.eError );
+			unSize = sizeof( HmdMatrix34_t );
+			unAlign = sizeof( float );
+			break;
+
+		case k_unStringPropertyTag:
+		{
+			uint32_t unRemaining = unOffset < unValueBufferSize ? unValueBufferSize - unOffset : 0;
+			unSize = GetString( pSystem, request.unDeviceIndex, request.prop, unRemaining ? (char *)pBuffer + unOffset : NULL, unRemaining, &result.eError );
+			if ( result.eError == TrackedProp_Success || result.eError == TrackedProp_BufferTooSmall )
+			{
+				result.unOffset = unOffset;
+				result.unSize = unSize;
+				unOffset += unSize;
+			}
+			else
+			{
+				result.unOffset = 0;
+				result.unSize = 0;
+			}
+			continue;
+		}
+
+		default:
+			result.eError = TrackedProp_WrongDataType;
+			result.unOffset = 0;
+			result.unSize = 0;
+			continue;
+		}
+
+		if ( result.eError != TrackedProp_Success )
+		{
+			result.unOffset = 0;
+			result.unSize = 0;
+			continue;
+		}
+
+		unOffset = ( unOffset + unAlign - 1 ) & ~( unAlign - 1 );
+		result.unOffset = unOffset;
+		result.unSize = unSize;
+		if ( unOffset + unSize <= unValueBufferSize )
+			memcpy( pBuffer + unOffset, &value, unSize );
+		else
+			result.eError = TrackedProp_BufferTooSmall;
+		unOffset += unSize;
+	}
+
+	return unOffset;
+}
+
+
+void CTrackedPropertyCache::InvalidateDevice( TrackedDeviceIndex_t unDeviceIndex )
+{
+	if ( unDeviceIndex < k_unMaxTrackedDeviceCount )
+		m_rDevices[ unDeviceIndex ].unGeneration.fetch_add( 1, std::memory_order_release );
+}
+
+
+void CTrackedPropertyCache::InvalidateAll()
+{
+	for ( uint32_t unDevice = 0; unDevice < k_unMaxTrackedDeviceCount; unDevice++ )
+		InvalidateDevice( unDevice );
+}
+
+
+//-----------------------------------------------------------------------------
+// Purpose: Device lifecycle events invalidate just the device they are about.
+//          Events without a specific device drop everything.
+//-----------------------------------------------------------------------------
+bool CTrackedPropertyCache::ProcessEvent( const VREvent_t &event )
+{
+	switch ( event.eventType )
+	{
+	case VREvent_TrackedDeviceActivated:
+	case VREvent_TrackedDeviceDeactivated:
+	case VREvent_TrackedDeviceUpdated:
+	case VREvent_TrackedDeviceRoleChanged:
+		if ( event.trackedDeviceIndex < k_unMaxTrackedDeviceCount )
+			InvalidateDevice( event.trackedDeviceIndex );
+		else
+			InvalidateAll();
+		return true;
+
+	default:
+		return false;
+	}
+}
@@ -13,6 +13,19 @@ bool StringHasPrefixCaseSensitive( const std::string & sString, const std::strin
 bool StringHasSuffix( const std::string &sString, const std::string &sSuffix );
 bool StringHasSuffixCaseSensitive( const std::string &sString, const std::string &sSuffix );
 
+/** Case-insensitive prefix and suffix tests on counted strings. Only ASCII letters are
+* folded, so these never allocate and do not depend on the current locale. */
+bool StringHasPrefix( const char *pchString, size_t unStringLen, const char *pchPrefix, size_t unPrefixLen );
+bool StringHasSuffix( const char *pchString, size_t unStringLen, const char *pchSuffix, size_t unSuffixLen );
+
+/** Compares two counted strings ignoring ASCII case. Returns <0, 0 or >0 like stricmp. */
+int StringCompareCaseInsensitive( const char *pchA, size_t unALen, const char *pchB, size_t unBLen );
+int StringCompareCaseInsensitive( const std::string & sA, const std::string & sB );
+
+/** returns true if the two strings are equal ignoring ASCII case */
+bool StringEqualsCaseInsensitive( const char *pchA, size_t unALen, const char *pchB, size_t unBLen );
+bool StringEqualsCaseInsensitive( const std::string & sA, const std::string & sB );
+
 /** converts a UTF-16 string to a UTF-8 string */
 std::string UTF16to8(const wchar_t * in);
 
@@ -35,6 +48,12 @@ std::string StringToUpper( const std::string & sString );
 /** converts a string to lower case */
 std::string StringToLower( const std::string & sString );
 
+/** converts ASCII letters in a buffer or string to upper or lower case in place */
+void StringToUpperInPlace( char *pchBuffer, size_t unLen );
+void StringToLowerInPlace( char *pchBuffer, size_t unLen );
+void StringToUpperInPlace( std::string & sString );
+void StringToLowerInPlace( std::string & sString );
+
 // we stricmp (from WIN) but it isn't POSIX - OSX/LINUX have strcasecmp so just inline bridge to it
 #if defined( OSX ) || defined( LINUX )
 #include <strings.h>
@@ -99,25 +118,74 @@ std::string Uint64ToString( uint64_t ulValue );
 /** returns a uint64_t from a string */
 uint64_t StringToUint64( const std::string & sValue );
 
+/** Errors reported by the integer conversion helpers below */
+enum EStringConversionError
+{
+	StringConversionError_None				= 0,
+	StringConversionError_BufferTooSmall	= 1,	// formatting: the value does not fit in the buffer
+	StringConversionError_InvalidArgument	= 2,	// parsing: no digits at the start of the input
+	StringConversionError_OutOfRange		= 3,	// parsing: the value does not fit in the requested type
+};
+
+/** Result of formatting an integer into [pchFirst, pchLast). On success pchEnd points one past the
+* last character written, on failure it equals pchLast. The output is not null terminated. */
+struct ToCharsResult_t
+{
+	char *pchEnd;
+	EStringConversionError eError;
+};
+
+/** Result of parsing an integer from [pchFirst, pchLast). pchEnd points at the first character
+* that was not consumed. The output value is left untouched unless eError is StringConversionError_None. */
+struct FromCharsResult_t
+{
+	const char *pchEnd;
+	EStringConversionError eError;
+};
+
+/** Formats integers in decimal, or upper case hex without a prefix, like std::to_chars */
+ToCharsResult_t Int32ToChars( char *pchFirst, char *pchLast, int32_t nValue );
+ToCharsResult_t Uint32ToChars( char *pchFirst, char *pchLast, uint32_t unValue );
+ToCharsResult_t Int64ToChars( char *pchFirst, char *pchLast, int64_t nValue );
+ToCharsResult_t Uint64ToChars( char *pchFirst, char *pchLast, uint64_t ulValue );
+ToCharsResult_t Uint32ToHexChars( char *pchFirst, char *pchLast, uint32_t unValue );
+ToCharsResult_t Uint64ToHexChars( char *pchFirst, char *pchLast, uint64_t ulValue );
+
+/** Parses integers like std::from_chars: no leading whitespace or '+', and '-' only for the signed
+* versions. The hex versions accept an optional 0x/0X prefix. */
+FromCharsResult_t CharsToInt32( const char *pchFirst, const char *pchLast, int32_t *pnValue );
+FromCharsResult_t CharsToUint32( const char *pchFirst, const char *pchLast, uint32_t *punValue );
+FromCharsResult_t CharsToInt64( const char *pchFirst, const char *pchLast, int64_t *pnValue );
+FromCharsResult_t CharsToUint64( const char *pchFirst, const char *pchLast, uint64_t *pulValue );
+FromCharsResult_t HexCharsToUint32( const char *pchFirst, const char *pchLast, uint32_t *punValue );
+FromCharsResult_t HexCharsToUint64( const char *pchFirst, const char *pchLast, uint64_t *pulValue );
+
 //-----------------------------------------------------------------------------
 // Purpose: Encodes a string (or binary data) from URL encoding format, see rfc1738 section 2.2.  
 //          This version of the call isn't a strict RFC implementation, but uses + for space as is
 //          the standard in HTML form encoding, despite it not being part of the RFC.
 //
-//          Dest buffer should be at least as large as source buffer to guarantee room for decode.
+//          Returns the size of the buffer needed for the result, including the null terminator.
+//          Pass a NULL dest buffer to query the size. If the dest buffer is too short it is set
+//          to an empty string.
 //-----------------------------------------------------------------------------
-void V_URLEncode( char *pchDest, int nDestLen, const char *pchSource, int nSourceLen );
+size_t V_URLEncode( char *pchDest, int nDestLen, const char *pchSource, int nSourceLen );
 
 //-----------------------------------------------------------------------------
 // Purpose: Decodes a string (or binary data) from URL encoding format, see rfc1738 section 2.2.  
 //          This version of the call isn't a strict RFC implementation, but uses + for space as is
 //          the standard in HTML form encoding, despite it not being part of the RFC.
 //
-//          Dest buffer should be at least as large as source buffer to guarantee room for decode.
+//          Returns the number of decoded bytes. Pass a NULL dest buffer to query that size.
+//          Returns 0 if the dest buffer is too short for the decoded data.
 //			Dest buffer being the same as the source buffer (decode in-place) is explicitly allowed.
 //-----------------------------------------------------------------------------
 size_t V_URLDecode( char *pchDecodeDest, int nDecodeDestLen, const char *pchEncodedSource, int nEncodedSourceLen );
 
+/** std::string versions of V_URLEncode and V_URLDecode, each allocates its result once */
+std::string V_URLEncode( const std::string & sSource );
+std::string V_URLDecode( const std::string & sEncoded );
+
 //-----------------------------------------------------------------------------
 // Purpose: strip extension from a path
 //-----------------------------------------------------------------------------
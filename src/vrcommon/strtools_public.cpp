@@ -3,13 +3,88 @@
 #include <string.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <stddef.h>
+
+#if defined( __SSE2__ ) || defined( _M_X64 ) || ( defined( _M_IX86_FP ) && _M_IX86_FP >= 2 )
+#include <emmintrin.h>
+#define STRTOOLS_SSE2 1
+#endif
+
+#if defined( _MSC_VER )
+#include <intrin.h>
+#endif
+
+//-----------------------------------------------------------------------------
+// Purpose: ASCII-only case folding helpers. Bytes outside A-Z/a-z pass through
+//          untouched, which also keeps UTF-8 sequences intact.
+//-----------------------------------------------------------------------------
+static inline char AsciiToLower( char c )
+{
+	return ( (uint8_t)( c - 'A' ) < 26 ) ? (char)( c | 0x20 ) : c;
+}
+
+static inline char AsciiToUpper( char c )
+{
+	return ( (uint8_t)( c - 'a' ) < 26 ) ? (char)( c & ~0x20 ) : c;
+}
+
+#if defined( STRTOOLS_SSE2 )
+// Signed byte compares leave 0x80-0xFF out of both ranges, so only ASCII letters are touched.
+static inline __m128i AsciiToLower16( __m128i v )
+{
+	__m128i mask = _mm_and_si128( _mm_cmpgt_epi8( v, _mm_set1_epi8( 'A' - 1 ) ), _mm_cmplt_epi8( v, _mm_set1_epi8( 'Z' + 1 ) ) );
+	return _mm_or_si128( v, _mm_and_si128( mask, _mm_set1_epi8( 0x20 ) ) );
+}
+
+static inline __m128i AsciiToUpper16( __m128i v )
+{
+	__m128i mask = _mm_and_si128( _mm_cmpgt_epi8( v, _mm_set1_epi8( 'a' - 1 ) ), _mm_cmplt_epi8( v, _mm_set1_epi8( 'z' + 1 ) ) );
+	return _mm_andnot_si128( _mm_and_si128( mask, _mm_set1_epi8( 0x20 ) ), v );
+}
+
+static inline uint32_t FindFirstSetBit( uint32_t unMask )
+{
+#if defined( _MSC_VER )
+	unsigned long ulIndex;
+	_BitScanForward( &ulIndex, unMask );
+	return (uint32_t)ulIndex;
+#else
+	return (uint32_t)__builtin_ctz( unMask );
+#endif
+}
+#endif
+
+//-----------------------------------------------------------------------------
+// Purpose: Returns the index of the first byte where the two buffers differ
+//          ignoring ASCII case, or unLen if they are equal.
+//-----------------------------------------------------------------------------
+static size_t FindFirstCaseInsensitiveMismatch( const char *pchA, const char *pchB, size_t unLen )
+{
+	size_t i = 0;
+#if defined( STRTOOLS_SSE2 )
+	for ( ; i + 16 <= unLen; i += 16 )
+	{
+		__m128i a = AsciiToLower16( _mm_loadu_si128( (const __m128i *)( pchA + i ) ) );
+		__m128i b = AsciiToLower16( _mm_loadu_si128( (const __m128i *)( pchB + i ) ) );
+		uint32_t unEqualMask = (uint32_t)_mm_movemask_epi8( _mm_cmpeq_epi8( a, b ) );
+		if ( unEqualMask != 0xFFFF )
+			return i + FindFirstSetBit( ~unEqualMask & 0xFFFF );
+	}
+#endif
+	for ( ; i < unLen; ++i )
+	{
+		if ( AsciiToLower( pchA[i] ) != AsciiToLower( pchB[i] ) )
+			return i;
+	}
+	return unLen;
+}
 
 //-----------------------------------------------------------------------------
 // Purpose:
 //-----------------------------------------------------------------------------
 bool StringHasPrefix( const std::string & sString, const std::string & sPrefix )
 {
-	return 0 == strnicmp( sString.c_str(), sPrefix.c_str(), sPrefix.length() );
+	return StringHasPrefix( sString.c_str(), sString.length(), sPrefix.c_str(), sPrefix.length() );
 }
 
 bool StringHasPrefixCaseSensitive( const std::string & sString, const std::string & sPrefix )
@@ -19,6 +94,11 @@ bool StringHasPrefixCaseSensitive( const std::string & sString, const std::strin
 
 
 bool StringHasSuffix( const std::string &sString, const std::string &sSuffix )
+{
+	return StringHasSuffix( sString.c_str(), sString.length(), sSuffix.c_str(), sSuffix.length() );
+}
+
+bool StringHasSuffixCaseSensitive( const std::string &sString, const std::string &sSuffix )
 {
 	size_t cStrLen = sString.length();
 	size_t cSuffixLen = sSuffix.length();
@@ -28,20 +108,50 @@ bool StringHasSuffix( const std::string &sString, const std::string &sSuffix )
 
 	std::string sStringSuffix = sString.substr( cStrLen - cSuffixLen, cSuffixLen );
 
-	return 0 == stricmp( sStringSuffix.c_str(), sSuffix.c_str() );
+	return 0 == strncmp( sStringSuffix.c_str(), sSuffix.c_str(),cSuffixLen );
 }
 
-bool StringHasSuffixCaseSensitive( const std::string &sString, const std::string &sSuffix )
+bool StringHasPrefix( const char *pchString, size_t unStringLen, const char *pchPrefix, size_t unPrefixLen )
 {
-	size_t cStrLen = sString.length();
-	size_t cSuffixLen = sSuffix.length();
+	if ( unPrefixLen > unStringLen )
+		return false;
 
-	if ( cSuffixLen > cStrLen )
+	return FindFirstCaseInsensitiveMismatch( pchString, pchPrefix, unPrefixLen ) == unPrefixLen;
+}
+
+bool StringHasSuffix( const char *pchString, size_t unStringLen, const char *pchSuffix, size_t unSuffixLen )
+{
+	if ( unSuffixLen > unStringLen )
 		return false;
 
-	std::string sStringSuffix = sString.substr( cStrLen - cSuffixLen, cSuffixLen );
+	return FindFirstCaseInsensitiveMismatch( pchString + unStringLen - unSuffixLen, pchSuffix, unSuffixLen ) == unSuffixLen;
+}
 
-	return 0 == strncmp( sStringSuffix.c_str(), sSuffix.c_str(),cSuffixLen );
+int StringCompareCaseInsensitive( const char *pchA, size_t unALen, const char *pchB, size_t unBLen )
+{
+	size_t unCommonLen = unALen < unBLen ? unALen : unBLen;
+	size_t unMismatch = FindFirstCaseInsensitiveMismatch( pchA, pchB, unCommonLen );
+	if ( unMismatch < unCommonLen )
+		return (int)(uint8_t)AsciiToLower( pchA[ unMismatch ] ) - (int)(uint8_t)AsciiToLower( pchB[ unMismatch ] );
+
+	if ( unALen == unBLen )
+		return 0;
+	return unALen < unBLen ? -1 : 1;
+}
+
+int StringCompareCaseInsensitive( const std::string & sA, const std::string & sB )
+{
+	return StringCompareCaseInsensitive( sA.c_str(), sA.length(), sB.c_str(), sB.length() );
+}
+
+bool StringEqualsCaseInsensitive( const char *pchA, size_t unALen, const char *pchB, size_t unBLen )
+{
+	return unALen == unBLen && FindFirstCaseInsensitiveMismatch( pchA, pchB, unALen ) == unALen;
+}
+
+bool StringEqualsCaseInsensitive( const std::string & sA, const std::string & sB )
+{
+	return StringEqualsCaseInsensitive( sA.c_str(), sA.length(), sB.c_str(), sB.length() );
 }
 
 //-----------------------------------------------------------------------------
@@ -152,13 +262,8 @@ void strcpy_safe( char *pchBuffer, size_t unBufferSizeBytes, const char *pchSour
 // --------------------------------------------------------------------
 std::string StringToUpper( const std::string & sString )
 {
-	std::string sOut;
-	sOut.reserve( sString.size() + 1 );
-	for( std::string::const_iterator i = sString.begin(); i != sString.end(); i++ )
-	{
-		sOut.push_back( (char)toupper( *i ) );
-	}
-
+	std::string sOut( sString );
+	StringToUpperInPlace( sOut );
 	return sOut;
 }
 
@@ -168,14 +273,61 @@ std::string StringToUpper( const std::string & sString )
 // --------------------------------------------------------------------
 std::string StringToLower( const std::string & sString )
 {
-	std::string sOut;
-	sOut.reserve( sString.size() + 1 );
-	for( std::string::const_iterator i = sString.begin(); i != sString.end(); i++ )
+	std::string sOut( sString );
+	StringToLowerInPlace( sOut );
+	return sOut;
+}
+
+
+// --------------------------------------------------------------------
+// Purpose: converts ASCII letters to upper case in place
+// --------------------------------------------------------------------
+void StringToUpperInPlace( char *pchBuffer, size_t unLen )
+{
+	size_t i = 0;
+#if defined( STRTOOLS_SSE2 )
+	for ( ; i + 16 <= unLen; i += 16 )
 	{
-		sOut.push_back( (char)tolower( *i ) );
+		__m128i v = _mm_loadu_si128( (const __m128i *)( pchBuffer + i ) );
+		_mm_storeu_si128( (__m128i *)( pchBuffer + i ), AsciiToUpper16( v ) );
 	}
+#endif
+	for ( ; i < unLen; ++i )
+	{
+		pchBuffer[i] = AsciiToUpper( pchBuffer[i] );
+	}
+}
 
-	return sOut;
+
+// --------------------------------------------------------------------
+// Purpose: converts ASCII letters to lower case in place
+// --------------------------------------------------------------------
+void StringToLowerInPlace( char *pchBuffer, size_t unLen )
+{
+	size_t i = 0;
+#if defined( STRTOOLS_SSE2 )
+	for ( ; i + 16 <= unLen; i += 16 )
+	{
+		__m128i v = _mm_loadu_si128( (const __m128i *)( pchBuffer + i ) );
+		_mm_storeu_si128( (__m128i *)( pchBuffer + i ), AsciiToLower16( v ) );
+	}
+#endif
+	for ( ; i < unLen; ++i )
+	{
+		pchBuffer[i] = AsciiToLower( pchBuffer[i] );
+	}
+}
+
+void StringToUpperInPlace( std::string & sString )
+{
+	if ( !sString.empty() )
+		StringToUpperInPlace( &sString[0], sString.length() );
+}
+
+void StringToLowerInPlace( std::string & sString )
+{
+	if ( !sString.empty() )
+		StringToLowerInPlace( &sString[0], sString.length() );
 }
 
 
@@ -207,20 +359,28 @@ void BufferToStdString( std::string & sDest, const char *pchBuffer, uint32_t unB
 /** Returns a std::string from a uint64_t */
 std::string Uint64ToString( uint64_t ulValue )
 {
-	char buf[ 22 ];
-#if defined( _WIN32 )
-	sprintf_s( buf, "%llu", ulValue );
-#else
-    snprintf( buf, sizeof( buf ), "%llu", (long long unsigned int ) ulValue );
-#endif
-	return buf;
+	char buf[ 20 ];
+	ToCharsResult_t result = Uint64ToChars( buf, buf + sizeof( buf ), ulValue );
+	return std::string( buf, result.pchEnd );
 }
 
 
 /** returns a uint64_t from a string */
 uint64_t StringToUint64( const std::string & sValue )
 {
-	return strtoull( sValue.c_str(), NULL, 0 );
+	// plain decimal is by far the common case, anything else (whitespace, signs, octal or hex
+	// prefixes, trailing garbage) keeps the strtoull behavior
+	const char *pchFirst = sValue.c_str();
+	const char *pchLast = pchFirst + sValue.length();
+	if ( pchFirst != pchLast && ( *pchFirst != '0' || sValue.length() == 1 ) )
+	{
+		uint64_t ulValue;
+		FromCharsResult_t result = CharsToUint64( pchFirst, pchLast, &ulValue );
+		if ( result.eError == StringConversionError_None && result.pchEnd == pchLast )
+			return ulValue;
+	}
+
+	return strtoull( pchFirst, NULL, 0 );
 }
 
 //-----------------------------------------------------------------------------
@@ -249,70 +409,403 @@ int iHexCharToInt( char cValue )
 	return -1;
 }
 
+//-----------------------------------------------------------------------------
+// Purpose: Integer formatting. Decimal digits are produced two at a time from
+//          a pair table, back to front once the digit count is known.
+//-----------------------------------------------------------------------------
+static const char k_rchDigitPairs[] =
+	"00010203040506070809"
+	"10111213141516171819"
+	"20212223242526272829"
+	"30313233343536373839"
+	"40414243444546474849"
+	"50515253545556575859"
+	"60616263646566676869"
+	"70717273747576777879"
+	"80818283848586878889"
+	"90919293949596979899";
+
+static uint32_t CountDecimalDigits( uint64_t ulValue )
+{
+	uint32_t unDigits = 1;
+	for ( ;; )
+	{
+		if ( ulValue < 10 ) return unDigits;
+		if ( ulValue < 100 ) return unDigits + 1;
+		if ( ulValue < 1000 ) return unDigits + 2;
+		if ( ulValue < 10000 ) return unDigits + 3;
+		ulValue /= 10000u;
+		unDigits += 4;
+	}
+}
+
+static void WriteDecimalDigits( char *pchEnd, uint64_t ulValue )
+{
+	while ( ulValue >= 100 )
+	{
+		uint32_t unPair = (uint32_t)( ulValue % 100 ) * 2;
+		ulValue /= 100;
+		*--pchEnd = k_rchDigitPairs[ unPair + 1 ];
+		*--pchEnd = k_rchDigitPairs[ unPair ];
+	}
+
+	if ( ulValue >= 10 )
+	{
+		uint32_t unPair = (uint32_t)ulValue * 2;
+		*--pchEnd = k_rchDigitPairs[ unPair + 1 ];
+		*--pchEnd = k_rchDigitPairs[ unPair ];
+	}
+	else
+	{
+		*--pchEnd = (char)( '0' + ulValue );
+	}
+}
+
+static ToCharsResult_t FormatDecimal( char *pchFirst, char *pchLast, uint64_t ulMagnitude, bool bNegative )
+{
+	ToCharsResult_t result;
+	uint32_t unLen = CountDecimalDigits( ulMagnitude ) + ( bNegative ? 1 : 0 );
+	if ( pchLast - pchFirst < (ptrdiff_t)unLen )
+	{
+		result.pchEnd = pchLast;
+		result.eError = StringConversionError_BufferTooSmall;
+		return result;
+	}
+
+	if ( bNegative )
+		*pchFirst = '-';
+	WriteDecimalDigits( pchFirst + unLen, ulMagnitude );
+
+	result.pchEnd = pchFirst + unLen;
+	result.eError = StringConversionError_None;
+	return result;
+}
+
+static ToCharsResult_t FormatHex( char *pchFirst, char *pchLast, uint64_t ulValue )
+{
+	ToCharsResult_t result;
+	uint32_t unLen = 1;
+	while ( unLen < 16 && ( ulValue >> ( unLen * 4 ) ) != 0 )
+		++unLen;
+
+	if ( pchLast - pchFirst < (ptrdiff_t)unLen )
+	{
+		result.pchEnd = pchLast;
+		result.eError = StringConversionError_BufferTooSmall;
+		return result;
+	}
+
+	char *pchEnd = pchFirst + unLen;
+	for ( char *pch = pchEnd; pch != pchFirst; ulValue >>= 4 )
+	{
+		*--pch = "0123456789ABCDEF"[ ulValue & 15 ];
+	}
+
+	result.pchEnd = pchEnd;
+	result.eError = StringConversionError_None;
+	return result;
+}
+
+ToCharsResult_t Int32ToChars( char *pchFirst, char *pchLast, int32_t nValue )
+{
+	return Int64ToChars( pchFirst, pchLast, nValue );
+}
+
+ToCharsResult_t Uint32ToChars( char *pchFirst, char *pchLast, uint32_t unValue )
+{
+	return FormatDecimal( pchFirst, pchLast, unValue, false );
+}
+
+ToCharsResult_t Int64ToChars( char *pchFirst, char *pchLast, int64_t nValue )
+{
+	// negate in unsigned space so INT64_MIN doesn't overflow
+	uint64_t ulMagnitude = nValue < 0 ? 0 - (uint64_t)nValue : (uint64_t)nValue;
+	return FormatDecimal( pchFirst, pchLast, ulMagnitude, nValue < 0 );
+}
+
+ToCharsResult_t Uint64ToChars( char *pchFirst, char *pchLast, uint64_t ulValue )
+{
+	return FormatDecimal( pchFirst, pchLast, ulValue, false );
+}
+
+ToCharsResult_t Uint32ToHexChars( char *pchFirst, char *pchLast, uint32_t unValue )
+{
+	return FormatHex( pchFirst, pchLast, unValue );
+}
+
+ToCharsResult_t Uint64ToHexChars( char *pchFirst, char *pchLast, uint64_t ulValue )
+{
+	return FormatHex( pchFirst, pchLast, ulValue );
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: Integer parsing. Digits are always consumed to the end of the run so
+//          out of range values report where the number ended.
+//-----------------------------------------------------------------------------
+static FromCharsResult_t ParseDecimal( const char *pchFirst, const char *pchLast, uint64_t ulMax, uint64_t *pulValue )
+{
+	FromCharsResult_t result;
+	const uint64_t ulMaxDiv10 = ulMax / 10;
+	const uint32_t unMaxMod10 = (uint32_t)( ulMax % 10 );
+
+	uint64_t ulValue = 0;
+	bool bOverflow = false;
+	const char *pch = pchFirst;
+	for ( ; pch != pchLast; ++pch )
+	{
+		uint32_t unDigit = (uint32_t)( *pch - '0' );
+		if ( unDigit > 9 )
+			break;
+
+		if ( ulValue > ulMaxDiv10 || ( ulValue == ulMaxDiv10 && unDigit > unMaxMod10 ) )
+			bOverflow = true;
+		ulValue = ulValue * 10 + unDigit;
+	}
+
+	if ( pch == pchFirst )
+	{
+		result.pchEnd = pchFirst;
+		result.eError = StringConversionError_InvalidArgument;
+		return result;
+	}
+
+	result.pchEnd = pch;
+	result.eError = bOverflow ? StringConversionError_OutOfRange : StringConversionError_None;
+	if ( !bOverflow )
+		*pulValue = ulValue;
+	return result;
+}
+
+static FromCharsResult_t ParseHex( const char *pchFirst, const char *pchLast, uint32_t unMaxDigits, uint64_t *pulValue )
+{
+	FromCharsResult_t result;
+	const char *pchDigits = pchFirst;
+	if ( pchLast - pchFirst > 2 && pchFirst[0] == '0' && ( pchFirst[1] | 0x20 ) == 'x' && iHexCharToInt( pchFirst[2] ) != -1 )
+		pchDigits += 2;
+
+	uint64_t ulValue = 0;
+	uint32_t unSignificantDigits = 0;
+	const char *pch = pchDigits;
+	for ( ; pch != pchLast; ++pch )
+	{
+		int nDigit = iHexCharToInt( *pch );
+		if ( nDigit < 0 )
+			break;
+
+		if ( unSignificantDigits || nDigit )
+			++unSignificantDigits;
+		ulValue = ( ulValue << 4 ) | (uint32_t)nDigit;
+	}
+
+	if ( pch == pchDigits )
+	{
+		result.pchEnd = pchFirst;
+		result.eError = StringConversionError_InvalidArgument;
+		return result;
+	}
+
+	result.pchEnd = pch;
+	if ( unSignificantDigits > unMaxDigits )
+	{
+		result.eError = StringConversionError_OutOfRange;
+		return result;
+	}
+
+	result.eError = StringConversionError_None;
+	*pulValue = ulValue;
+	return result;
+}
+
+static FromCharsResult_t ParseSigned( const char *pchFirst, const char *pchLast, uint64_t ulMaxPositive, int64_t *pnValue )
+{
+	bool bNegative = pchFirst != pchLast && *pchFirst == '-';
+	uint64_t ulMagnitude;
+	FromCharsResult_t result = ParseDecimal( pchFirst + ( bNegative ? 1 : 0 ), pchLast, ulMaxPositive + ( bNegative ? 1 : 0 ), &ulMagnitude );
+	if ( result.eError == StringConversionError_InvalidArgument )
+	{
+		result.pchEnd = pchFirst;
+	}
+	else if ( result.eError == StringConversionError_None )
+	{
+		*pnValue = bNegative ? (int64_t)( 0 - ulMagnitude ) : (int64_t)ulMagnitude;
+	}
+	return result;
+}
+
+FromCharsResult_t CharsToInt32( const char *pchFirst, const char *pchLast, int32_t *pnValue )
+{
+	int64_t nValue;
+	FromCharsResult_t result = ParseSigned( pchFirst, pchLast, INT32_MAX, &nValue );
+	if ( result.eError == StringConversionError_None )
+		*pnValue = (int32_t)nValue;
+	return result;
+}
+
+FromCharsResult_t CharsToUint32( const char *pchFirst, const char *pchLast, uint32_t *punValue )
+{
+	uint64_t ulValue;
+	FromCharsResult_t result = ParseDecimal( pchFirst, pchLast, UINT32_MAX, &ulValue );
+	if ( result.eError == StringConversionError_None )
+		*punValue = (uint32_t)ulValue;
+	return result;
+}
+
+FromCharsResult_t CharsToInt64( const char *pchFirst, const char *pchLast, int64_t *pnValue )
+{
+	return ParseSigned( pchFirst, pchLast, INT64_MAX, pnValue );
+}
+
+FromCharsResult_t CharsToUint64( const char *pchFirst, const char *pchLast, uint64_t *pulValue )
+{
+	return ParseDecimal( pchFirst, pchLast, UINT64_MAX, pulValue );
+}
+
+FromCharsResult_t HexCharsToUint32( const char *pchFirst, const char *pchLast, uint32_t *punValue )
+{
+	uint64_t ulValue;
+	FromCharsResult_t result = ParseHex( pchFirst, pchLast, 8, &ulValue );
+	if ( result.eError == StringConversionError_None )
+		*punValue = (uint32_t)ulValue;
+	return result;
+}
+
+FromCharsResult_t HexCharsToUint64( const char *pchFirst, const char *pchLast, uint64_t *pulValue )
+{
+	return ParseHex( pchFirst, pchLast, 16, pulValue );
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: Returns true for the characters that pass through URL encoding unescaped.
+//          We allow only a-z, A-Z, 0-9, period, underscore, and hyphen to pass through unescaped.
+//          These are the characters allowed by both the original RFC 1738 and the latest RFC 3986.
+//          Current specs also allow '~', but that is forbidden under original RFC 1738.
+//-----------------------------------------------------------------------------
+static inline bool BIsURLSafeChar( char c )
+{
+	return ( (uint8_t)( ( c | 0x20 ) - 'a' ) < 26 ) || ( (uint8_t)( c - '0' ) < 10 ) || c == '-' || c == '_' || c == '.';
+}
+
+#if defined( STRTOOLS_SSE2 )
+//-----------------------------------------------------------------------------
+// Purpose: Returns a 16 bit mask with a bit set for every URL safe byte in the block
+//-----------------------------------------------------------------------------
+static inline uint32_t URLSafeMask16( __m128i v )
+{
+	// fold to lower case so a single range check covers both alphabets; bytes >= 0x80
+	// are negative as signed chars and so fall outside every range
+	__m128i vLower = _mm_or_si128( v, _mm_set1_epi8( 0x20 ) );
+	__m128i vAlpha = _mm_and_si128( _mm_cmpgt_epi8( vLower, _mm_set1_epi8( 'a' - 1 ) ), _mm_cmplt_epi8( vLower, _mm_set1_epi8( 'z' + 1 ) ) );
+	__m128i vDigit = _mm_and_si128( _mm_cmpgt_epi8( v, _mm_set1_epi8( '0' - 1 ) ), _mm_cmplt_epi8( v, _mm_set1_epi8( '9' + 1 ) ) );
+	__m128i vPunct = _mm_or_si128( _mm_or_si128( _mm_cmpeq_epi8( v, _mm_set1_epi8( '-' ) ), _mm_cmpeq_epi8( v, _mm_set1_epi8( '_' ) ) ),
+		_mm_cmpeq_epi8( v, _mm_set1_epi8( '.' ) ) );
+	return (uint32_t)_mm_movemask_epi8( _mm_or_si128( _mm_or_si128( vAlpha, vDigit ), vPunct ) );
+}
+#endif
+
+//-----------------------------------------------------------------------------
+// Purpose: Returns the number of leading bytes that can be copied through URL encoding unchanged
+//-----------------------------------------------------------------------------
+static size_t URLSafeRunLength( const char *pchSource, size_t unLen )
+{
+	size_t i = 0;
+#if defined( STRTOOLS_SSE2 )
+	for ( ; i + 16 <= unLen; i += 16 )
+	{
+		uint32_t unSafeMask = URLSafeMask16( _mm_loadu_si128( (const __m128i *)( pchSource + i ) ) );
+		if ( unSafeMask != 0xFFFF )
+			return i + FindFirstSetBit( ~unSafeMask & 0xFFFF );
+	}
+#endif
+	while ( i < unLen && BIsURLSafeChar( pchSource[i] ) )
+		++i;
+	return i;
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: Returns the number of leading bytes that URL decoding copies through unchanged,
+//          which is everything up to the next '%' (or '+' in form encoding).
+//-----------------------------------------------------------------------------
+static size_t URLLiteralRunLength( const char *pchSource, size_t unLen, bool bUsePlusForSpace )
+{
+	size_t i = 0;
+#if defined( STRTOOLS_SSE2 )
+	__m128i vPercent = _mm_set1_epi8( '%' );
+	__m128i vPlus = _mm_set1_epi8( bUsePlusForSpace ? '+' : '%' );
+	for ( ; i + 16 <= unLen; i += 16 )
+	{
+		__m128i v = _mm_loadu_si128( (const __m128i *)( pchSource + i ) );
+		uint32_t unSpecialMask = (uint32_t)_mm_movemask_epi8( _mm_or_si128( _mm_cmpeq_epi8( v, vPercent ), _mm_cmpeq_epi8( v, vPlus ) ) );
+		if ( unSpecialMask != 0 )
+			return i + FindFirstSetBit( unSpecialMask );
+	}
+#endif
+	while ( i < unLen && pchSource[i] != '%' && !( bUsePlusForSpace && pchSource[i] == '+' ) )
+		++i;
+	return i;
+}
+
 //-----------------------------------------------------------------------------
 // Purpose: Internal implementation of encode, works in the strict RFC manner, or
 //          with spaces turned to + like HTML form encoding.
+//
+//			Returns the size of buffer needed for the encoded string, including the
+//			null terminator. If pchDest is NULL nothing is written; if the buffer
+//			is too short it is set to an empty string.
 //-----------------------------------------------------------------------------
-void V_URLEncodeInternal( char *pchDest, int nDestLen, const char *pchSource, int nSourceLen, bool bUsePlusForSpace )
+size_t V_URLEncodeInternal( char *pchDest, int nDestLen, const char *pchSource, int nSourceLen, bool bUsePlusForSpace )
 {
-	//AssertMsg( nDestLen > 3*nSourceLen, "Target buffer for V_URLEncode should be 3x source length, plus one for terminating null\n" );
-	
-	int iDestPos = 0;
-	for ( int i=0; i < nSourceLen; ++i )
+	size_t unSourceLen = nSourceLen > 0 ? (size_t)nSourceLen : 0;
+	size_t unDestLen = ( pchDest && nDestLen > 0 ) ? (size_t)nDestLen : 0;
+	bool bWrite = pchDest != NULL;
+
+	size_t unDestPos = 0;
+	size_t i = 0;
+	while ( i < unSourceLen )
 	{
-		// worst case we need 3 additional chars
-		if( (iDestPos+3) > nDestLen  )
+		size_t unRun = URLSafeRunLength( pchSource + i, unSourceLen - i );
+		if ( unRun )
 		{
-			pchDest[0] = '\0';
-//			AssertMsg( false, "Target buffer too short\n" );
-			return;
+			if ( bWrite && unDestPos + unRun < unDestLen )
+				memcpy( pchDest + unDestPos, pchSource + i, unRun );
+			i += unRun;
+			unDestPos += unRun;
+			continue;
 		}
 
-		// We allow only a-z, A-Z, 0-9, period, underscore, and hyphen to pass through unescaped.
-		// These are the characters allowed by both the original RFC 1738 and the latest RFC 3986.
-		// Current specs also allow '~', but that is forbidden under original RFC 1738.
-		if ( !( pchSource[i] >= 'a' && pchSource[i] <= 'z' ) && !( pchSource[i] >= 'A' && pchSource[i] <= 'Z' ) && !(pchSource[i] >= '0' && pchSource[i] <= '9' )
-			 && pchSource[i] != '-' && pchSource[i] != '_' && pchSource[i] != '.'	
-		)
+		uint8_t iValue = pchSource[i++];
+		if ( bUsePlusForSpace && iValue == ' ' )
 		{
-			if ( bUsePlusForSpace && pchSource[i] == ' ' )
-			{
-				pchDest[iDestPos++] = '+';
-			}
-			else
-			{
-				pchDest[iDestPos++] = '%';
-				uint8_t iValue = pchSource[i];
-				if ( iValue == 0 )
-				{
-					pchDest[iDestPos++] = '0';
-					pchDest[iDestPos++] = '0';
-				}
-				else
-				{
-					char cHexDigit1 = cIntToHexDigit( iValue % 16 );
-					iValue /= 16;
-					char cHexDigit2 = cIntToHexDigit( iValue );
-					pchDest[iDestPos++] = cHexDigit2;
-					pchDest[iDestPos++] = cHexDigit1;
-				}
-			}
+			if ( bWrite && unDestPos + 1 < unDestLen )
+				pchDest[ unDestPos ] = '+';
+			unDestPos += 1;
 		}
 		else
 		{
-			pchDest[iDestPos++] = pchSource[i];
+			if ( bWrite && unDestPos + 3 < unDestLen )
+			{
+				pchDest[ unDestPos ] = '%';
+				pchDest[ unDestPos + 1 ] = cIntToHexDigit( iValue >> 4 );
+				pchDest[ unDestPos + 2 ] = cIntToHexDigit( iValue & 15 );
+			}
+			unDestPos += 3;
 		}
 	}
 
-	if( (iDestPos+1) > nDestLen )
+	if ( bWrite )
 	{
-		pchDest[0] = '\0';
-		//AssertMsg( false, "Target buffer too short to terminate\n" );
-		return;
+		if ( unDestPos < unDestLen )
+		{
+			// Null terminate
+			pchDest[ unDestPos ] = 0;
+		}
+		else if ( unDestLen > 0 )
+		{
+			//AssertMsg( false, "Target buffer too short\n" );
+			pchDest[0] = '\0';
+		}
 	}
 
-	// Null terminate
-	pchDest[iDestPos++] = 0;
+	return unDestPos + 1;
 }
 
 
@@ -320,29 +813,47 @@ void V_URLEncodeInternal( char *pchDest, int nDestLen, const char *pchSource, in
 // Purpose: Internal implementation of decode, works in the strict RFC manner, or
 //          with spaces turned to + like HTML form encoding.
 //
-//			Returns the amount of space used in the output buffer.
+//			Returns the amount of space used in the output buffer. If pchDecodeDest
+//			is NULL nothing is written and the decoded size is returned. Returns 0
+//			if the output buffer is too short.
 //-----------------------------------------------------------------------------
 size_t V_URLDecodeInternal( char *pchDecodeDest, int nDecodeDestLen, const char *pchEncodedSource, int nEncodedSourceLen, bool bUsePlusForSpace )
 {
-	if ( nDecodeDestLen < nEncodedSourceLen )
-	{
-		//AssertMsg( false, "V_URLDecode needs a dest buffer at least as large as the source" );
-		return 0;
-	}
+	size_t unSourceLen = nEncodedSourceLen > 0 ? (size_t)nEncodedSourceLen : 0;
+	size_t unDestLen = ( pchDecodeDest && nDecodeDestLen > 0 ) ? (size_t)nDecodeDestLen : 0;
+	bool bWrite = pchDecodeDest != NULL;
 
-	int iDestPos = 0;
-	for( int i=0; i < nEncodedSourceLen; ++i )
+	size_t unDestPos = 0;
+	size_t i = 0;
+	while ( i < unSourceLen )
 	{
-		if ( bUsePlusForSpace && pchEncodedSource[i] == '+' )
+		size_t unRun = URLLiteralRunLength( pchEncodedSource + i, unSourceLen - i, bUsePlusForSpace );
+		if ( unRun )
 		{
-			pchDecodeDest[ iDestPos++ ] = ' ';
+			if ( bWrite )
+			{
+				if ( unDestPos + unRun > unDestLen )
+				{
+					//AssertMsg( false, "V_URLDecode dest buffer too short" );
+					return 0;
+				}
+
+				// decoding in place is allowed, so the ranges may overlap
+				memmove( pchDecodeDest + unDestPos, pchEncodedSource + i, unRun );
+			}
+			i += unRun;
+			unDestPos += unRun;
+			continue;
 		}
-		else if ( pchEncodedSource[i] == '%' )
+
+		char rchDecoded[3];
+		size_t unDecodedLen = 0;
+		if ( pchEncodedSource[i] == '%' )
 		{
 			// Percent signifies an encoded value, look ahead for the hex code, convert to numeric, and use that
 
 			// First make sure we have 2 more chars
-			if ( i < nEncodedSourceLen - 2 )
+			if ( i + 2 < unSourceLen )
 			{
 				char cHexDigit1 = pchEncodedSource[i+1];
 				char cHexDigit2 = pchEncodedSource[i+2];
@@ -351,45 +862,50 @@ size_t V_URLDecodeInternal( char *pchDecodeDest, int nDecodeDestLen, const char
 				// just place the % and the following two chars direct into the string,
 				// even though this really shouldn't happen, who knows what bad clients
 				// may do with encoding.
-				bool bValid = false;
 				int iValue = iHexCharToInt( cHexDigit1 );
-				if ( iValue != -1 )
+				int iValue2 = iHexCharToInt( cHexDigit2 );
+				if ( iValue != -1 && iValue2 != -1 )
 				{
-					iValue *= 16;
-					int iValue2 = iHexCharToInt( cHexDigit2 );
-					if ( iValue2 != -1 )
-					{
-						iValue += iValue2;
-						pchDecodeDest[ iDestPos++ ] = (char)iValue;
-						bValid = true;
-					}
+					rchDecoded[ unDecodedLen++ ] = (char)( iValue * 16 + iValue2 );
 				}
-
-				if ( !bValid )
+				else
 				{
-					pchDecodeDest[ iDestPos++ ] = '%';
-					pchDecodeDest[ iDestPos++ ] = cHexDigit1;
-					pchDecodeDest[ iDestPos++ ] = cHexDigit2;
+					rchDecoded[ unDecodedLen++ ] = '%';
+					rchDecoded[ unDecodedLen++ ] = cHexDigit1;
+					rchDecoded[ unDecodedLen++ ] = cHexDigit2;
 				}
 			}
 
 			// Skip ahead
-			i += 2;
+			i += 3;
 		}
 		else
 		{
-			pchDecodeDest[ iDestPos++ ] = pchEncodedSource[i];
+			// '+' in form encoding
+			rchDecoded[ unDecodedLen++ ] = ' ';
+			i += 1;
+		}
+
+		if ( bWrite )
+		{
+			if ( unDestPos + unDecodedLen > unDestLen )
+			{
+				//AssertMsg( false, "V_URLDecode dest buffer too short" );
+				return 0;
+			}
+			memcpy( pchDecodeDest + unDestPos, rchDecoded, unDecodedLen );
 		}
+		unDestPos += unDecodedLen;
 	}
 
 	// We may not have extra room to NULL terminate, since this can be used on raw data, but if we do
 	// go ahead and do it as this can avoid bugs.
-	if ( iDestPos < nDecodeDestLen )
+	if ( bWrite && unDestPos < unDestLen )
 	{
-		pchDecodeDest[iDestPos] = 0;
+		pchDecodeDest[ unDestPos ] = 0;
 	}
 
-	return (size_t)iDestPos;
+	return unDestPos;
 }
 
 //-----------------------------------------------------------------------------
@@ -397,9 +913,9 @@ size_t V_URLDecodeInternal( char *pchDecodeDest, int nDecodeDestLen, const char
 //          This version of the call isn't a strict RFC implementation, but uses + for space as is
 //          the standard in HTML form encoding, despite it not being part of the RFC.
 //
-//          Dest buffer should be at least as large as source buffer to guarantee room for decode.
+//          Returns the size of the buffer needed including the null terminator.
 //-----------------------------------------------------------------------------
-void V_URLEncode( char *pchDest, int nDestLen, const char *pchSource, int nSourceLen )
+size_t V_URLEncode( char *pchDest, int nDestLen, const char *pchSource, int nSourceLen )
 {
 	return V_URLEncodeInternal( pchDest, nDestLen, pchSource, nSourceLen, true );
 }
@@ -410,7 +926,6 @@ void V_URLEncode( char *pchDest, int nDestLen, const char *pchSource, int nSourc
 //          This version of the call isn't a strict RFC implementation, but uses + for space as is
 //          the standard in HTML form encoding, despite it not being part of the RFC.
 //
-//          Dest buffer should be at least as large as source buffer to guarantee room for decode.
 //			Dest buffer being the same as the source buffer (decode in-place) is explicitly allowed.
 //-----------------------------------------------------------------------------
 size_t V_URLDecode( char *pchDecodeDest, int nDecodeDestLen, const char *pchEncodedSource, int nEncodedSourceLen )
@@ -418,6 +933,32 @@ size_t V_URLDecode( char *pchDecodeDest, int nDecodeDestLen, const char *pchEnco
 	return V_URLDecodeInternal( pchDecodeDest, nDecodeDestLen, pchEncodedSource, nEncodedSourceLen, true );
 }
 
+//-----------------------------------------------------------------------------
+// Purpose: std::string versions of encode and decode. The output is sized exactly
+//          up front so each call allocates once.
+//-----------------------------------------------------------------------------
+std::string V_URLEncode( const std::string & sSource )
+{
+	std::string sEncoded;
+	size_t unSize = V_URLEncode( NULL, 0, sSource.c_str(), (int)sSource.length() );
+	sEncoded.resize( unSize );
+	V_URLEncode( &sEncoded[0], (int)unSize, sSource.c_str(), (int)sSource.length() );
+	sEncoded.resize( unSize - 1 );
+	return sEncoded;
+}
+
+std::string V_URLDecode( const std::string & sEncoded )
+{
+	std::string sDecoded;
+	size_t unSize = V_URLDecode( NULL, 0, sEncoded.c_str(), (int)sEncoded.length() );
+	if ( unSize == 0 )
+		return sDecoded;
+
+	sDecoded.resize( unSize );
+	V_URLDecode( &sDecoded[0], (int)unSize, sEncoded.c_str(), (int)sEncoded.length() );
+	return sDecoded;
+}
+
 //-----------------------------------------------------------------------------
 void V_StripExtension( std::string &in )
 {
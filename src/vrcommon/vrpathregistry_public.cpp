@@ -331,11 +331,16 @@ bool CVRPathRegistry::GetPaths( std::string *psRuntimePath, std::string *psConfi
 	bool bLoadedRegistry = pathReg.BLoadFromFile();
 	int nCountEnvironmentVariables = 0;
 
+	std::shared_ptr< const CEnvironmentSnapshot > pEnvironment = GetEnvironmentSnapshot();
+	const char *pchRuntimeOverride = pEnvironment->GetValue( k_pchRuntimeOverrideVar );
+	const char *pchConfigOverride = pEnvironment->GetValue( k_pchConfigOverrideVar );
+	const char *pchLogOverride = pEnvironment->GetValue( k_pchLogOverrideVar );
+
 	if( psRuntimePath )
 	{
-		if ( GetEnvironmentVariable( k_pchRuntimeOverrideVar ).length() != 0 )
+		if ( pchRuntimeOverride && *pchRuntimeOverride )
 		{
-			*psRuntimePath = GetEnvironmentVariable( k_pchRuntimeOverrideVar );
+			*psRuntimePath = pchRuntimeOverride;
 			nCountEnvironmentVariables++;
 		}
 		else if( !pathReg.GetRuntimePath().empty() )
@@ -350,9 +355,9 @@ bool CVRPathRegistry::GetPaths( std::string *psRuntimePath, std::string *psConfi
 
 	if( psConfigPath )
 	{
-		if ( GetEnvironmentVariable( k_pchConfigOverrideVar ).length() != 0 )
+		if ( pchConfigOverride && *pchConfigOverride )
 		{
-			*psConfigPath = GetEnvironmentVariable( k_pchConfigOverrideVar );
+			*psConfigPath = pchConfigOverride;
 			nCountEnvironmentVariables++;
 		}
 		else if( pchConfigPathOverride )
@@ -371,9 +376,9 @@ bool CVRPathRegistry::GetPaths( std::string *psRuntimePath, std::string *psConfi
 
 	if( psLogPath )
 	{
-		if ( GetEnvironmentVariable( k_pchLogOverrideVar ).length() != 0 )
+		if ( pchLogOverride && *pchLogOverride )
 		{
-			*psLogPath = GetEnvironmentVariable( k_pchLogOverrideVar );
+			*psLogPath = pchLogOverride;
 			nCountEnvironmentVariables++;
 		}
 		else if( pchLogPathOverride )